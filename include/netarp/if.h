@@ -24,19 +24,31 @@
 #include <netif/mac.h>
 #include <netipv4/ipv4.h>
 #include <netpkt/pkt.h>
+#include <netpkt/queue.h>
 #include <netstd/time.h>
 
 #include <netstd/mutex.h>
 
 #define NETARP_TABLE_SIZE 16
 
+/*
+ * Limits for packets waiting for address resolution to complete.
+ */
+#ifndef NETARP_HOLD_MAX
+#define NETARP_HOLD_MAX 4         /* Per ARP entry. */
+#endif
+#ifndef NETARP_HOLD_TOTAL_MAX
+#define NETARP_HOLD_TOTAL_MAX 32  /* Per ARP table (interface). */
+#endif
+
 typedef struct
 {
 	mac_addr_t  hard_addr;      /**< Hardware address.*/
 	ipv4_addr_t prot_addr;      /**< Protocol address.*/
-	netpkt_t    *hold;          /**< Last packet until resolved/timeout.*/
+	netpkt_queue_t hold;        /**< Packets held until resolved/timeout, oldest first.*/
 	net_time_t  cr_time;        /**< Time of entry creation.*/
 	net_time_t  hold_time;      /**< Time of the last request.*/
+	volatile net_time_t confirm_time; /**< Time of the last upper-layer reachability confirmation.*/
 	unsigned    used : 1;
 	unsigned    resolved : 1;
 } fnet_arp_entry_t;
@@ -44,6 +56,7 @@ typedef struct
 typedef struct netarp_if{
 	net_mutex_t         arp_lock;
 	fnet_arp_entry_t    arp_table[NETARP_TABLE_SIZE];   /* ARP cache table.*/
+	netpkt_queue_stats_t hold_stats;                    /* Accounting of held packets.*/
 	ipv4_addr_t         arp_probe_ipaddr;               /* ARP probe address.*/
 } netarp_if_t;
 
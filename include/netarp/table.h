@@ -35,10 +35,20 @@ netpkt_t *netarp_tab_update( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t h
  * If the found ARP entry is un-resolved, it enqueues the packet.
  * If no entry is found, it creates an new ARP entry and enqueues the packet.
  *
+ * 'pkt' may be a chain of packets (linked by next_chain); it is enqueued as a whole.
+ *
  * Return:     0 = No mac-address resolved; packet enqueued.
  *         non-0 = mac-address resolved; packet not enqueued.
  */
 int netarp_tab_lookup( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t *hard_addr, netpkt_t *pkt);
 
+/*
+ * Upper-layer reachability confirmation. Marks the resolved ARP entry as
+ * recently used, so that it is not preempted by new entries.
+ *
+ * Lock-free.
+ */
+void netarp_confirm_reachable( netif_t *netif, ipv4_addr_t prot_addr);
+
 #endif
 
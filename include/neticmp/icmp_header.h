@@ -83,6 +83,17 @@ typedef struct NETSTD_PACKED
     uint16_t  checksum ;  /* The checksum of the message.*/
 } fnet_icmp_header_t;
 
+/**************************************************************************/ /*!
+ * @internal
+ * @brief    ICMP error message header. It is followed by the IP header and
+ *           the leading data of the original datagram.
+ ******************************************************************************/
+typedef struct NETSTD_PACKED
+{
+    fnet_icmp_header_t  header ;  /* Type, code and checksum.*/
+    uint32_t            data   ;  /* Unused, or the next-hop MTU (RFC 1191) or pointer.*/
+} fnet_icmp_err_header_t;
+
 
 #endif
 
@@ -24,5 +24,14 @@
 
 void neticmp_output(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr);
 
+/*
+ * Sends an ICMP error message back to the source of 'pkt'. The current level
+ * of 'pkt' is the payload; the level below is the IP header. 'src_addr' and
+ * 'dst_addr' are the addresses of the original datagram; 'dst_addr' becomes
+ * the source of the error message. 'param' fills the 32-bit field after the
+ * checksum.
+ */
+void neticmp_error(netif_t *nif,netpkt_t *pkt,uint32_t protocol, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr,uint8_t type,uint8_t code,uint32_t param);
+
 #endif
 
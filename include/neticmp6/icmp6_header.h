@@ -35,6 +35,9 @@
 #define FNET_ICMP6_TYPE_MULTICAST_LISTENER_REPORT   (131u)   /* Multicast Listener Report */
 #define FNET_ICMP6_TYPE_MULTICAST_LISTENER_DONE     (132u)   /* Multicast Listener Done */
 
+/* MLDv2 messages (RFC3810):*/
+#define FNET_ICMP6_TYPE_MULTICAST_LISTENER_REPORT_V2 (143u)  /* Version 2 Multicast Listener Report */
+
 /*  Neighbor Discovery defines five different ICMP packet types (RFC4861):*/
 #define FNET_ICMP6_TYPE_ROUTER_SOLICITATION         (133u)   /* Router Solicitation. */
 #define FNET_ICMP6_TYPE_ROUTER_ADVERTISEMENT        (134u)   /* Router Advertisement. */
@@ -0,0 +1,100 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIF_ADDRCLASS_H_
+#define _NETIF_ADDRCLASS_H_
+
+#include <netif/if.h>
+#include <netipv4/ipv4.h>
+#include <netipv6/ipv6.h>
+#include <netstd/mutex.h>
+
+/*
+ * Number of slots in the classification table. Must be a power of two.
+ *
+ * The table is kept at most half full, so it holds up to
+ * (NETIF_ADDRCLASS_SIZE/2) addresses.
+ */
+#ifndef NETIF_ADDRCLASS_SIZE
+#define NETIF_ADDRCLASS_SIZE 256
+#endif
+
+/*
+ * Address classes. An address may be in multiple classes.
+ */
+#define NETIF_ADDRCLASS_LOCAL      0x01  /* Local unicast address. */
+#define NETIF_ADDRCLASS_SOLICITED  0x02  /* Solicited-node multicast of a local IPv6 address. */
+#define NETIF_ADDRCLASS_MULTICAST  0x04  /* Joined multicast group. */
+#define NETIF_ADDRCLASS_BROADCAST  0x08  /* IPv4 broadcast address. */
+
+/*
+ * Returned by a lookup, that missed, if the table overflowed on the last
+ * rebuild: The address may still be in any class, and must be checked
+ * against the interface configuration.
+ */
+#define NETIF_ADDRCLASS_OVERFLOW   0x80
+
+typedef struct netif_addrclass_entry{
+	ipv6_addr_t  addr;   /* IPv4 addresses are stored as IPv4-mapped IPv6 addresses. */
+	uint8_t      klass;  /* Address classes; 0 = unused slot. */
+} netif_addrclass_entry_t;
+
+/*
+ * Per-interface precomputed address classification table.
+ *
+ * The table is rebuilt from the interface configuration with
+ * netif_addrclass_rebuild(), which must be called after every configuration
+ * change (IPv4 address, IPv6 address bind/unbind, multicast join/leave).
+ *
+ * Lookups are lock-free (seqlock); rebuilds are serialized by 'lock'.
+ *
+ * The table holds up to (NETIF_ADDRCLASS_SIZE/2) addresses. If there are more,
+ * the rebuild skips the rest and sets 'overflow'. The local IPv6 addresses and
+ * their solicited-node groups are added first, so that they always fit.
+ */
+typedef struct netif_addrclass{
+	net_mutex_t              lock;
+	volatile uint32_t        seq;       /* Odd while a rebuild is in progress. */
+	uint8_t                  overflow;  /* Not all addresses fit into the table. */
+	netif_addrclass_entry_t  table[NETIF_ADDRCLASS_SIZE];
+} netif_addrclass_t;
+
+/*
+ * Rebuilds the classification table of the interface, if any.
+ */
+void netif_addrclass_rebuild(netif_t *nif);
+
+/*
+ * Returns the classes of the IPv6 address 'addr' on the interface. If it is
+ * not found, and the table has overflowed, NETIF_ADDRCLASS_OVERFLOW is
+ * returned.
+ *
+ * The interface must have a classification table (nif->addrclass).
+ */
+int netif_addrclass_get6(netif_t *nif, const ipv6_addr_t *addr);
+
+/*
+ * Returns the classes of the IPv4 address 'addr' on the interface. If it is
+ * not found, and the table has overflowed, NETIF_ADDRCLASS_OVERFLOW is
+ * returned.
+ *
+ * The interface must have a classification table (nif->addrclass).
+ */
+int netif_addrclass_get4(netif_t *nif, ipv4_addr_t addr);
+
+#endif
+
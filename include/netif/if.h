@@ -22,19 +22,46 @@
 #include <netipv4/ipv4.h>
 #include <netif/mac.h>
 #include <netif/hwaddr.h>
+#include <netstd/packing.h>
 
 #define NETIF_IS_LOOPBACK 0x01
 
+/*
+ * Forward IP packets, that are received on this interface but not addressed
+ * to us (router mode).
+ */
+#define NETIF_FORWARDING  0x02
+
+/*
+ * The interface segments UDP datagrams itself (see netpkt_t.gso_size).
+ */
+#define NETIF_GSO_UDP     0x04
+
 struct netif_api;
+struct netipv4_if;
 struct netipv6_if;
 struct netarp_if;
 struct netnd6_if;
 struct netsock_ht;
+struct nettcp_if;
+struct netif_addrclass;
 
 #define NETIPV4_ID_TAB_SIZE 0x1000
 #define NETIPV4_ID_TAB_MASK 0x0FFF
+
+/*
+ * IPv4 ID generator state (RFC 7739 4.3). Must be initialized with
+ * netipv4_id_init().
+ */
 struct netipv4_idt{
-	volatile uint32_t table[NETIPV4_ID_TAB_SIZE];
+	uint32_t          key[4]; /* Secret key of the hash (SipHash). */
+	
+	/*
+	 * Counters, incremented with atomic fetch-add. The table starts on its own
+	 * cache line, so that the counters don't share a line with the keys or
+	 * other data.
+	 */
+	volatile uint32_t table[NETIPV4_ID_TAB_SIZE] NETSTD_ALIGNED(NETSTD_CACHELINE);
 };
 
 typedef const struct netif_api* netif_api_v;
@@ -57,6 +84,9 @@ typedef struct netif{
 	}ipv4;
 	struct netipv4_idt* ipv4_id;
 	
+	/* Optional: Additional IPv4 addresses and secondary subnets. */
+	struct netipv4_if  *ipv4_addrs;
+	
 	struct netipv6_if *ipv6;
 	
 	struct netarp_if  *arp;
@@ -65,6 +95,12 @@ typedef struct netif{
 	
 	struct netsock_ht *sockets;
 	
+	/* Optional: TCP connections; without it, TCP is not available. */
+	struct nettcp_if  *tcp;
+	
+	/* Optional: Precomputed address classification table. */
+	struct netif_addrclass *addrclass;
+	
 	/* Device specific. */
 	mac_addr_t device_mac;
 	hwaddr_t   device_addr;
@@ -26,6 +26,7 @@ struct netif_api{
 	void (*ifapi_send_l2)(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t protocol);
 	void (*ifapi_send_l2_all)(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t protocol);
 	void (*ifapi_send_l3_ipv4)(netif_t* nif,netpkt_t* pkt,void* addr);
+	void (*ifapi_send_l3_ipv4_all)(netif_t* nif,netpkt_t* pkt,void* addr);
 	void (*ifapi_send_l3_ipv6)(netif_t* nif,netpkt_t* pkt,void* srcaddr,void* addr);
 	void (*ifapi_send_l3_ipv6_all)(netif_t* nif,netpkt_t* pkt,void* srcaddr,void* addr);
 };
@@ -58,6 +59,16 @@ void netif_send_l2_all(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t prot
  */
 void netif_api_send_l3_ipv4(netif_t* nif,netpkt_t* pkt,void* addr);
 
+/**
+ * @brief Default implementation of netif_api->ifapi_send_l3_ipv4_all.
+ * @param nif   netif-instance
+ * @param pkt   network packet
+ * @param pkt   destination IPv4-address (Pointer)
+ *
+ * This function sends an entire chain of packets at once.
+ */
+void netif_api_send_l3_ipv4_all(netif_t* nif,netpkt_t* pkt,void* addr);
+
 /**
  * @brief Default implementation of netif_api->ifapi_send_l3_ipv6.
  * @param nif   netif-instance
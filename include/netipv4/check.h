@@ -24,5 +24,11 @@
 int netipv4_addr_is_broadcast(netif_t *nif,ipv4_addr_t addr);
 int netipv4_addr_is_onlink(netif_t *nif,ipv4_addr_t addr);
 
+/*
+ * Returns the address classes (NETIF_ADDRCLASS_LOCAL, NETIF_ADDRCLASS_BROADCAST)
+ * of the given address on the interface.
+ */
+int netipv4_addr_classify(netif_t *nif,ipv4_addr_t addr);
+
 #endif
 
@@ -0,0 +1,55 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV4_CTRL_H_
+#define _NETIPV4_CTRL_H_
+
+#include <netif/if.h>
+#include <netipv4/ipv4.h>
+
+/*
+ * Binds an additional IPv4 address to the interface. Requires
+ * netif_t.ipv4_addrs.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv4_bind_addr_prv(netif_t *nif, ipv4_addr_t addr, ipv4_addr_t subnetmask);
+
+/*
+ * Unbinds an additional IPv4 address from the interface.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv4_unbind_addr_prv(netif_t *nif, ipv4_addr_t addr);
+
+/*
+ * Returns non-0, if the address is one of the interface's IPv4 addresses.
+ */
+int netipv4_addr_is_own(netif_t *nif, ipv4_addr_t addr);
+
+/*
+ * Selects the source address to use with a destination address: An address
+ * in the subnet of the destination, or the primary address.
+ */
+ipv4_addr_t netipv4_select_src_addr(netif_t *nif, ipv4_addr_t dest);
+
+/*
+ * Returns non-0, if the address is in one of the secondary subnets.
+ * If 'broadcast' is non-0, only matches the subnet's broadcast addresses.
+ */
+int netipv4_addr_in_subnets(netif_t *nif, ipv4_addr_t addr, int broadcast);
+
+#endif
+
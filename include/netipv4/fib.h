@@ -0,0 +1,151 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV4_FIB_H_
+#define _NETIPV4_FIB_H_
+
+#include <netif/if.h>
+#include <netipv4/ipv4.h>
+#include <netstd/mutex.h>
+
+/*
+ * Upper limit of routes in the FIB.
+ */
+#ifndef NETIPV4_FIB_ROUTE_MAX
+#define NETIPV4_FIB_ROUTE_MAX 4096
+#endif
+
+/*
+ * Number of slots in the route hash table. A power of two, at least twice
+ * NETIPV4_FIB_ROUTE_MAX.
+ */
+#ifndef NETIPV4_FIB_ROUTE_TAB
+#define NETIPV4_FIB_ROUTE_TAB 8192
+#endif
+
+/*
+ * Upper limit of distinct next hops (interface, gateway). At most 0x7fff.
+ */
+#ifndef NETIPV4_FIB_NH_MAX
+#define NETIPV4_FIB_NH_MAX 256
+#endif
+
+/*
+ * Number of 256-entry second-level tables (for prefixes longer than /24).
+ * At most 0x7fff.
+ */
+#ifndef NETIPV4_FIB_TBL8_MAX
+#define NETIPV4_FIB_TBL8_MAX 1024
+#endif
+
+typedef struct netipv4_fib_nh{
+	netif_t      *nif;
+	ipv4_addr_t   gateway;  /* 0.0.0.0 = directly connected. */
+	uint32_t      refc;     /* Number of routes using this next hop; 0 = unused. */
+} netipv4_fib_nh_t;
+
+typedef struct netipv4_fib_route{
+	ipv4_addr_t   prefix;
+	uint8_t       length;
+	uint8_t       used;
+	uint16_t      nh;       /* Index into 'nexthops'. */
+} netipv4_fib_route_t;
+
+/*
+ * IPv4 Forwarding Information Base.
+ *
+ * The longest prefix match is done with a DIR-24-8 table: the first 24 bits
+ * of the destination index 'tbl24'. An entry holds either a next hop index
+ * or (with the top bit set) the index of a 'tbl8' group, which is indexed by
+ * the last 8 bits. Every lookup takes one or two memory accesses.
+ *
+ * The routes themselves are kept in a hash table, keyed by prefix and
+ * length. 'depth24' and 'depth8' record the prefix length of every entry,
+ * and are only used by updates.
+ *
+ * Lookups are lock-free: they retry, if 'seq' has changed (seqlock). Updates
+ * are serialized by 'lock'.
+ */
+typedef struct netipv4_fib{
+	net_mutex_t           lock;
+	volatile uint32_t     seq;      /* Odd while an update is in progress. */
+	uint32_t              count;    /* Number of routes. */
+	
+	uint16_t             *tbl24;    /* 1<<24 entries. */
+	uint16_t             *tbl8;     /* NETIPV4_FIB_TBL8_MAX*256 entries. */
+	uint8_t              *depth24;
+	uint8_t              *depth8;
+	uint8_t               tbl8_used[NETIPV4_FIB_TBL8_MAX];
+	
+	netipv4_fib_nh_t      nexthops[NETIPV4_FIB_NH_MAX];
+	netipv4_fib_route_t   routes[NETIPV4_FIB_ROUTE_TAB];
+} netipv4_fib_t;
+
+/*
+ * The global FIB. If not NULL, netipv4_output() uses it to select the
+ * interface for packets without one.
+ */
+extern netipv4_fib_t *netipv4_fib;
+
+/*
+ * Allocates the tables of a FIB. 'fib->lock' must be initialized by the
+ * caller.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv4_fib_init(netipv4_fib_t *fib);
+
+/*
+ * Frees the tables of a FIB.
+ */
+void netipv4_fib_destroy(netipv4_fib_t *fib);
+
+/*
+ * Adds or replaces the route 'prefix'/'length' via 'nif'. If 'gateway' is
+ * 0.0.0.0, the destinations are directly connected.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv4_fib_add(netipv4_fib_t *fib, ipv4_addr_t prefix, uint8_t length, netif_t *nif, ipv4_addr_t gateway);
+
+/*
+ * Removes the route 'prefix'/'length'.
+ * Return 0 on success, non-0 if there is no such route.
+ */
+int netipv4_fib_del(netipv4_fib_t *fib, ipv4_addr_t prefix, uint8_t length);
+
+/*
+ * Removes all routes via 'nif', eg. when the interface goes down.
+ */
+void netipv4_fib_flush_if(netipv4_fib_t *fib, netif_t *nif);
+
+/*
+ * Looks up the longest prefix match for 'dst'. On success, stores the
+ * interface in '*nif' and the next hop (the gateway, or 'dst' itself, if
+ * directly connected) in '*nexthop'.
+ * Return 0 on success, non-0 if there is no route.
+ */
+int netipv4_fib_lookup(netipv4_fib_t *fib, ipv4_addr_t dst, netif_t **nif, ipv4_addr_t *nexthop);
+
+/*
+ * Selects the next hop for 'dst', as netipv4_output() does: If '*nif' is NULL,
+ * the global FIB selects the interface. Otherwise, on-link destinations are
+ * sent directly, and others over the FIB's gateway (if the route points at
+ * '*nif') or the interface's default gateway.
+ * Return 0 on success, non-0 if there is no route.
+ */
+int netipv4_route(netif_t **nif, ipv4_addr_t dst, ipv4_addr_t *nexthop, int do_not_route);
+
+#endif
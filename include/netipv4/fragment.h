@@ -0,0 +1,37 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV4_FRAGMENT_H_
+#define _NETIPV4_FRAGMENT_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+#include <netipv4/ipv4.h>
+
+/*
+ * Splits an IPv4 datagram, that exceeds the MTU of 'nif', into fragments
+ * (RFC 791 3.2), and sends them to 'nexthop' as one chain. The current level
+ * of 'pkt' is the IPv4 header, which must be complete; the DF flag must be
+ * clear. Fragments of fragments are supported.
+ *
+ * Consumes the packet. If a fragment can't be allocated, the datagram is
+ * dropped as a whole.
+ */
+void netipv4_fragment(netif_t *nif, netpkt_t *pkt, ipv4_addr_t *nexthop);
+
+#endif
+
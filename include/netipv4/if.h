@@ -0,0 +1,74 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV4_IF_H_
+#define _NETIPV4_IF_H_
+
+#include <netipv4/ipv4.h>
+#include <netstd/mutex.h>
+
+/*
+ * Upper limit of additional IPv4 addresses per interface.
+ */
+#ifndef NETIPV4_IF_ADDR_MAX
+#define NETIPV4_IF_ADDR_MAX 256
+#endif
+
+/*
+ * Upper limit of distinct subnets of the additional addresses.
+ */
+#ifndef NETIPV4_IF_SUBNET_MAX
+#define NETIPV4_IF_SUBNET_MAX 16
+#endif
+
+/*
+ * Number of slots in the address hash table. A power of two, at least twice
+ * NETIPV4_IF_ADDR_MAX, so that the table is at most half full.
+ */
+#define NETIPV4_IF_ADDR_TAB 512
+
+typedef struct netipv4_if_addr{
+	ipv4_addr_t   address;  /* IPv4 address. */
+	uint8_t       subnet;   /* Index into 'subnets'. */
+	uint8_t       used;     /* Slot in use? */
+} netipv4_if_addr_t;
+
+typedef struct netipv4_if_subnet{
+	ipv4_addr_t   subnet;           /* Network address. */
+	ipv4_addr_t   subnetmask;
+	ipv4_addr_t   subnetbroadcast;  /* Directed broadcast address. */
+	ipv4_addr_t   address;          /* Source address for destinations in this subnet. */
+	uint32_t      refc;             /* Number of addresses in this subnet; 0 = unused. */
+} netipv4_if_subnet_t;
+
+/*
+ * Additional IPv4 addresses (and secondary subnets) of an interface, besides
+ * the primary address in netif_t.ipv4.
+ *
+ * The addresses are kept in an open-addressing hash table (linear probing).
+ * Lookups are lock-free (seqlock); updates are serialized by 'lock'.
+ */
+typedef struct netipv4_if{
+	net_mutex_t           lock;
+	volatile uint32_t     seq;      /* Odd while an update is in progress. */
+	uint32_t              count;    /* Number of addresses. */
+	netipv4_if_subnet_t   subnets[NETIPV4_IF_SUBNET_MAX];
+	netipv4_if_addr_t     table[NETIPV4_IF_ADDR_TAB];
+} netipv4_if_t;
+
+#endif
+
@@ -21,6 +21,11 @@
 #include <netipv4/ipv4.h>
 #include <netif/if.h>
 
+/*
+ * Initializes the ID generator state with random keys and counters.
+ */
+void netipv4_id_init(struct netipv4_idt *idt);
+
 /*
  * Returns the next value for the ID field.
  */
@@ -37,7 +37,7 @@ int netipv6_addr_is_own_ip6_solicited_multicast(netif_t *nif, ipv6_addr_t *addr)
 
 /*
  * Selects the best source address to use with a destination address.
- * Just enough to implement Neighbor Solicitation Message.
+ * See netipv6_select_src_addr().
  */
 int netipv6_select_src_addr_nsol(netif_t *nif, ipv6_addr_t *src, const ipv6_addr_t *dest);
 
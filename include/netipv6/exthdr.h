@@ -23,6 +23,32 @@
 #include <netif/if.h>
 #include <netpkt/pkt.h>
 
+/*
+ * Upper limit of extension headers in a packet.
+ */
+#ifndef NETIPV6_EXT_MAX_HEADERS
+#define NETIPV6_EXT_MAX_HEADERS 8
+#endif
+
+/*
+ * Upper limit of the total length of all extension headers in a packet, in octets.
+ */
+#ifndef NETIPV6_EXT_MAX_BYTES
+#define NETIPV6_EXT_MAX_BYTES 1024
+#endif
+
+extern const uint8_t netipv6_ext_class[256];
+
+/*
+ * Returns non-0, if 'next_header' is an extension header, that is processed
+ * by netipv6_ext_header_process(). 0 is returned for upper-layer protocols.
+ */
+#define NETIPV6_EXT_IS_HEADER(next_header) (netipv6_ext_class[(uint8_t)(next_header)] != 0)
+
+/*
+ * Processes the extension header chain. On return, *pnext_header holds the
+ * upper-layer protocol. If the packet has been dropped, *ppkt is set to NULL.
+ */
 void netipv6_ext_header_process(netif_t *netif, uint8_t *pnext_header, ipv6_addr_t *src, ipv6_addr_t *dst, netpkt_t **ppkt);
 
 #endif
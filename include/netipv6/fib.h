@@ -0,0 +1,152 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV6_FIB_H_
+#define _NETIPV6_FIB_H_
+
+#include <netif/if.h>
+#include <netipv6/ipv6.h>
+#include <netstd/mutex.h>
+
+/*
+ * Upper limit of trie nodes. Every node covers 4 bits of the address.
+ */
+#ifndef NETIPV6_FIB_NODE_MAX
+#define NETIPV6_FIB_NODE_MAX 16384
+#endif
+
+/*
+ * Upper limit of routes (result slots). At most 0xffff.
+ */
+#ifndef NETIPV6_FIB_RESULT_MAX
+#define NETIPV6_FIB_RESULT_MAX 16384
+#endif
+
+/*
+ * Upper limit of distinct next hops (interface, gateway). At most 0xffff.
+ */
+#ifndef NETIPV6_FIB_NH_MAX
+#define NETIPV6_FIB_NH_MAX 256
+#endif
+
+typedef struct netipv6_fib_nh{
+	netif_t      *nif;
+	ipv6_addr_t   gateway;  /* :: = directly connected. */
+	uint32_t      refc;     /* Number of routes using this next hop; 0 = unused. */
+} netipv6_fib_nh_t;
+
+/*
+ * A tree bitmap node, with a stride of 4 bits.
+ *
+ * 'internal' has one bit for every prefix of length 0 to 3 (relative to the
+ * node), that ends within this node: the prefix of length l and value v is
+ * bit (1<<l)-1+v. 'external' has one bit for every of the 16 child nodes.
+ * The children, and the next hops of the prefixes, are stored contiguously,
+ * so that the position of an entry is the number of bits set before it.
+ */
+typedef struct netipv6_fib_node{
+	uint16_t   internal;
+	uint16_t   external;
+	uint32_t   child_base;   /* Index of the first child in 'nodes'. */
+	uint32_t   result_base;  /* Index of the first next hop in 'results'. */
+} netipv6_fib_node_t;
+
+/*
+ * IPv6 Forwarding Information Base.
+ *
+ * The longest prefix match is done with a tree bitmap, rooted at nodes[0].
+ * The nodes are small (12 bytes), so a lookup touches few cache lines.
+ *
+ * Child and result blocks are allocated from fixed pools, with a free list
+ * per block size. As the pools never move, a lookup never leaves them, even
+ * if it races with an update.
+ *
+ * Lookups are lock-free: they retry, if 'seq' has changed (seqlock). Updates
+ * are serialized by 'lock'.
+ */
+typedef struct netipv6_fib{
+	net_mutex_t           lock;
+	volatile uint32_t     seq;      /* Odd while an update is in progress. */
+	uint32_t              count;    /* Number of routes. */
+	
+	netipv6_fib_node_t   *nodes;
+	uint16_t             *results;  /* Next hop indices. */
+	uint32_t              node_top;
+	uint32_t              result_top;
+	uint32_t              node_free[17];   /* Free child blocks, by size. */
+	uint32_t              result_free[16]; /* Free result blocks, by size. */
+	
+	netipv6_fib_nh_t      nexthops[NETIPV6_FIB_NH_MAX];
+} netipv6_fib_t;
+
+/*
+ * The global FIB. If not NULL, netipv6_route() uses it to select the
+ * interface for packets without one, and the next hop for off-link
+ * destinations. The next hop is passed down to the neighbor resolution.
+ */
+extern netipv6_fib_t *netipv6_fib;
+
+/*
+ * Allocates the tables of a FIB. 'fib->lock' must be initialized by the
+ * caller.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv6_fib_init(netipv6_fib_t *fib);
+
+/*
+ * Frees the tables of a FIB.
+ */
+void netipv6_fib_destroy(netipv6_fib_t *fib);
+
+/*
+ * Adds or replaces the route 'prefix'/'length' via 'nif'. If 'gateway' is
+ * NULL or ::, the destinations are directly connected.
+ * Return 0 on success, non-0 on error.
+ */
+int netipv6_fib_add(netipv6_fib_t *fib, const ipv6_addr_t *prefix, uint8_t length, netif_t *nif, const ipv6_addr_t *gateway);
+
+/*
+ * Removes the route 'prefix'/'length'.
+ * Return 0 on success, non-0 if there is no such route.
+ */
+int netipv6_fib_del(netipv6_fib_t *fib, const ipv6_addr_t *prefix, uint8_t length);
+
+/*
+ * Removes all routes via 'nif', eg. when the interface goes down.
+ */
+void netipv6_fib_flush_if(netipv6_fib_t *fib, netif_t *nif);
+
+/*
+ * Looks up the longest prefix match for 'dst'. On success, stores the
+ * interface in '*nif' and the next hop (the gateway, or 'dst' itself, if
+ * directly connected) in '*nexthop'.
+ * Return 0 on success, non-0 if there is no route.
+ */
+int netipv6_fib_lookup(netipv6_fib_t *fib, const ipv6_addr_t *dst, netif_t **nif, ipv6_addr_t *nexthop);
+
+/*
+ * Selects the next hop for 'dst', as netipv6_output() does: If '*nif' is NULL,
+ * the global FIB selects the interface. Otherwise, the FIB's next hop is used,
+ * if the route points at '*nif'.
+ *
+ * Return 1, if the next hop was taken from the FIB, and is on-link. Return 0,
+ * if the next hop is 'dst', and the neighbor resolution decides whether it is
+ * on-link or sent to a default router. Return -1, if there is no route.
+ */
+int netipv6_route(netif_t **nif, const ipv6_addr_t *dst, ipv6_addr_t *nexthop);
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV6_FORWARD_H_
+#define _NETIPV6_FORWARD_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+
+/*
+ * Forwards an IPv6 packet, that has been received on 'netif' but is not
+ * addressed to us. The current level of 'pkt' is the IPv6 header.
+ *
+ * The outgoing interface and the next hop are looked up in the global FIB.
+ * The packet is sent without being copied.
+ */
+void netipv6_forward(netif_t *netif, netpkt_t *pkt);
+
+#endif
+
@@ -23,15 +23,30 @@
 
 #include <netipv6/ipv6.h>
 #include <netstd/time.h>
+#include <netstd/mutex.h>
 
 #define NETIPV6_IF_ADDR_MAX 8
 
 /*
- * NETIPV6_IF_MULTCAST_MAX must be greater than NETIPV6_IF_ADDR_MAX.
- * 
- * NETIPV6_IF_MULTCAST_MAX = (2x NETIPV6_IF_ADDR_MAX) + c
+ * Upper limit of joined multicast groups per interface.
+ *
+ * NETIPV6_IF_MULTCAST_MAX must be greater than NETIPV6_IF_ADDR_MAX, as every
+ * address joins its Solicited-node multicast group.
  */
-#define NETIPV6_IF_MULTCAST_MAX 20
+#ifndef NETIPV6_IF_MULTCAST_MAX
+#define NETIPV6_IF_MULTCAST_MAX 4096
+#endif
+
+/*
+ * Initial size of the multicast group table. Must be a power of two.
+ */
+#define NETIPV6_IF_MULTCAST_MIN 16
+
+/*
+ * Size of the Bloom filter in front of the multicast group table, in bits.
+ * Must be a power of two.
+ */
+#define NETIPV6_IF_MULTCAST_BLOOM 1024
 
 /**************************************************************************/ /*!
  * @brief Possible IPv6 address states.
@@ -46,11 +61,15 @@ typedef enum
                                                  * tentative address, but accepts Neighbor Discovery packets related
                                                  * to Duplicate Address Detection for the tentative address.
                                                  */
-    FNET_NETIF_IP6_ADDR_STATE_PREFERRED = 1 	/**< @brief Preferred address - (RFC4862) an address assigned to an interface whose use by
+    FNET_NETIF_IP6_ADDR_STATE_PREFERRED = 1, 	/**< @brief Preferred address - (RFC4862) an address assigned to an interface whose use by
                                                  * upper-layer protocols is unrestricted. Preferred addresses may be
                                                  * used as the source (or destination) address of packets sent from
                                                  * (or to) the interface.
                                                  */
+    FNET_NETIF_IP6_ADDR_STATE_DEPRECATED = 2    /**< @brief Deprecated address - (RFC4862) an address assigned to an interface whose use is
+                                                 * discouraged, but not forbidden. A deprecated address should no longer be
+                                                 * used as a source address in new communications.
+                                                 */
 } fnet_netif_ip6_addr_state_t;
 
 /**************************************************************************/ /*!
@@ -79,22 +98,81 @@ typedef struct netipv6_if_addr
 	                                          * of NS transmits till DAD is finished.*/
 	net_time_t    state_time;                /* Time of last state event.*/
 	unsigned      type  : 2;                 /* How the address was acquired. */
-	unsigned      state : 1;                 /* Address current state. (fnet_netif_ip6_addr_state_t)*/
+	unsigned      state : 2;                 /* Address current state. (fnet_netif_ip6_addr_state_t)*/
 	unsigned      used : 1;                  /* Is the entry in use? */
 
 } netipv6_if_addr_t;
 
+/*
+ * MLDv2 Robustness Variable (RFC3810 9.1). State-Change Reports are
+ * transmitted this many times.
+ */
+#define NETIPV6_IF_MLD_ROBUSTNESS 2
+
 typedef struct netipv6_if_multicast{
 	ipv6_addr_t   multicast;    /* IPv6 address. */
-	unsigned      refc : 29;    /* Usage counter. */
+	net_time_t    report_time;  /* Time of the pending Current-State Report (if 'pending'). */
+	unsigned      refc : 26;    /* Usage counter. */
+	unsigned      rexmit : 2;   /* Remaining State-Change Report transmissions. */
 	unsigned      used : 1;     /* Entry in use? */
 	unsigned      reported : 1; /* MLD-Report sent? */
 	unsigned      mlddone : 1;  /* MLD-Done sent? */
+	unsigned      pending : 1;  /* Current-State Report pending (Group-Specific Query)? */
 } netipv6_if_multicast_t;
 
+/*
+ * Multicast group table. An open-addressing hash table (linear probing),
+ * that grows and shrinks with the number of joined groups.
+ */
+typedef struct netipv6_if_mcast_tab{
+	netipv6_if_multicast_t   *entries;   /* Hash table slots. */
+	uint32_t                 size;       /* Number of slots; 0 or a power of two. */
+	uint32_t                 count;      /* Number of used slots. */
+	
+	/* Bloom filter for a fast, lock-free reject on receive. */
+	volatile uint32_t        bloom[NETIPV6_IF_MULTCAST_BLOOM/32];
+} netipv6_if_mcast_tab_t;
+
+/*
+ * Size of the source address selection cache. Must be a power of two.
+ */
+#ifndef NETIPV6_IF_SRCSEL_CACHE_SIZE
+#define NETIPV6_IF_SRCSEL_CACHE_SIZE 64
+#endif
+
+typedef struct netipv6_if_srcsel_entry{
+	ipv6_addr_t   destination;  /* Destination address. */
+	ipv6_addr_t   source;       /* Selected source address. */
+	uint32_t      gen;          /* Value of 'addr_gen', the entry has been computed with. */
+	unsigned      used : 1;     /* Entry in use? */
+} netipv6_if_srcsel_entry_t;
+
+/*
+ * Source address selection cache (RFC 6724). A direct-mapped cache, protected
+ * by a seqlock, so that lookups don't need to take the lock.
+ *
+ * Entries are invalidated implicitly, by incrementing 'addr_gen', whenever an
+ * address is bound, unbound or changes its state.
+ */
+typedef struct netipv6_if_srcsel_cache{
+	net_mutex_t                 lock;       /* Serializes the writers. */
+	volatile uint32_t           seq;        /* Odd while an entry is being written. */
+	volatile uint32_t           addr_gen;   /* Address generation. */
+	netipv6_if_srcsel_entry_t   entries[NETIPV6_IF_SRCSEL_CACHE_SIZE];
+} netipv6_if_srcsel_cache_t;
+
 typedef struct netipv6_if {
 	netipv6_if_addr_t        addrs[NETIPV6_IF_ADDR_MAX];
-	netipv6_if_multicast_t   multicasts[NETIPV6_IF_MULTCAST_MAX];
+	net_mutex_t              mcast_lock;   /* Protects 'multicasts' and the MLD state. */
+	netipv6_if_mcast_tab_t   multicasts;
+	
+	/* MLDv2 listener state. */
+	net_time_t               mld_general_time;         /* Time of the pending response to a General Query. */
+	net_time_t               mld_change_time;          /* Time of the next State-Change Report. */
+	unsigned                 mld_general_pending : 1;  /* Response to a General Query pending? */
+	unsigned                 mld_change_pending : 1;   /* State-Change Report pending? */
+	
+	netipv6_if_srcsel_cache_t srcsel;
 	uint8_t                  hop_limit;
 	size_t                   pmtu;
 	unsigned                 disabled : 1; /* < IPv6 is Disabled*/
@@ -127,6 +127,58 @@ typedef struct NETSTD_PACKED
                                    * including the first 8 octets. */
 } netipv6_ext_generic_t;
 
+/***********************************************************************
+ * Routing Header (RFC 8200 4.4)
+ ***********************************************************************
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |  Next Header  |  Hdr Ext Len  |  Routing Type | Segments Left |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                                                               |
+ * .                                                               .
+ * .                       type-specific data                      .
+ * .                                                               .
+ * |                                                               |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ ***********************************************************************/
+typedef struct NETSTD_PACKED
+{
+    uint8_t   next_header     ;   /* Identifies the type of header immediately
+                                   * following the Routing header. */
+    uint8_t   hdr_ext_length  ;   /* Length of the Routing header in 8-octet units,
+                                   * not including the first 8 octets. */
+    uint8_t   routing_type    ;   /* Identifier of a particular Routing header variant. */
+    uint8_t   segments_left   ;   /* Number of route segments remaining. */
+} fnet_ip6_routing_header_t;
+
+#define FNET_IP6_ROUTING_TYPE_SRH   (4u)   /* RFC 8754: Segment Routing Header. */
+
+/***********************************************************************
+ * Segment Routing Header (RFC 8754 2)
+ ***********************************************************************
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Next Header   |  Hdr Ext Len  | Routing Type  | Segments Left |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |  Last Entry   |     Flags     |              Tag              |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                                                               |
+ * |            Segment List[0] (128-bit IPv6 address)             |
+ * |                                                               |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * .                              ...                              .
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |            Segment List[n] (128-bit IPv6 address)             |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * //         Optional Type Length Value objects (variable)       //
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ ***********************************************************************/
+typedef struct NETSTD_PACKED
+{
+    fnet_ip6_routing_header_t  routing_header;
+    uint8_t                    last_entry;   /* Index of the last element of the Segment List. */
+    uint8_t                    flags;
+    uint16_t                   tag;
+} fnet_ip6_srh_t;                            /* Followed by the Segment List. */
+
 /***********************************************************************
  * Options (used in op-by-Hop Options Header & Destination Options Header)
  ***********************************************************************
@@ -149,6 +201,8 @@ typedef struct NETSTD_PACKED
                                              * into the Options area of a header. For N octets of padding, the
                                              * Opt Data Len field contains the value N-2, and the Option Data
                                              * consists of N-2 zero-valued octets. */
+#define FNET_IP6_OPTION_TYPE_ROUTER_ALERT (0x05u) /* RFC 2711: Router Alert option. */
+#define FNET_IP6_OPTION_TYPE_JUMBO        (0xC2u) /* RFC 2675: Jumbo Payload option. Alignment 4n+2, 4 octets of data. */
 
 /* RFC 2460: The Option Type identifiers are internally encoded such that their
  * highest-order two bits specify the action that must be taken if the
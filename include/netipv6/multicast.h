@@ -34,5 +34,27 @@ int netipv6_multicast_join_prv(netif_t *netif, const ipv6_addr_t *ip_addr);
  */
 int netipv6_multicast_leave_prv(netif_t *netif, const ipv6_addr_t *ip_addr);
 
+/*
+ * Returns non-0 if the interface has joined the IPv6 multicast group.
+ */
+int netipv6_multicast_is_member(netif_t *netif, const ipv6_addr_t *ip_addr);
+
+/*
+ * Returns non-0 if the group is reported by MLD.
+ */
+int netipv6_multicast_reportable(const ipv6_addr_t *ip_addr);
+
+/*
+ * Returns the entry of the group, or NULL if not found.
+ * Must hold the mcast_lock.
+ */
+struct netipv6_if_multicast *netipv6_multicast_lookup_prv(netif_t *netif, const ipv6_addr_t *ip_addr);
+
+/*
+ * Removes the groups, that have been left and whose MLD-Done has been sent.
+ * Must hold the mcast_lock.
+ */
+void netipv6_multicast_purge_prv(netif_t *netif);
+
 #endif
 
@@ -0,0 +1,39 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV6_SRCSEL_H_
+#define _NETIPV6_SRCSEL_H_
+
+#include <netif/if.h>
+#include <netipv6/ipv6.h>
+
+/*
+ * Selects the source address to use with a destination address, according to
+ * the rules of RFC 6724 5. The result is memoised per destination.
+ *
+ * Returns non-0 if a source address has been found, 0 otherwise.
+ */
+int netipv6_select_src_addr(netif_t *nif, ipv6_addr_t *src, const ipv6_addr_t *dest);
+
+/*
+ * Invalidates the source address selection cache. Must be called, whenever an
+ * address is bound, unbound or changes its state.
+ */
+void netipv6_srcsel_invalidate(netif_t *nif);
+
+#endif
+
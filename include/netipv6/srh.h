@@ -0,0 +1,47 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETIPV6_SRH_H_
+#define _NETIPV6_SRH_H_
+
+#include <netipv6/ipv6.h>
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+
+enum{
+	NETIPV6_SRH_LOCAL,     /* The new destination is ourself; process the header again. */
+	NETIPV6_SRH_FORWARDED, /* The packet has been sent to the next segment. */
+	NETIPV6_SRH_DROP,      /* The packet must be discarded. */
+	NETIPV6_SRH_ICMP,      /* The packet must be discarded with an ICMP Parameter Problem. */
+};
+
+/*
+ * Performs the SRv6 endpoint behavior (RFC 8754 4.3.1) on a Segment Routing
+ * Header with a non-zero Segments Left field.
+ *
+ * The header must start at the current offset and its 'size' octets must
+ * reside in contiguous area of memory. It is updated in place, and so is the
+ * Destination Address in the IPv6 header (and *dst).
+ *
+ * On NETIPV6_SRH_FORWARDED, the packet has been handed to netipv6_forward()
+ * and has been consumed. On NETIPV6_SRH_LOCAL, the header has to be re-read
+ * from the packet.
+ */
+int netipv6_srh_process(netif_t *nif, netpkt_t *pkt, size_t size, ipv6_addr_t *dst);
+
+#endif
+
@@ -0,0 +1,106 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETMLD_MLD_HEADER_H_
+#define _NETMLD_MLD_HEADER_H_
+
+#include <neticmp6/icmp6_header.h>
+#include <netipv6/ipv6.h>
+
+/**********************************************************************
+* MLD Query Message Format (RFC 2710, RFC 3810 5.1)
+***********************************************************************
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |  Type = 130   |      Code     |           Checksum            |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |    Maximum Response Code      |           Reserved            |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |                                                               |
+*    *                       Multicast Address                       *
+*    |                                                               |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    | Resv  |S| QRV |     QQIC      |     Number of Sources (N)     |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |   Source Address [1..N] ...
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*
+* The last line (starting at 'Resv') is only present in MLDv2 Queries.
+***********************************************************************/
+typedef struct NETSTD_PACKED
+{
+	fnet_icmp6_header_t icmp6_header;
+	uint16_t            max_resp_code;  /* Maximum Response Code. */
+	uint16_t            _reserved;
+	ipv6_addr_t         multicast_addr; /* Unspecified for a General Query. */
+} fnet_mld_header_t;
+
+typedef struct NETSTD_PACKED
+{
+	fnet_mld_header_t   mld_header;
+	uint8_t             s_qrv;             /* Suppress Router-Side Processing, Querier's Robustness Variable. */
+	uint8_t             qqic;              /* Querier's Query Interval Code. */
+	uint16_t            number_of_sources;
+} fnet_mld_query_v2_t;
+
+/**********************************************************************
+* Version 2 Multicast Listener Report Message (RFC 3810 5.2)
+***********************************************************************
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |  Type = 143   |    Reserved   |           Checksum            |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |           Reserved            |Nr of Mcast Address Records (M)|
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    .                  Multicast Address Record [1..M]              .
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*
+* Multicast Address Record:
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |  Record Type  |  Aux Data Len |     Number of Sources (N)     |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |                                                               |
+*    *                       Multicast Address                       *
+*    |                                                               |
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*    |   Source Address [1..N] ...
+*    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+***********************************************************************/
+typedef struct NETSTD_PACKED
+{
+	fnet_icmp6_header_t icmp6_header;
+	uint16_t            _reserved;
+	uint16_t            number_of_records;
+} fnet_mld_report_v2_t;
+
+typedef struct NETSTD_PACKED
+{
+	uint8_t             record_type;
+	uint8_t             aux_data_len;
+	uint16_t            number_of_sources;
+	ipv6_addr_t         multicast_addr;
+} fnet_mld_record_t;
+
+/* Multicast Address Record Types (RFC 3810 5.2.12). */
+#define FNET_MLD_RECORD_MODE_IS_INCLUDE          (1u)  /* Current-State Record. */
+#define FNET_MLD_RECORD_MODE_IS_EXCLUDE          (2u)  /* Current-State Record. */
+#define FNET_MLD_RECORD_CHANGE_TO_INCLUDE_MODE   (3u)  /* Filter-Mode-Change Record. */
+#define FNET_MLD_RECORD_CHANGE_TO_EXCLUDE_MODE   (4u)  /* Filter-Mode-Change Record. */
+
+/* RFC 3810 9.11: Unsolicited Report Interval (in ms). */
+#define FNET_MLD_UNSOLICITED_REPORT_INTERVAL     (1000u)
+
+#endif
+
@@ -0,0 +1,31 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETMLD_OUTPUT_H_
+#define _NETMLD_OUTPUT_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+
+/*
+ * Sends a chain of Version 2 Multicast Listener Reports (linked by
+ * 'next_chain') to the all MLDv2-capable routers address (FF02::16).
+ */
+void netmld_report_send(netif_t *nif, netpkt_t *chain);
+
+#endif
+
@@ -0,0 +1,33 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETMLD_TIMER_H_
+#define _NETMLD_TIMER_H_
+
+#include <netif/if.h>
+
+/*
+ * The MLD timer. Must be called periodically, like netnd6_timer().
+ *
+ * It sends the State-Change Reports of joined and left groups, and the
+ * responses to General and Group-Specific Queries. All records, that are due
+ * at the same time, are packed into as few Report messages as possible.
+ */
+void netmld_timer(netif_t *nif);
+
+#endif
+
@@ -22,6 +22,7 @@
 #define _NETND6_IF_H_
 
 #include <netpkt/pkt.h>
+#include <netpkt/queue.h>
 #include <netstd/stdint.h>
 #include <netipv6/ipv6.h>
 #include <netif/hwaddr.h>
@@ -33,6 +34,16 @@
 #define FNET_ND6_REDIRECT_TABLE_SIZE         8
 #define FNET_ND6_RDNSS_LIST_SIZE             8
 
+/*
+ * Limits for packets waiting for address resolution to complete.
+ */
+#ifndef FNET_ND6_WAITING_PKTS_MAX
+#define FNET_ND6_WAITING_PKTS_MAX            4    /* Per Neighbor Cache entry. */
+#endif
+#ifndef FNET_ND6_WAITING_PKTS_TOTAL_MAX
+#define FNET_ND6_WAITING_PKTS_TOTAL_MAX      32   /* Per Neighbor Cache (interface). */
+#endif
+
 /**************************************************************
 * RFC4861. 10. Protocol Constants.
 ***************************************************************
@@ -113,6 +124,27 @@
  */
 #define FNET_ND6_MAX_UNICAST_SOLICIT         (3U)        /*times*/
 
+/*
+ * RFC4861 6.3.2: The ReachableTime is a uniformly distributed random value
+ * between MIN_RANDOM_FACTOR and MAX_RANDOM_FACTOR times BaseReachableTime.
+ * The factors are given in percent.
+ */
+#define FNET_ND6_MIN_RANDOM_FACTOR           (50U)       /* percent */
+#define FNET_ND6_MAX_RANDOM_FACTOR           (150U)      /* percent */
+
+/*
+ * RFC4861 6.3.4: A new random value should be calculated [...] at least every
+ * few hours even if no Router Advertisements are received.
+ */
+#define FNET_ND6_REACHABLE_TIME_RENEW        (2U*3600U*1000U) /* ms */
+
+/*
+ * RFC4862 5.1: DupAddrDetectTransmits. The number of consecutive Neighbor
+ * Solicitation messages sent while performing Duplicate Address Detection
+ * on a tentative address. Default: 1.
+ */
+#define FNET_ND6_DUP_ADDR_DETECT_TRANSMITS   (1U)        /* transmissions */
+
 /*
  * ND6 general timer resolution.
  */
@@ -187,12 +219,15 @@ typedef struct fnet_nd6_neighbor_entry
 	ipv6_addr_t                 ip_addr;        /* Neighbor's on-link unicast IP address. */
 	hwaddr_t                    ll_addr2;       /* Its link-layer address. Actual size is defined within. */
 	net_time_t                  state_time;     /* Time of last state event.*/
-	netpkt_t                    *waiting_pkts;  /* Pointer to any queued packetwaiting for address resolution to complete.*/
+	volatile net_time_t         confirm_time;   /* Time of the last upper-layer reachability confirmation.
+	                                             * Written without holding the nd6-lock.*/
+	netpkt_queue_t              waiting_pkts;   /* Queue of packets waiting for address resolution to complete.*/
 	/* RFC 4861 7.2.2: While waiting for address resolution to complete, the sender MUST,
 	 * for each neighbor, retain a small queue of packets waiting for
 	 * address resolution to complete. The queue MUST hold at least one
 	 * packet, and MAY contain more.
-	 * When a queue  overflows, the new arrival SHOULD replace the oldest entry.*/
+	 * When a queue  overflows, the new arrival SHOULD replace the oldest entry.
+	 * The queue is bounded by FNET_ND6_WAITING_PKTS_MAX.*/
 	uint32_t                    solicitation_send_counter;  /* Counter - how many soicitations where sent.*/
 	ipv6_addr_t                 solicitation_src_ip_addr;   /* IP address used during AR solicitation messages. */
 	net_time_t                  creation_time;              /* Time of entry creation, in seconds.*/
@@ -264,6 +299,9 @@ typedef struct netnd6_if {
 	**************************************************************/
 	fnet_nd6_neighbor_entry_t  neighbor_cache[FNET_ND6_NEIGHBOR_CACHE_SIZE];
 	
+	/* Accounting of the packets waiting for address resolution. */
+	netpkt_queue_stats_t       waiting_stats;
+	
 	/*************************************************************
 	* Prefix List.
 	* RFC4861 5.1: A list of the prefixes that define a set of
@@ -282,11 +320,15 @@ typedef struct netnd6_if {
 	uint8_t                    cur_hop_limit;           /* The default value that
 	                                                     * should be placed in the Hop Count field of the IP
 	                                                     * header for outgoing IP packets.*/
+	net_time_t                 base_reachable_time;     /* BaseReachableTime, in milliseconds.
+	                                                     * Updated by RA messages.*/
 	net_time_t                 reachable_time;          /* The time, in milliseconds,
 	                                                     * that a node assumes a neighbor is
 	                                                     * reachable after having received a reachability
 	                                                     * confirmation. Used by the Neighbor Unreachability
-	                                                     * Detection algorithm.*/
+	                                                     * Detection algorithm.
+	                                                     * Randomized from base_reachable_time.*/
+	net_time_t                 reachable_time_stamp;    /* Time of the last randomization, in milliseconds.*/
 	net_time_t                 retrans_timer;           /* The time, in milliseconds,
 	                                                     * between retransmitted Neighbor
 	                                                     * Solicitation messages. Used by address resolution
@@ -30,6 +30,24 @@ fnet_nd6_neighbor_entry_t* netnd6_neighbor_cache_add2(netif_t *nif, ipv6_addr_t
 
 fnet_nd6_neighbor_entry_t* netnd6_get_router(netif_t *nif);
 
+/*
+ * Upper-layer reachability confirmation (RFC4861 7.3.1).
+ *
+ * Upper-layer protocols call this, when they have evidence of forward
+ * progress (eg. a TCP ACK for new data). The neighbor entry of 'addr' is
+ * kept REACHABLE without unicast probes.
+ *
+ * Lock-free. The confirmation is applied by netnd6_timer().
+ * Returns 1, if 'addr' is in the Neighbor Cache, 0 otherwise.
+ */
+int netnd6_confirm_reachable(netif_t *nif, const ipv6_addr_t *addr);
+
+/*
+ * Like netnd6_confirm_reachable(), for the default router, that off-link
+ * destinations without a route are sent to (see netnd6_get_router()).
+ */
+void netnd6_confirm_router(netif_t *nif);
+
 fnet_nd6_prefix_entry_t*   netnd6_prefix_list_get(netif_t *nif, const ipv6_addr_t *prefix);
 
 /*
@@ -0,0 +1,42 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETND6_TIMER_H_
+#define _NETND6_TIMER_H_
+
+#include <netif/if.h>
+
+/*
+ * The ND6 timer. Must be called every FNET_ND6_TIMER_PERIOD milliseconds.
+ *
+ * It drives the Neighbor Cache state machine (RFC4861 7.3.3): address
+ * resolution retransmits, REACHABLE->STALE, DELAY->PROBE, unicast probe
+ * retransmits and the removal of unreachable neighbors. It also completes
+ * Duplicate Address Detection (RFC4862 5.4) for tentative addresses.
+ */
+void netnd6_timer(netif_t *nif);
+
+/*
+ * Computes a new random ReachableTime from BaseReachableTime.
+ *
+ * RFC4861 6.3.2: ReachableTime is a uniformly distributed random value
+ * between MIN_RANDOM_FACTOR and MAX_RANDOM_FACTOR times BaseReachableTime.
+ */
+void netnd6_reachable_time_update(netif_t *nif);
+
+#endif
+
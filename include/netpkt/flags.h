@@ -29,5 +29,18 @@
  */
 #define NETPKT_FLAG_NO_UNICAST_L3 0x0004
 
+/*
+ * Checksum offload: The interface has verified the Layer 4 (TCP, UDP)
+ * checksum, so the stack doesn't need to.
+ */
+#define NETPKT_FLAG_L4_CSUM_OK    0x0008
+
+/*
+ * The next hop, that is passed to ifapi_send_l3_ipv6(), has been taken from
+ * the FIB, and is on-link. The neighbor resolution doesn't need to check
+ * the prefix list, or select a default router.
+ */
+#define NETPKT_FLAG_NH_ONLINK     0x0010
+
 #endif
 
@@ -31,6 +31,13 @@ typedef struct netpkt{
 	uint16_t       flags;
 	uint8_t        level;
 	
+	/*
+	 * Segmentation offload: If non-0, the packet is a UDP datagram, that the
+	 * interface must split into segments of 'gso_size' payload bytes.
+	 * Only passed to interfaces with the NETIF_GSO_UDP flag.
+	 */
+	uint16_t       gso_size;
+	
 	/*
 	 * Layer specific metadata.
 	 */
@@ -52,7 +59,19 @@ typedef struct netpkt{
 			 * After exiting the IPv6 Layer, this flag SHALL be set.
 			 */
 			unsigned param_is_pointer : 1;
+			/*
+			 * Set by the IPv6 input, if the Payload Length is zero, in
+			 * which case a Jumbo Payload option must follow (RFC 2675).
+			 */
+			unsigned jumbo : 1;
 		} ipv6;
+		struct {
+			/*
+			 * Sequence number of the first data byte, while the
+			 * segment is held in a TCP reassembly queue.
+			 */
+			uint32_t seq;
+		} tcp;
 	};
 } netpkt_t;
 
@@ -130,6 +149,13 @@ int netpkt_switchlevel(netpkt_t *pkt,int direction);
  */
 void *netpkt_data(netpkt_t *pkt);
 
+/*
+ * Copies 'len' bytes, starting 'off' bytes after the current offset, into 'dst'.
+ *
+ * On success it returns 0, non-0 otherwise.
+ */
+int netpkt_copyout(netpkt_t *pkt,uint32_t off,void *dst,uint32_t len);
+
 /*
  * Frees an entire chain of network packets.
  */
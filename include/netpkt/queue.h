@@ -0,0 +1,65 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETPKT_QUEUE_H_
+#define _NETPKT_QUEUE_H_
+
+#include <netpkt/pkt.h>
+
+/*
+ * A FIFO queue of packets, linked through pkt->next_chain.
+ *
+ * Packets are appended at the tail in O(1). The head is the oldest packet,
+ * so the queue can be handed out as a chain in transmission order.
+ */
+typedef struct netpkt_queue{
+	netpkt_t* head;
+	netpkt_t* tail;
+	uint32_t  length;
+} netpkt_queue_t;
+
+/*
+ * Statistics and accounting, shared by all queues of a table
+ * (eg. a Neighbor Cache or an ARP table).
+ */
+typedef struct netpkt_queue_stats{
+	uint32_t  queued;       /* Packets currently held in all queues of the table. */
+	uint32_t  drops_entry;  /* Packets dropped, because an entry's queue was full. */
+	uint32_t  drops_table;  /* Packets dropped, because the table-wide limit was hit. */
+	uint32_t  drops_evict;  /* Packets dropped, because their entry was recycled. */
+	uint32_t  drops_failed; /* Packets dropped, because address resolution failed. */
+} netpkt_queue_stats_t;
+
+/*
+ * Appends a single packet to the tail of the queue.
+ *
+ * If the queue holds more than 'entry_max' packets, or the table holds more
+ * than 'table_max' packets, the oldest packet of the queue is removed. If the
+ * table is full and the queue is empty, the new arrival itself is removed.
+ *
+ * Removed packets are prepended to '*drops', so that the caller can free them
+ * after releasing its lock.
+ */
+void netpkt_queue_enqueue(netpkt_queue_t *q, netpkt_queue_stats_t *stats, netpkt_t *pkt, uint32_t entry_max, uint32_t table_max, netpkt_t **drops);
+
+/*
+ * Detaches all packets from the queue and returns them as chain, oldest first.
+ */
+netpkt_t* netpkt_queue_flush(netpkt_queue_t *q, netpkt_queue_stats_t *stats);
+
+#endif
+
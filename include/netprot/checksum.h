@@ -25,8 +25,27 @@
 
 uint16_t netprot_checksum_buf(void* ptr, size_t len);
 uint16_t netprot_checksum(netpkt_t *pkt, size_t len);
-uint16_t netprot_checksum_pseudo_start( netpkt_t *pkt, uint8_t protocol, uint16_t protocol_len );
+/*
+ * Starts the checksum computation over the upper-layer packet and the
+ * pseudo-header fields, that are not addresses. The 'protocol_len' is 32 bits
+ * wide, as the IPv6 pseudo-header carries a 32-bit Upper-Layer Packet Length
+ * (RFC 8200 8.1), which matters for jumbograms (RFC 2675).
+ */
+uint16_t netprot_checksum_pseudo_start( netpkt_t *pkt, uint8_t protocol, uint32_t protocol_len );
+
+/*
+ * Like netprot_checksum_pseudo_start(), but only the first 'coverage' bytes of
+ * the packet are summed up, as in UDP-Lite (RFC 3828 3.1). The pseudo-header
+ * still carries 'protocol_len'.
+ */
+uint16_t netprot_checksum_pseudo_start_cov( netpkt_t *pkt, uint8_t protocol, uint32_t protocol_len, uint32_t coverage );
 uint16_t netprot_checksum_pseudo_end( uint16_t sum_s, const uint8_t *ip_src, uint8_t *ip_dest, size_t addr_size );
 
+/*
+ * Incrementally updates a checksum, when a 16-bit word of the data changes
+ * from 'oldval' to 'newval' (RFC 1624). All values in network byte order.
+ */
+uint16_t netprot_checksum_update16( uint16_t checksum, uint16_t oldval, uint16_t newval );
+
 #endif
 
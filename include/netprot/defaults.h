@@ -42,6 +42,7 @@
 #define IP_PROTOCOL_UDP    (17)
 #define IP_PROTOCOL_TCP    (6)
 #define IP_PROTOCOL_ICMP6  (58)
+#define IP_PROTOCOL_UDPLITE (136)
 
 #define IP_PROTOCOL_GRE    (0x2F)
 
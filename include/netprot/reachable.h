@@ -0,0 +1,36 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETPROT_REACHABLE_H_
+#define _NETPROT_REACHABLE_H_
+
+#include <netif/if.h>
+#include <netsock/flow.h>
+
+/*
+ * Upper-layer reachability confirmation for a flow (RFC4861 7.3.1).
+ *
+ * Protocols call this, when the flow shows forward progress, eg. when a TCP
+ * ACK acknowledges new data. It confirms the next hop of the flow's remote
+ * address in the Neighbor Cache or in the ARP table.
+ *
+ * Lock-free; cheap enough to be called per packet.
+ */
+void netprot_confirm_reachable(netif_t *nif, const netsock_flow_t *flow);
+
+#endif
+
@@ -21,6 +21,14 @@
 #include <netstd/stdint.h>
 #include <netsock/addr.h>
 
+/*
+ * The flow is a member of a listener group: Several flows of the same
+ * protocol are bound to the same local address and port, and each incoming
+ * connection or datagram is delivered to one of them, selected by the hash of
+ * its address tuple (like SO_REUSEPORT).
+ */
+#define NETSOCK_FLOW_REUSEPORT 0x01
+
 typedef struct netsock_flow {
 	struct netsock_flow     *tail;    /* Next element in Linked list */
 	struct netsock_flow     **prev;   /* A pointer to a reference to this object. */
@@ -29,6 +37,7 @@ typedef struct netsock_flow {
 	net_sockaddr_t          remote_a; /* Remote address of this socket. */
 	net_sockaddr_t          local_a;  /* Local address of this socket. */
 	uint8_t                 protocol; /* Protocol ID. */
+	uint8_t                 flags;    /* NETSOCK_FLOW_* */
 	void  (*freeflow)(struct netsock_flow* flow); /* Destructor. */
 	void*                   instance; /* Protocol specific data. */
 } netsock_flow_t;
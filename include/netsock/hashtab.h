@@ -40,13 +40,25 @@ typedef struct netsock_ht {
  * Looks up a Flow and increments it's reference count.
  */
 netsock_flow_t* netsock_lookup_flow(netsock_ht_t* table, uint8_t protocol, const net_sockaddr_t *remote_a, const net_sockaddr_t *local_a);
-netsock_flow_t* netsock_lookup_flow_port(netsock_ht_t* table, uint8_t protocol, const net_sockaddr_t *local_a);
+
+/*
+ * Looks up a listening Flow and increments it's reference count. If it is a
+ * member of a listener group (NETSOCK_FLOW_REUSEPORT), the member is selected
+ * by the hash of the address tuple, so all packets of a connection reach the
+ * same member.
+ */
+netsock_flow_t* netsock_lookup_flow_port(netsock_ht_t* table, uint8_t protocol, const net_sockaddr_t *remote_a, const net_sockaddr_t *local_a);
 
 void netsock_add_flow(netsock_ht_t* table, netsock_flow_t* flow);
 void netsock_add_flow_port(netsock_ht_t* table, netsock_flow_t* flow);
 
 void netsock_remove_flow(netsock_ht_t* table, netsock_flow_t* flow);
 
+/*
+ * Increments the reference count of a Flow, that is already referenced.
+ */
+void netsock_incr_flow(netsock_ht_t* table, netsock_flow_t* flow);
+
 /*
  * Decrements the reference count of a Flow.
  */
@@ -0,0 +1,34 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+/*
+ * Atomic operations and memory barriers.
+ *
+ * These map to the GCC __sync builtins, which are also supported by clang
+ * and ICC.
+ */
+
+/* Atomically adds 'val' to '*ptr' and returns the old value. */
+#define net_atomic_fetch_add(ptr,val) __sync_fetch_and_add((ptr),(val))
+
+/* Atomically sets '*ptr' to 'nval', if it equals 'oval'. Returns non-0 on success. */
+#define net_atomic_cas(ptr,oval,nval) __sync_bool_compare_and_swap((ptr),(oval),(nval))
+
+/* Full memory barrier. */
+#define net_memory_barrier() __sync_synchronize()
+
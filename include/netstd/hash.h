@@ -0,0 +1,86 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <netstd/stdint.h>
+
+/*
+ * Hash functions and helpers for open-addressed hash tables.
+ */
+
+/* Fibonacci hashing; mix the high bits down. */
+static inline uint32_t net_hash32(uint32_t h){
+	h *= 0x9E3779B1u;
+	return h ^ (h>>16);
+}
+
+/*
+ * Hashes an array of four words, eg. the 'addr32' member of an IPv6 address.
+ * A macro, because addresses may be packed: 'w' is evaluated four times.
+ */
+#define net_hash128(w) net_hash32((w)[0] ^ (w)[1] ^ (w)[2] ^ (w)[3])
+
+/*
+ * FNV-1a, 32 bit. Not keyed: use net_siphash() for values, that must not be
+ * predictable.
+ */
+#define NET_FNV_PRIME 16777619U
+#define NET_FNV_BASIS 2166136261U
+
+static inline uint32_t net_fnv1a(uint32_t hash, const void *data, size_t len){
+	const uint8_t *p = data;
+	for(;len;len--,p++){
+		hash ^= *p;
+		hash *= NET_FNV_PRIME;
+	}
+	return hash;
+}
+
+/* Hashes the bytes of 'data', the least significant first. */
+static inline uint32_t net_fnv1a_u16(uint32_t hash, uint16_t data){
+	hash ^= (data&0xff);
+	hash *= NET_FNV_PRIME;
+	hash ^= (data >> 8);
+	hash *= NET_FNV_PRIME;
+	return hash;
+}
+
+/*
+ * Backward shift deletion for open-addressed tables with linear probing.
+ *
+ * Removes the entry at slot 'slot' of the array 'tab', whose size is
+ * 'mask'+1. The entries must have a 'used' member. HOME(e) returns the hash
+ * of the entry pointed to by 'e'. No tombstones are left behind: The entries
+ * following the hole are moved into it, unless that would move them in front
+ * of their home slot.
+ */
+#define NET_HASH_REMOVE(tab,slot,mask,HOME) do{                           \
+	uint32_t net_hr_i_, net_hr_j_, net_hr_k_;                             \
+	net_hr_i_ = (slot);                                                   \
+	for(net_hr_j_ = (net_hr_i_+1)&(mask) ; (tab)[net_hr_j_].used ; net_hr_j_ = (net_hr_j_+1)&(mask)){ \
+		/* The home slot of the entry at 'j'. */                          \
+		net_hr_k_ = HOME(&(tab)[net_hr_j_]) & (mask);                     \
+		/* Can the entry at 'j' be moved into the hole at 'i'? Only if 'k' is not in (i,j]. */ \
+		if( (net_hr_i_<=net_hr_j_) ?                                      \
+			((net_hr_i_<net_hr_k_)&&(net_hr_k_<=net_hr_j_)) :             \
+			((net_hr_i_<net_hr_k_)||(net_hr_k_<=net_hr_j_)) ) continue;   \
+		(tab)[net_hr_i_] = (tab)[net_hr_j_];                              \
+		net_hr_i_ = net_hr_j_;                                            \
+	}                                                                     \
+	(tab)[net_hr_i_].used = 0;                                            \
+}while(0)
+
@@ -21,4 +21,13 @@
  */
 #include <string.h>
 
-#define net_bzero(ptr,len) memset((ptr),0,(len))
\ No newline at end of file
+#define net_bzero(ptr,len) memset((ptr),0,(len))
+
+/*
+ * For malloc and free.
+ */
+#include <stdlib.h>
+
+#define net_malloc(size) malloc(size)
+
+#define net_free(ptr) free(ptr)
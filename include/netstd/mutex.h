@@ -32,3 +32,7 @@ int net_mutex_trylock(net_mutex_t m);
 
 void net_mutex_unlock(net_mutex_t m);
 
+/*
+ * Destroys a mutex, that is not locked.
+ */
+void net_mutex_free(net_mutex_t m);
@@ -18,3 +18,8 @@
 
 #define NETSTD_PACKED __attribute__((__packed__))
 
+/* Assumed size of a CPU cache line. */
+#define NETSTD_CACHELINE 64
+
+#define NETSTD_ALIGNED(n) __attribute__((__aligned__(n)))
+
@@ -0,0 +1,56 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <netstd/stdint.h>
+#include <netstd/atomic.h>
+
+/*
+ * Sequence counters for lock-free readers.
+ *
+ * Writers are serialized by a mutex. They make the counter odd while they
+ * update the data. Readers don't lock; they retry, if an update was in
+ * progress or has happened in the meantime:
+ *
+ *	do{
+ *		seq = net_seq_read_begin(&tab->seq);
+ *		... read ...
+ *	}while( net_seq_read_retry(&tab->seq,seq) );
+ */
+
+static inline uint32_t net_seq_read_begin(const volatile uint32_t *seq){
+	uint32_t s = *seq;
+	net_memory_barrier();
+	return s;
+}
+
+/* Returns non-0, if the data read since net_seq_read_begin() may be inconsistent. */
+static inline int net_seq_read_retry(const volatile uint32_t *seq, uint32_t s){
+	net_memory_barrier();
+	return (s & 1) || (s != *seq);
+}
+
+static inline void net_seq_write_begin(volatile uint32_t *seq){
+	(*seq)++;
+	net_memory_barrier();
+}
+
+static inline void net_seq_write_end(volatile uint32_t *seq){
+	net_memory_barrier();
+	(*seq)++;
+}
+
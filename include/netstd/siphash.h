@@ -0,0 +1,29 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <netstd/stdint.h>
+
+/*
+ * SipHash-2-4, a keyed pseudo-random function (Aumasson, Bernstein, 2012).
+ *
+ * For values, that must not be predictable from the outside, such as Initial
+ * Sequence Numbers and SYN cookies. 'key' is a secret 128-bit key, given as
+ * four 32-bit words (the least significant word first); 'data' is hashed as
+ * a sequence of bytes.
+ */
+uint64_t net_siphash(const uint32_t key[4], const void *data, size_t len);
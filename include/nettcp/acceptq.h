@@ -0,0 +1,69 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_ACCEPTQ_H_
+#define _NETTCP_ACCEPTQ_H_
+
+#include <netstd/stdint.h>
+#include <netstd/packing.h>
+
+/*
+ * Number of slots in the accept queue of a listener. Must be a power of two.
+ * Connections, that are established, while the queue is full, are reset.
+ */
+#ifndef NETTCP_ACCEPTQ_SIZE
+#define NETTCP_ACCEPTQ_SIZE 128
+#endif
+
+struct nettcp_tcb;
+
+typedef struct nettcp_acceptq_slot{
+	volatile uint32_t  seq;       /* Sequence number; tells, whether the slot is full. */
+	struct nettcp_tcb  *tcb;
+} nettcp_acceptq_slot_t;
+
+/*
+ * A bounded multi-producer, multi-consumer ring of established connections,
+ * that have not been accepted yet (Dmitry Vyukov's bounded MPMC queue).
+ *
+ * Producers (the receive path) claim a slot by advancing 'head' with
+ * compare-and-swap, and publish it by setting its sequence number. Consumers
+ * (worker threads, calling nettcp_accept()) claim a published slot by
+ * advancing 'tail' with compare-and-swap. Neither side takes a lock.
+ */
+typedef struct nettcp_acceptq{
+	volatile uint32_t      head NETSTD_ALIGNED(NETSTD_CACHELINE);
+	volatile uint32_t      tail NETSTD_ALIGNED(NETSTD_CACHELINE);
+	nettcp_acceptq_slot_t  slots[NETTCP_ACCEPTQ_SIZE] NETSTD_ALIGNED(NETSTD_CACHELINE);
+} nettcp_acceptq_t;
+
+void nettcp_acceptq_init(nettcp_acceptq_t *q);
+
+/*
+ * Enqueues a connection. May be called concurrently.
+ * Return 0 on success, non-0 if the queue is full.
+ */
+int nettcp_acceptq_enqueue(nettcp_acceptq_t *q, struct nettcp_tcb *tcb);
+
+/*
+ * Dequeues the oldest connection. May be called concurrently.
+ * Returns NULL, if the queue is empty.
+ */
+struct nettcp_tcb* nettcp_acceptq_dequeue(nettcp_acceptq_t *q);
+
+#endif
+
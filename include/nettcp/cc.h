@@ -0,0 +1,90 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_CC_H_
+#define _NETTCP_CC_H_
+
+#include <netstd/stdint.h>
+
+struct nettcp_tcb;
+
+/*
+ * Size of the per-connection state of a congestion control module, in 64-bit
+ * words (nettcp_tcb_t.cc_priv).
+ */
+#define NETTCP_CC_PRIV_WORDS 16
+
+/* Loss events (nettcp_cc_ops_t.loss). */
+#define NETTCP_CC_LOSS_FAST  1  /* Three duplicate ACKs; fast retransmit (RFC 5681 3.2). */
+#define NETTCP_CC_LOSS_RTO   2  /* Retransmission timeout (RFC 5681 3.1). */
+
+/*
+ * A congestion control module. The module owns 'cwnd' and 'ssthresh' of the
+ * control block and keeps its own state in 'cc_priv'; the loss recovery
+ * (fast retransmit, NewReno partial ACKs, RFC 6582) is done by the stack.
+ *
+ * All functions are called with the connection's lock held.
+ */
+typedef struct nettcp_cc_ops{
+	const char *name;
+	
+	/*
+	 * The connection has been synchronized; 'snd_mss' and the initial
+	 * window (RFC 5681 3.1) are set. Also called, when the module is
+	 * changed on an established connection (optional).
+	 */
+	void (*init)(struct nettcp_tcb *tcb);
+	
+	/* New data ('acked' bytes) has been acknowledged, outside of a fast recovery. */
+	void (*ack)(struct nettcp_tcb *tcb, uint32_t acked);
+	
+	/*
+	 * A loss has been detected (NETTCP_CC_LOSS_*). Sets 'ssthresh' and
+	 * 'cwnd'. After a fast recovery, 'cwnd' is deflated to 'ssthresh'.
+	 */
+	void (*loss)(struct nettcp_tcb *tcb, int event);
+	
+	/* A round-trip time measurement, in milliseconds (optional). */
+	void (*rtt_sample)(struct nettcp_tcb *tcb, uint32_t rtt);
+	
+	/* The pacing rate in bytes per second; 0 = not paced (optional). */
+	uint32_t (*pacing_rate)(struct nettcp_tcb *tcb);
+} nettcp_cc_ops_t;
+
+/* RFC 5681, RFC 6582. The default. */
+extern const nettcp_cc_ops_t nettcp_cc_newreno;
+
+/* RFC 8312. */
+extern const nettcp_cc_ops_t nettcp_cc_cubic;
+
+/* BBR: Congestion-Based Congestion Control (ACM Queue, 2016). */
+extern const nettcp_cc_ops_t nettcp_cc_bbr;
+
+/*
+ * Looks up a module by name ("newreno", "cubic", "bbr").
+ * Returns NULL, if it is not known.
+ */
+const nettcp_cc_ops_t* nettcp_cc_find(const char *name);
+
+/*
+ * Selects the congestion control module of a connection or a listener (whose
+ * connections inherit it).
+ */
+void nettcp_set_cc(struct nettcp_tcb *tcb, const nettcp_cc_ops_t *cc);
+
+#endif
+
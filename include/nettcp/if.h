@@ -0,0 +1,80 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_IF_H_
+#define _NETTCP_IF_H_
+
+#include <netstd/stdint.h>
+#include <netstd/mutex.h>
+#include <netstd/time.h>
+
+/*
+ * Rate limit of the RSTs, that are sent in response to segments without a
+ * connection: NETTCP_RST_RATE per second, with bursts of up to
+ * NETTCP_RST_BURST.
+ */
+#ifndef NETTCP_RST_RATE
+#define NETTCP_RST_RATE   1000u
+#endif
+#ifndef NETTCP_RST_BURST
+#define NETTCP_RST_BURST  100u
+#endif
+
+struct nettcp_tcb;
+
+/*
+ * The TCP state of an interface. The connections themselves are found through
+ * the socket hashtable (netif_t.sockets); this structure links them for the
+ * timer.
+ */
+typedef struct nettcp_if{
+	net_mutex_t         lock;     /* Protects 'tcbs'. */
+	struct nettcp_tcb   *tcbs;    /* All connections, that are not CLOSED. */
+	uint32_t            key[4];   /* Secret key for the Initial Sequence Numbers (RFC 6528). */
+	
+	/*
+	 * SYN cookie keys: A fresh key for each period of the cookie's time
+	 * counter. The keys of the current and the previous period are kept,
+	 * indexed by the lowest bit of the counter. Replaced under 'lock'; read
+	 * lock-free through 'cookie_seq'.
+	 */
+	uint32_t            cookie_key[2][4];
+	volatile uint32_t   cookie_t;   /* Time counter of the current key. */
+	volatile uint32_t   cookie_seq; /* Seqlock over 'cookie_key' and 'cookie_t'. */
+	
+	/* Token bucket of the RST rate limiter; updated lock-free. */
+	volatile uint32_t   rst_tokens;
+	volatile net_time_t rst_stamp;
+	
+	/* Statistics. */
+	volatile uint32_t   active_opens;  /* Connections, that have been opened by us. */
+	volatile uint32_t   passive_opens; /* Connections, that have been accepted. */
+	volatile uint32_t   resets;        /* Connections, that have been reset. */
+	volatile uint32_t   retransmits;   /* Segments, that have been retransmitted by timeout. */
+	volatile uint32_t   fastpath;      /* Segments, that took the header prediction fast path. */
+	volatile uint32_t   rst_sent;      /* RSTs, that have been sent in response to a segment. */
+	volatile uint32_t   rst_limited;   /* RSTs, that have been suppressed by the rate limit. */
+} nettcp_if_t;
+
+/*
+ * Initializes the TCP state of an interface. 'tif->lock' must be initialized
+ * by the caller.
+ * Return 0 on success, non-0 on error.
+ */
+int nettcp_if_init(nettcp_if_t *tif);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_OUTPUT_H_
+#define _NETTCP_OUTPUT_H_
+
+#include <nettcp/tcb.h>
+
+/*
+ * Sends, what the state, the windows and the flags allow: the SYN, data, the
+ * FIN and ACKs. Must be called with the lock held.
+ */
+void nettcp_output(nettcp_tcb_t *tcb);
+
+/*
+ * Retransmits the first unacknowledged segment, without touching snd_nxt
+ * (fast retransmit). Must be called with the lock held.
+ */
+void nettcp_retransmit(nettcp_tcb_t *tcb);
+
+/*
+ * Sends a RST for a synchronized connection (RFC 793 3.9 ABORT). Must be
+ * called with the lock held.
+ */
+void nettcp_output_rst(nettcp_tcb_t *tcb);
+
+/*
+ * Computes the TCP checksum over 'length' bytes of the packet (at the TCP
+ * header) and the pseudo header. Returns 0 when verifying a valid segment.
+ */
+uint16_t nettcp_checksum(netpkt_t *pkt, uint32_t length, const net_sockaddr_t *src_addr, const net_sockaddr_t *dst_addr);
+
+/*
+ * The Maximum Segment Size, that we can receive on the interface.
+ */
+uint16_t nettcp_mss(netif_t *nif, uint8_t type);
+
+#endif
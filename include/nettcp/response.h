@@ -22,7 +22,23 @@
 #include <netpkt/pkt.h>
 #include <netsock/addr.h>
 
+/*
+ * Responds to a segment, that belongs to no connection, with a RST (RFC 793
+ * 3.4, "Reset Generation"). The RST is built in place in 'reused_pkt' (at the
+ * TCP header), which is consumed. 'src_addr' and 'dst_addr' are the addresses
+ * of the incoming segment.
+ *
+ * RSTs are rate limited (NETTCP_RST_RATE); without TCP on the interface
+ * (netif_t.tcp), none are sent.
+ */
 void nettcp_sendrst(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *reused_pkt);
 
+/*
+ * Answers a SYN with a SYN-ACK, without creating a connection (SYN cookies).
+ * The SYN-ACK is built in place in 'reused_pkt' (at the TCP header), which is
+ * consumed; it carries the MSS option, but no Window Scale option.
+ */
+void nettcp_sendsynack(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *reused_pkt, uint32_t iss, uint16_t window);
+
 #endif
 
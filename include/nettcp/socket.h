@@ -0,0 +1,74 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_SOCKET_H_
+#define _NETTCP_SOCKET_H_
+
+#include <nettcp/tcb.h>
+
+/*
+ * Opens a listening port on 'local_a'. If 'local_a->type' is 0, it accepts
+ * connections on any local address. 'backlog' is the number of half-open
+ * connections (0 = NETTCP_SYN_BACKLOG); beyond it, SYN cookies are used.
+ *
+ * If 'reuseport' is non-0, the listener joins the group of listeners on the
+ * same address and port (NETSOCK_FLOW_REUSEPORT); each one gets a share of the
+ * incoming connections, e.g. one listener per worker thread.
+ * Returns NULL on error.
+ */
+nettcp_tcb_t* nettcp_listen(netif_t *nif, const net_sockaddr_t *local_a, uint32_t backlog, int reuseport);
+
+/*
+ * Opens a connection (active open). If the local address is unspecified, it
+ * is selected; if the local port is 0, an ephemeral port is chosen.
+ * Returns NULL on error.
+ */
+nettcp_tcb_t* nettcp_connect(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, const netprot_opts_t *opts);
+
+/*
+ * Takes an established connection from the queue of a listening port. It is
+ * lock-free, and may be called by several threads concurrently.
+ * Returns NULL, if the queue is empty.
+ */
+nettcp_tcb_t* nettcp_accept(nettcp_tcb_t *listener);
+
+/*
+ * Appends a packet (its current level) to the send buffer.
+ * Returns 0, if the packet has been consumed, non-0 if the buffer is full or
+ * the connection does not accept data.
+ */
+int nettcp_send(nettcp_tcb_t *tcb, netpkt_t *pkt);
+
+/*
+ * Takes the next packet from the receive buffer, and opens the window.
+ * Returns NULL, if no data is available.
+ */
+netpkt_t* nettcp_recv(nettcp_tcb_t *tcb);
+
+/*
+ * Closes the connection (or the listening port) gracefully, and releases the
+ * caller's reference. The FIN is sent after the remaining data.
+ */
+void nettcp_close(nettcp_tcb_t *tcb);
+
+/*
+ * Resets the connection, and releases the caller's reference.
+ */
+void nettcp_abort(nettcp_tcb_t *tcb);
+
+#endif
+
@@ -0,0 +1,56 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_SYNCOOKIE_H_
+#define _NETTCP_SYNCOOKIE_H_
+
+#include <netif/if.h>
+#include <netsock/addr.h>
+
+/*
+ * The period of the cookie's time counter. A cookie is valid for one to two
+ * periods.
+ */
+#define NETTCP_COOKIE_PERIOD_MS  64000u
+
+struct nettcp_if;
+
+/*
+ * Initializes the cookie keys of an interface's TCP state.
+ */
+void nettcp_syncookie_init(struct nettcp_if *tif);
+
+/*
+ * RFC 4987 3.6: Computes a SYN cookie, which is used as our Initial Sequence
+ * Number, when a listener's SYN backlog is full. The cookie encodes a time
+ * counter, the MSS (rounded down to one of 8 values), and a keyed hash over
+ * the MSS, the addresses, the ports and the peer's ISN ('irs'). The key is
+ * replaced with every period of the time counter.
+ *
+ * '*mss' is the MSS, the peer has offered; it is replaced by the encoded one.
+ */
+uint32_t nettcp_syncookie_make(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, uint32_t irs, uint16_t *mss);
+
+/*
+ * Validates the cookie, that is acknowledged by the third segment of the
+ * handshake ('cookie' = SEG.ACK-1, 'irs' = SEG.SEQ-1), and decodes the MSS.
+ * Returns 0, if it is valid, non-0 otherwise.
+ */
+int nettcp_syncookie_check(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, uint32_t irs, uint32_t cookie, uint16_t *mss);
+
+#endif
+
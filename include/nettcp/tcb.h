@@ -0,0 +1,268 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_TCB_H_
+#define _NETTCP_TCB_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+#include <netsock/addr.h>
+#include <netsock/flow.h>
+#include <netprot/opts.h>
+#include <netstd/mutex.h>
+#include <netstd/time.h>
+#include <nettcp/acceptq.h>
+#include <nettcp/cc.h>
+
+/************************************************************************
+*     Configuration.
+*************************************************************************/
+#ifndef NETTCP_SNDBUF_DEFAULT
+#define NETTCP_SNDBUF_DEFAULT  (64u*1024u)   /* Send buffer size in bytes. */
+#endif
+#ifndef NETTCP_RCVBUF_DEFAULT
+#define NETTCP_RCVBUF_DEFAULT  (256u*1024u)  /* Receive buffer size in bytes. */
+#endif
+
+#define NETTCP_RTO_INITIAL     (1000u)   /* RFC 6298 2.1: Initial RTO of 1 second. */
+#define NETTCP_RTO_MIN         (200u)    /* Lower bound of the RTO (RFC 6298 2.4 allows less than 1s). */
+#define NETTCP_RTO_MAX         (60000u)  /* RFC 6298 2.5: Upper bound of 60 seconds. */
+#define NETTCP_REXMT_MAX       (12u)     /* Retransmissions, before the connection is dropped. */
+#define NETTCP_DELACK_MS       (200u)    /* RFC 1122 4.2.3.2: Delayed ACKs within 500ms. */
+#define NETTCP_MSL_MS          (30000u)  /* Maximum Segment Lifetime. */
+#define NETTCP_PACE_QUANTUM_US (1000u)   /* Pacing: Data may be sent up to 1 ms ahead of time. */
+#ifndef NETTCP_SYN_BACKLOG
+#define NETTCP_SYN_BACKLOG     (128u)    /* Default number of half-open connections per listener. */
+#endif
+
+/************************************************************************
+*     Connection states (RFC 793 3.2).
+*************************************************************************/
+#define NETTCP_CLOSED       0
+#define NETTCP_LISTEN       1
+#define NETTCP_SYN_SENT     2
+#define NETTCP_SYN_RCVD     3
+#define NETTCP_ESTABLISHED  4
+#define NETTCP_CLOSE_WAIT   5
+#define NETTCP_FIN_WAIT_1   6
+#define NETTCP_CLOSING      7
+#define NETTCP_LAST_ACK     8
+#define NETTCP_FIN_WAIT_2   9
+#define NETTCP_TIME_WAIT    10
+
+/* States, in which we have received a SYN. */
+#define NETTCP_HAVE_RCVD_SYN(s) ((s) >= NETTCP_SYN_RCVD)
+
+/* States, in which we may receive data. */
+#define NETTCP_CAN_RCV_DATA(s)  ( ((s) == NETTCP_ESTABLISHED) || ((s) == NETTCP_FIN_WAIT_1) || ((s) == NETTCP_FIN_WAIT_2) )
+
+/* States, in which we may send data. */
+#define NETTCP_CAN_SND_DATA(s)  ( ((s) == NETTCP_ESTABLISHED) || ((s) == NETTCP_CLOSE_WAIT) )
+
+/************************************************************************
+*     Flags (nettcp_tcb_t.flags).
+*************************************************************************/
+#define NETTCP_TF_ACKNOW     0x0001  /* Send an ACK immediately. */
+#define NETTCP_TF_DELACK     0x0002  /* An ACK has been delayed. */
+#define NETTCP_TF_NODELAY    0x0004  /* Disable the Nagle algorithm. */
+#define NETTCP_TF_SNDFIN     0x0008  /* The user has closed the connection; send a FIN after the data. */
+#define NETTCP_TF_SENTFIN    0x0010  /* A FIN has been sent. */
+#define NETTCP_TF_RCVDFIN    0x0020  /* A FIN has been received. */
+#define NETTCP_TF_WSCALE     0x0040  /* Window scaling is in use (RFC 7323). */
+#define NETTCP_TF_FORCE      0x0080  /* Send a segment, even if the window is closed (probe). */
+#define NETTCP_TF_SYNQ       0x0100  /* Counted in the SYN backlog of the parent. */
+#define NETTCP_TF_COOKIES    0x0200  /* Listener: SYN cookies have been sent recently. */
+#define NETTCP_TF_PACED      0x0400  /* Data is held back by the pacing; nettcp_timer() resumes it. */
+
+/************************************************************************
+*     Errors (nettcp_tcb_t.error).
+*************************************************************************/
+#define NETTCP_ERR_NONE      0
+#define NETTCP_ERR_REFUSED   1  /* RST in SYN-SENT. */
+#define NETTCP_ERR_RESET     2  /* RST in a synchronized state. */
+#define NETTCP_ERR_TIMEOUT   3  /* Too many retransmissions. */
+#define NETTCP_ERR_ABORTED   4  /* Aborted locally. */
+
+/************************************************************************
+*     Sequence number arithmetic (RFC 793 3.3).
+*************************************************************************/
+#define NETTCP_SEQ_LT(a,b)   ((int32_t)((uint32_t)(a)-(uint32_t)(b)) <  0)
+#define NETTCP_SEQ_LEQ(a,b)  ((int32_t)((uint32_t)(a)-(uint32_t)(b)) <= 0)
+#define NETTCP_SEQ_GT(a,b)   ((int32_t)((uint32_t)(a)-(uint32_t)(b)) >  0)
+#define NETTCP_SEQ_GEQ(a,b)  ((int32_t)((uint32_t)(a)-(uint32_t)(b)) >= 0)
+
+/*
+ * A TCP control block. It embeds the flow, under which the connection (or the
+ * listening port) is registered in the socket hashtable; 'flow.instance'
+ * points back to the control block, and the flow's reference count keeps it
+ * alive.
+ *
+ * All fields, except the flow, are protected by 'lock'.
+ */
+typedef struct nettcp_tcb{
+	netsock_flow_t      flow;
+	net_mutex_t         lock;
+	netif_t             *nif;
+	netprot_opts_t      opts;
+	
+	uint8_t             state;
+	uint8_t             error;      /* NETTCP_ERR_* */
+	uint16_t            flags;      /* NETTCP_TF_* */
+	
+	/* Send Sequence Variables (RFC 793 3.2). */
+	uint32_t            snd_una;    /* Oldest unacknowledged sequence number. */
+	uint32_t            snd_nxt;    /* Next sequence number to be sent. */
+	uint32_t            snd_max;    /* Highest sequence number sent. */
+	uint32_t            snd_wnd;    /* Send window (scaled). */
+	uint32_t            snd_wl1;    /* Segment sequence number used for the last window update. */
+	uint32_t            snd_wl2;    /* Segment acknowledgment number used for the last window update. */
+	uint32_t            snd_fin;    /* Sequence number of our FIN, if sent. */
+	uint32_t            iss;        /* Initial send sequence number. */
+	uint16_t            snd_mss;    /* Maximum segment size, we may send. */
+	uint8_t             snd_scale;  /* Window scale of the peer. */
+	
+	/* Receive Sequence Variables. */
+	uint8_t             rcv_scale;  /* Our window scale. */
+	uint32_t            rcv_nxt;    /* Next sequence number expected. */
+	uint32_t            rcv_adv;    /* Right edge of the advertised window. */
+	uint32_t            irs;        /* Initial receive sequence number. */
+	
+	/* Congestion control (RFC 5681, RFC 6582); 'cwnd' and 'ssthresh' belong to the module. */
+	const nettcp_cc_ops_t *cc;
+	uint32_t            cwnd;
+	uint32_t            ssthresh;
+	uint32_t            recover;    /* snd_max, when the fast recovery was entered. */
+	uint8_t             dupacks;
+	uint64_t            cc_priv[NETTCP_CC_PRIV_WORDS]; /* State of the module. */
+	net_time_t          pace_next;  /* Pacing: earliest time of the next data segment, in microseconds. */
+	
+	/* Retransmission timer (RFC 6298), in milliseconds. */
+	uint8_t             rexmt_shift;/* Number of consecutive timeouts. */
+	uint8_t             rtt_active; /* 'rtt_seq' is being timed. */
+	uint32_t            srtt;       /* Smoothed RTT, scaled by 8. */
+	uint32_t            rttvar;     /* RTT variation, scaled by 4. */
+	uint32_t            rto;
+	uint32_t            rtt_seq;
+	net_time_t          rtt_time;
+	net_time_t          rexmt_time; /* Expiration of the retransmission/persist timer; 0 = stopped. */
+	net_time_t          delack_time;/* Expiration of the delayed ACK timer. */
+	net_time_t          tw_time;    /* Expiration of the TIME-WAIT timer. */
+	
+	/*
+	 * Send buffer: The data from 'snd_una' (after the SYN) on, as a chain of
+	 * packets (at the payload level). It holds the unacknowledged and the
+	 * unsent data.
+	 */
+	netpkt_t            *snd_head, *snd_tail;
+	uint32_t            snd_len, snd_max_len;
+	
+	/* Receive buffer: The in-order data, that has not been read yet. */
+	netpkt_t            *rcv_head, *rcv_tail;
+	uint32_t            rcv_len, rcv_max_len;
+	
+	/* Out-of-order segments, sorted by sequence number (pkt->tcp.seq). */
+	netpkt_t            *ooo_head;
+	uint32_t            ooo_len;
+	
+	/* Passive open: The listener, that created this connection (referenced). */
+	struct nettcp_tcb   *parent;
+	
+	/*
+	 * Listener: The queue of established connections, that have not been
+	 * accepted yet (lock-free; each queued connection is referenced by the
+	 * queue), and the number of connections in SYN-RECEIVED. When that
+	 * reaches 'syn_backlog', SYNs are answered with SYN cookies.
+	 */
+	nettcp_acceptq_t    *acceptq;
+	volatile uint32_t   syn_count;
+	uint32_t            syn_backlog;
+	net_time_t          cookie_time; /* When the last SYN cookie was sent. */
+	
+	/* Timer list of the interface (nettcp_if_t.tcbs). */
+	struct nettcp_tcb   *tnext, **tprev;
+	struct nettcp_tcb   *tsnap;     /* Snapshot, taken by the timer. */
+} nettcp_tcb_t;
+
+/*
+ * Allocates a control block in the CLOSED state. The flow's reference count
+ * is 0; it is not yet registered.
+ * Returns NULL on error.
+ */
+nettcp_tcb_t* nettcp_tcb_new(netif_t *nif);
+
+/*
+ * Registers a control block in the socket hashtable and in the timer list.
+ * If 'listen' is non-0, it is registered as a listening port.
+ */
+void nettcp_tcb_attach(nettcp_tcb_t *tcb, int listen);
+
+/*
+ * Moves the control block to the CLOSED state, frees the buffers and removes
+ * it from the socket hashtable and the timer list. Must be called with the
+ * lock held and with a reference, other than the hashtable's.
+ */
+void nettcp_tcb_close(nettcp_tcb_t *tcb, uint8_t error);
+
+/*
+ * Removes a connection from the SYN backlog of its listener, once it leaves
+ * the SYN-RECEIVED state. Must be called with the lock held.
+ */
+void nettcp_synq_leave(nettcp_tcb_t *tcb);
+
+/*
+ * Resets and releases all connections in the accept queue of a listener,
+ * that is no longer in the LISTEN state. May be called concurrently.
+ */
+void nettcp_listen_drain(nettcp_tcb_t *lis);
+
+/*
+ * Releases a reference to the control block.
+ */
+void nettcp_tcb_release(nettcp_tcb_t *tcb);
+
+/*
+ * Maximum size of the buffer, filled by nettcp_tuple().
+ */
+#define NETTCP_TUPLE_MAX 36
+
+/*
+ * Serializes the local and remote address and port into 'buf', as the input
+ * of a keyed hash. Returns the number of bytes written.
+ */
+uint32_t nettcp_tuple(uint8_t *buf, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a);
+
+/*
+ * Computes the Initial Sequence Number for a connection (RFC 6528).
+ */
+uint32_t nettcp_iss(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a);
+
+/*
+ * RFC 7323 2.2: The smallest window scale, that allows to advertise a receive
+ * buffer of 'size' bytes.
+ */
+static inline uint8_t nettcp_rcv_wscale(uint32_t size){
+	uint8_t scale = 0;
+	while( (scale < 14) && ((size >> scale) > 0xffffu) ) scale++;
+	return scale;
+}
+
+/*
+ * The amount of free space in the receive buffer; the receive window.
+ */
+#define NETTCP_RCV_SPACE(tcb) ( ((tcb)->rcv_max_len > ((tcb)->rcv_len + (tcb)->ooo_len)) ? ((tcb)->rcv_max_len - (tcb)->rcv_len - (tcb)->ooo_len) : 0 )
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_HEADER_H_
+#define _NETTCP_HEADER_H_
+
+#include <netstd/stdint.h>
+#include <netstd/packing.h>
+
+/************************************************************************
+*     TCP definitions
+*************************************************************************/
+#define FNET_TCP_SGT_FIN    (0x01u) /* No more data from sender.*/
+#define FNET_TCP_SGT_SYN    (0x02u) /* Synchronize sequence numbers.*/
+#define FNET_TCP_SGT_RST    (0x04u) /* Reset the connection.*/
+#define FNET_TCP_SGT_PSH    (0x08u) /* Push function.*/
+#define FNET_TCP_SGT_ACK    (0x10u) /* Acknowledgment field significant.*/
+#define FNET_TCP_SGT_URG    (0x20u) /* Urgent Pointer field significant.*/
+
+/* Options (RFC 793 3.1, RFC 7323 2). */
+#define FNET_TCP_OPT_EOL    (0u)    /* End of option list.*/
+#define FNET_TCP_OPT_NOP    (1u)    /* No-Operation.*/
+#define FNET_TCP_OPT_MSS    (2u)    /* Maximum Segment Size.*/
+#define FNET_TCP_OPT_WS     (3u)    /* Window Scale.*/
+
+#define FNET_TCP_OPT_MSS_LEN (4u)
+#define FNET_TCP_OPT_WS_LEN  (3u)
+
+/* RFC 7323 2.3: The shift count must not exceed 14. */
+#define FNET_TCP_WS_MAX     (14u)
+
+/* RFC 1122 4.2.2.6: The default send MSS, when no MSS option is received. */
+#define FNET_TCP_DEFAULT_MSS (536u)
+
+typedef struct NETSTD_PACKED
+{
+    uint16_t source_port ;      /* Source port number.*/
+    uint16_t destination_port ; /* Destination port number.*/
+    uint32_t sequence ;         /* Sequence Number.*/
+    uint32_t ack_number ;       /* Acknowledgment Number.*/
+    uint8_t  hdrlength ;        /* Data Offset (upper 4 bits), in 32-bit words.*/
+    uint8_t  flags ;            /* Control Bits.*/
+    uint16_t window ;           /* Window.*/
+    uint16_t checksum ;         /* Checksum.*/
+    uint16_t urgent_ptr ;       /* Urgent Pointer.*/
+} fnet_tcp_header_t;
+
+#define FNET_TCP_HDR_LENGTH(hdr)      ( ((uint32_t)((hdr)->hdrlength) >> 4) << 2 )
+#define FNET_TCP_SET_HDR_LENGTH(hdr,len) ( (hdr)->hdrlength = (uint8_t)(((len) >> 2) << 4) )
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETTCP_TIMER_H_
+#define _NETTCP_TIMER_H_
+
+#include <netif/if.h>
+
+/*
+ * The TCP timer. Must be called periodically (every 100 milliseconds or
+ * less), by only one thread at a time.
+ *
+ * It drives the retransmission timer (RFC 6298), the persist timer (RFC 1122
+ * 4.2.2.17), the delayed ACKs (RFC 1122 4.2.3.2) and the TIME-WAIT state, and
+ * resumes paced data (see nettcp_cc_ops_t.pacing_rate).
+ */
+void nettcp_timer(netif_t *nif);
+
+#endif
+
@@ -25,5 +25,11 @@
 
 void netudp_input(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr);
 
+/*
+ * UDP-Lite (RFC 3828) input. Datagrams are delivered to the same kind of
+ * socket as UDP datagrams.
+ */
+void netudplite_input(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr);
+
 #endif
 
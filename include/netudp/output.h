@@ -0,0 +1,85 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETUDP_OUTPUT_H_
+#define _NETUDP_OUTPUT_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+#include <netsock/addr.h>
+#include <netprot/opts.h>
+#include <netudp/socket.h>
+
+/*
+ * Sends a datagram over an unconnected socket. The current level of 'pkt' is
+ * the payload. If 'nif' is NULL, the FIB selects the interface; an
+ * unspecified source address is selected as well. 'opts' may be NULL.
+ */
+void netudp_sendto(netif_t *nif, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, const netprot_opts_t *opts);
+
+/*
+ * Sends a UDP-Lite datagram (RFC 3828) over an unconnected socket. Only the
+ * first 'cscov' bytes (including the header) are covered by the checksum;
+ * 0 means the entire datagram. Otherwise like netudp_sendto().
+ */
+void netudplite_sendto(netif_t *nif, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint16_t cscov, const netprot_opts_t *opts);
+
+/*
+ * Connects a socket: Resolves the route and the source address, and builds
+ * the header template. 'nif' and 'opts' may be NULL.
+ * Return 0 on success, non-0 on error.
+ */
+int netudp_connect(netudp_sock_t *sock, netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, const netprot_opts_t *opts);
+
+/*
+ * Connects a socket for UDP-Lite, with a Checksum Coverage of 'cscov' bytes
+ * (0 = entire datagram). Otherwise like netudp_connect().
+ * Return 0 on success, non-0 on error.
+ */
+int netudplite_connect(netudp_sock_t *sock, netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint16_t cscov, const netprot_opts_t *opts);
+
+/*
+ * Disconnects a socket.
+ */
+void netudp_disconnect(netudp_sock_t *sock);
+
+/*
+ * Sends a datagram over a connected socket. The current level of 'pkt' is the
+ * payload. Must only be called by one thread at a time.
+ */
+void netudp_send(netudp_sock_t *sock, netpkt_t *pkt);
+
+/*
+ * Sends 'n' datagrams over a connected socket. The current level of each
+ * packet is the payload. The datagrams are linked into a chain and handed to
+ * the interface in one call. Must only be called by one thread at a time.
+ * Returns the number of datagrams sent; the others are dropped.
+ */
+uint32_t netudp_send_batch(netudp_sock_t *sock, netpkt_t **pkts, uint32_t n);
+
+/*
+ * Sends a large buffer over a connected socket as a series of datagrams of
+ * 'segsz' payload bytes each (the last one may be shorter). The headers are
+ * built once. If the interface has the NETIF_GSO_UDP flag, the segmentation
+ * is left to the interface; otherwise, the stack segments the buffer.
+ * Must only be called by one thread at a time.
+ * Returns the number of datagrams sent.
+ */
+uint32_t netudp_send_gso(netudp_sock_t *sock, netpkt_t *pkt, uint16_t segsz);
+
+#endif
+
@@ -0,0 +1,141 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#ifndef _NETUDP_SOCKET_H_
+#define _NETUDP_SOCKET_H_
+
+#include <netif/if.h>
+#include <netpkt/pkt.h>
+#include <netsock/addr.h>
+#include <netprot/opts.h>
+#include <netstd/packing.h>
+
+/*
+ * Number of slots in the receive ring of a UDP socket. Must be a power of two.
+ */
+#ifndef NETUDP_RX_RING_SIZE
+#define NETUDP_RX_RING_SIZE 256
+#endif
+
+typedef struct netudp_ring_slot{
+	volatile uint32_t  seq;       /* Sequence number; tells, whether the slot is full. */
+	netpkt_t           *pkt;      /* The payload (the current level). */
+	net_sockaddr_t     src_addr;  /* Remote address. */
+	net_sockaddr_t     dst_addr;  /* Local address. */
+} netudp_ring_slot_t;
+
+/*
+ * A bounded multi-producer, single-consumer ring of received datagrams.
+ *
+ * Producers (the receive path, possibly on several threads) claim a slot by
+ * advancing 'head' with compare-and-swap, fill it, and publish it by setting
+ * its sequence number. The consumer (the application) takes slots in order at
+ * 'tail'. Neither side takes a lock.
+ */
+typedef struct netudp_ring{
+	volatile uint32_t   head NETSTD_ALIGNED(NETSTD_CACHELINE);
+	volatile uint32_t   tail NETSTD_ALIGNED(NETSTD_CACHELINE);
+	netudp_ring_slot_t  slots[NETUDP_RX_RING_SIZE] NETSTD_ALIGNED(NETSTD_CACHELINE);
+} netudp_ring_t;
+
+/*
+ * Size of the header template: An IPv6 header and a UDP header.
+ */
+#define NETUDP_TEMPLATE_MAX 48
+
+/*
+ * The transmit state of a connected UDP socket: The prebuilt IP and UDP
+ * headers and the resolved next hop. A send copies the headers and patches
+ * the lengths and checksums.
+ *
+ * The route is resolved again, when the FIB changes.
+ */
+typedef struct netudp_tx_template{
+	netif_t           *nif;       /* Outgoing interface; NULL = not connected. */
+	net_sockaddr_t    src_addr;   /* Local address (resolved). */
+	net_sockaddr_t    dst_addr;   /* Remote address. */
+	union{
+		ipv4_addr_t   v4;
+		ipv6_addr_t   v6;
+	} nexthop;
+	uint32_t          fib_seq;    /* FIB version, the route was resolved with. */
+	uint16_t          ip_sum;     /* IPv4 header checksum, with zero Total Length and ID. */
+	uint8_t           ip_len;     /* Length of the IP header in 'hdr'. */
+	uint8_t           protocol;   /* IP_PROTOCOL_UDP or IP_PROTOCOL_UDPLITE. */
+	uint16_t          cscov;      /* UDP-Lite Checksum Coverage; 0 = entire datagram. */
+	uint8_t           nh_onlink;  /* IPv6: The next hop was taken from the FIB (see netipv6_route()). */
+	uint8_t           hdr[NETUDP_TEMPLATE_MAX]; /* IP header, followed by the UDP header. */
+	
+	/* Parameters of netudp_connect(), to rebuild the template. */
+	netif_t           *conn_nif;
+	net_sockaddr_t    conn_src;
+	netprot_opts_t    opts;
+} netudp_tx_template_t;
+
+/*
+ * A received datagram, as returned by netudp_sock_dequeue_batch().
+ */
+typedef struct netudp_msg{
+	netpkt_t           *pkt;      /* The payload (the current level). */
+	net_sockaddr_t     src_addr;  /* Remote address. */
+	net_sockaddr_t     dst_addr;  /* Local address. */
+} netudp_msg_t;
+
+/*
+ * A UDP socket; referenced by netsock_flow_t.instance.
+ */
+typedef struct netudp_sock{
+	netudp_ring_t       rx;
+	netudp_tx_template_t tx;
+	
+	/* Statistics, updated atomically by the receive path. */
+	volatile uint32_t   rx_drops;   /* Datagrams dropped, because the ring was full. */
+	volatile uint32_t   rx_errors;  /* Datagrams dropped, because of a bad length or checksum. */
+} netudp_sock_t;
+
+/*
+ * Initializes a UDP socket.
+ */
+void netudp_sock_init(netudp_sock_t *sock);
+
+/*
+ * Enqueues a received datagram. May be called concurrently.
+ * Return 0 on success, non-0 if the ring is full.
+ */
+int netudp_sock_enqueue(netudp_sock_t *sock, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr);
+
+/*
+ * Dequeues the oldest datagram, and its addresses (if not NULL). Must only be
+ * called by one thread at a time.
+ * Returns NULL, if the ring is empty.
+ */
+netpkt_t* netudp_sock_dequeue(netudp_sock_t *sock, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr);
+
+/*
+ * Dequeues up to 'max' datagrams at once, in order. Must only be called by
+ * one thread at a time.
+ * Returns the number of datagrams stored in 'msgs'; 0, if the ring is empty.
+ */
+uint32_t netudp_sock_dequeue_batch(netudp_sock_t *sock, netudp_msg_t *msgs, uint32_t max);
+
+/*
+ * Frees all datagrams in the ring. Must only be called by the consumer.
+ */
+void netudp_sock_flush(netudp_sock_t *sock);
+
+#endif
+
@@ -22,7 +22,7 @@
 net_mutex_t net_mutex_new(){
 	pthread_mutex_t* mtx = malloc(sizeof(pthread_mutex_t));
 	if(!mtx) return NET_MUTEX_INVALID;
-	if(pthread_mutex_init(mtx,0)) return mtx;
+	if(!pthread_mutex_init(mtx,0)) return mtx;
 	free(mtx);
 	return NET_MUTEX_INVALID;
 }
@@ -39,3 +39,8 @@ void net_mutex_unlock(net_mutex_t m){
 	pthread_mutex_unlock((pthread_mutex_t*)m);
 }
 
+void net_mutex_free(net_mutex_t m){
+	if(!m) return;
+	pthread_mutex_destroy((pthread_mutex_t*)m);
+	free(m);
+}
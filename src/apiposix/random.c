@@ -0,0 +1,26 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netstd/random.h>
+#include <stdlib.h>
+
+uint32_t net_random_u32(){
+	/*
+	 * random() yields 31 bits, so combine two calls.
+	 */
+	return (((uint32_t)random())<<16) ^ ((uint32_t)random());
+}
+
@@ -22,6 +22,7 @@
 #include <netarp/arp_header.h>
 #include <netif/ifapi.h>
 #include <netif/l2defs.h>
+#include <netipv4/ctrl.h>
 
 #include <netstd/endianness.h>
 
@@ -33,6 +34,7 @@ void netarp_input( netif_t *netif, netpkt_t *pkt ){
 	ipv4_addr_t         target_prot_addr;
 	mac_addr_t          sender_hard_addr;
 	char                create;
+	char                for_me;
 		
 	/* The header must reside in contiguous area of memory. */
 	if( netpkt_pullup(pkt,sizeof(fnet_arp_header_t)) ) goto DROP;
@@ -43,13 +45,16 @@ void netarp_input( netif_t *netif, netpkt_t *pkt ){
 	target_prot_addr = arp_hdr->target_prot_addr;
 	sender_hard_addr = arp_hdr->sender_hard_addr;
 	
+	/* Is the target protocol address one of ours? */
+	for_me = netipv4_addr_is_own(netif,target_prot_addr) ? 1 : 0;
+	
 	/* Check Duplicate IP address.*/
-	if (!IP4ADDR_EQ(sender_prot_addr,netif->ipv4.address)){
+	if (!netipv4_addr_is_own(netif,sender_prot_addr)){
 		/*
 		 * If the target protocol address is ours, we're going to create a new ARP
 		 * cache entry. Otherwise we update it, if it exists.
 		 */
-		create = IP4ADDR_EQ(target_prot_addr,netif->ipv4.address) ? 1 : 0; /* It's for me. */
+		create = for_me;
 		
 		/*
 		 * Create or update ARP entry.
@@ -59,13 +64,14 @@ void netarp_input( netif_t *netif, netpkt_t *pkt ){
 		/*
 		 * Send all network packets out to the 'sender_hard_addr'.
 		 */
-		netif->netif_class->ifapi_send_l2_all(netif,pkt,&sender_hard_addr,NETPROT_L3_ARP);
+		if( chain )
+			netif->netif_class->ifapi_send_l2_all(netif,chain,&sender_hard_addr,NETPROT_L3_IPV4);
 	}else{
 		// TODO: duplicate address detection.
 	}
 	
 	/* ARP request. If it asked for our address, we send out a reply.*/
-	if( (ntoh16(arp_hdr->op) == FNET_ARP_OP_REQUEST) && (IP4ADDR_EQ(target_prot_addr,netif->ipv4.address)) )
+	if( (ntoh16(arp_hdr->op) == FNET_ARP_OP_REQUEST) && for_me )
 	{
 		arp_hdr->op = hton16(FNET_ARP_OP_REPLY); /* Opcode */
 		
@@ -73,7 +79,7 @@ void netarp_input( netif_t *netif, netpkt_t *pkt ){
 		arp_hdr->sender_hard_addr = netif->device_mac;
 		
 		arp_hdr->target_prot_addr = arp_hdr->sender_prot_addr;
-		arp_hdr->sender_prot_addr = netif->ipv4.address;
+		arp_hdr->sender_prot_addr = target_prot_addr; /* Answer for the address, that has been asked for. */
 		
 		netif->netif_class->ifapi_send_l2(netif,pkt,&sender_hard_addr,NETPROT_L3_ARP);
 		return;
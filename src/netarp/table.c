@@ -20,6 +20,15 @@
 #include <netarp/if.h>
 #include <netarp/output.h>
 
+/*
+ * Returns the time, the ARP entry was last known to be in use. Entries
+ * confirmed by upper-layer protocols are thus evicted last.
+ */
+static inline net_time_t netarp_tab_last_used(fnet_arp_entry_t *entry){
+	net_time_t confirm_time = entry->confirm_time;
+	return (confirm_time > entry->cr_time) ? confirm_time : entry->cr_time;
+}
+
 static int netarp_tab_find(netarp_if_t *arpif, ipv4_addr_t prot_addr, char create){
 	int           i,j;
 	net_time_t    cur_time, cur_diff, max_diff;
@@ -53,7 +62,7 @@ static int netarp_tab_find(netarp_if_t *arpif, ipv4_addr_t prot_addr, char creat
 		max_diff = 0;
 		j = NETARP_TABLE_SIZE;
 		for (i = 0; i < NETARP_TABLE_SIZE; ++i){
-			cur_diff = cur_time - arpif->arp_table[i].cr_time;
+			cur_diff = cur_time - netarp_tab_last_used(&(arpif->arp_table[i]));
 			if(cur_diff > max_diff){
 				max_diff = cur_diff;
 				j = i;
@@ -91,8 +100,7 @@ netpkt_t *netarp_tab_update( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t h
 	/*
 	 * Pull the ARP entry's send queue.
 	 */
-	chain = arpif->arp_table[i].hold;
-	arpif->arp_table[i].hold = 0;
+	chain = netpkt_queue_flush(&(arpif->arp_table[i].hold), &(arpif->hold_stats));
 	arpif->arp_table[i].hold_time = 0;
 	arpif->arp_table[i].cr_time = net_timer_ms();
 	
@@ -120,7 +128,7 @@ static int netarp_tab_create(netarp_if_t *arpif){
 		max_diff = 0;
 		j = NETARP_TABLE_SIZE;
 		for (i = 0; i < NETARP_TABLE_SIZE; ++i){
-			cur_diff = cur_time - arpif->arp_table[i].cr_time;
+			cur_diff = cur_time - netarp_tab_last_used(&(arpif->arp_table[i]));
 			if(cur_diff > max_diff){
 				max_diff = cur_diff;
 				j = i;
@@ -136,7 +144,7 @@ static int netarp_tab_create(netarp_if_t *arpif){
 int netarp_tab_lookup( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t *hard_addr, netpkt_t *pkt){
 	int           i,ret,created;
 	netarp_if_t   *arpif;
-	netpkt_t      *chain;
+	netpkt_t      *chain, *next;
 	
 	arpif = netif->arp;
 	
@@ -148,7 +156,6 @@ int netarp_tab_lookup( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t *hard_a
 	/* Find an entry to update. */
 	for (i = 0; i < NETARP_TABLE_SIZE; ++i){
 		if(!( arpif->arp_table[i].used )) continue;
-		if(!( arpif->arp_table[i].resolved )) continue;
 		/*
 		 * Check if the source IP address of the incoming packet matches
 		 * the IP address in this ARP table entry.
@@ -164,8 +171,8 @@ int netarp_tab_lookup( netif_t *netif, ipv4_addr_t prot_addr, mac_addr_t *hard_a
 	
 	i = netarp_tab_create(arpif);
 	
-	chain = arpif->arp_table[i].hold;
-	arpif->arp_table[i].hold = 0;
+	arpif->hold_stats.drops_evict += arpif->arp_table[i].hold.length;
+	chain = netpkt_queue_flush(&(arpif->arp_table[i].hold), &(arpif->hold_stats));
 	arpif->arp_table[i].prot_addr = prot_addr;
 	arpif->arp_table[i].used      = 1;
 	arpif->arp_table[i].resolved  = 0;
@@ -180,14 +187,18 @@ ENDFUNC:
 		*hard_addr = arpif->arp_table[i].hard_addr;
 	}else{
 		/* An unresolved ARP entry was found or created. */
-		pkt->next_chain = arpif->arp_table[i].hold;
-		arpif->arp_table[i].hold = pkt;
+		for(; pkt ; pkt = next){
+			next = pkt->next_chain;
+			netpkt_queue_enqueue(
+				&(arpif->arp_table[i].hold), &(arpif->hold_stats), pkt,
+				NETARP_HOLD_MAX, NETARP_HOLD_TOTAL_MAX, &chain);
+		}
 	}
 	
 	net_mutex_unlock(arpif->arp_lock);
 	
 	/*
-	 * Free the chain of the preempted ARP entry, if any.
+	 * Free the chain of the preempted ARP entry and the dropped packets, if any.
 	 */
 	if(chain)
 		netpkt_free_all(chain);
@@ -197,3 +208,23 @@ ENDFUNC:
 	return ret;
 }
 
+void netarp_confirm_reachable( netif_t *netif, ipv4_addr_t prot_addr){
+	netarp_if_t   *arpif;
+	int           i;
+	
+	arpif = netif->arp;
+	
+	if(! arpif ) return;
+	
+	/*
+	 * Lock-free, like netnd6_confirm_reachable(). A race with an entry being
+	 * recycled is harmless: it only affects the eviction order.
+	 */
+	for (i = 0; i < NETARP_TABLE_SIZE; ++i){
+		if(!( arpif->arp_table[i].used )) continue;
+		if(!( arpif->arp_table[i].resolved )) continue;
+		if(! IP4ADDR_EQ(prot_addr,arpif->arp_table[i].prot_addr) )continue;
+		arpif->arp_table[i].confirm_time = net_timer_ms();
+		return;
+	}
+}
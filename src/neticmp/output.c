@@ -21,8 +21,14 @@
 #include <neticmp/icmp_header.h>
 #include <netipv4/output.h>
 #include <netipv4/hldefs.h>
+#include <netipv4/defs.h>
+#include <netipv4/ipv4_header.h>
 #include <netprot/defaults.h>
 #include <netprot/checksum.h>
+#include <netstd/endianness.h>
+
+/* RFC 1812 4.3.2.3: The ICMP datagram SHOULD NOT exceed 576 bytes. */
+#define NETICMP_ERROR_MAX  576u
 
 void neticmp_output(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
 	fnet_icmp_header_t *hdr;
@@ -30,7 +36,82 @@ void neticmp_output(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_so
 	hdr           = netpkt_data(pkt);
 	/* Checksum calculation.*/
 	hdr->checksum = 0u;
-	hdr->checksum = netprot_checksum_buf((void*)hdr,NETPKT_LENGTH(pkt));
+	hdr->checksum = netprot_checksum(pkt,NETPKT_LENGTH(pkt));
 	
 	netipv4_output(nif,pkt,src_addr,dst_addr,IP_PROTOCOL_ICMP, IP_TOS_NORMAL, IP_TTL_DEFAULT, /*DF=*/0, /*dont_route=*/0 );
 }
+
+void neticmp_error(netif_t *nif,netpkt_t *pkt,uint32_t protocol, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr,uint8_t type,uint8_t code,uint32_t param){
+	fnet_ip_header_t        *ip_header;
+	fnet_icmp_err_header_t  *err_header;
+	uint8_t                 *icmp_type;
+	uint32_t                size;
+	
+	/*******************************************************************
+	 * RFC 1122 3.2.2:
+	 * An ICMP error message MUST NOT be sent as the result of
+	 * receiving:
+	 *******************************************************************/
+	/* An ICMP error message. */
+	if( protocol == IP_PROTOCOL_ICMP ){
+		if( netpkt_pullup(pkt,1) ) goto DROP;
+		icmp_type = netpkt_data(pkt);
+		if(! FNET_ICMP_IS_QUERY_TYPE(*icmp_type) ) goto DROP;
+	}
+	
+	/*
+	 * A datagram destined to an IP broadcast or IP multicast address.
+	 * A datagram sent as a link-layer broadcast.
+	 */
+	if( pkt->flags & (NETPKT_FLAG_BROAD_L3|NETPKT_FLAG_BROAD_L2) ) goto DROP;
+	if( IP4_ADDR_IS_MULTICAST(dst_addr->ip.v4) ) goto DROP;
+	
+	/*
+	 * A datagram whose source address does not define a single host --
+	 * e.g., a zero address, a loopback address, a broadcast address, a
+	 * multicast address, or a Class E address.
+	 */
+	if(
+		IP4_ADDR_IS_UNSPECIFIED(src_addr->ip.v4) ||
+		IP4_ADDR_IS_LOOPBACK(src_addr->ip.v4) ||
+		IP4ADDR_EQ(src_addr->ip.v4,IP4_ADDR_BROADCAST) ||
+		IP4_ADDR_IS_MULTICAST(src_addr->ip.v4) ||
+		IP4_CLASS_E(src_addr->ip.v4)
+	) goto DROP;
+	
+	/* Select the IP header. */
+	if( netpkt_switchlevel(pkt,-1) ) goto DROP;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_ip_header_t)) ) goto DROP;
+	
+	ip_header = netpkt_data(pkt);
+	
+	/* A fragment other than the first. */
+	if( ntoh16(ip_header->flags_fragment_offset) & FNET_IP_OFFSET_MASK ) goto DROP;
+	
+	/*
+	 * The error message quotes the original datagram, starting with its IP
+	 * header, so it is built on the level above, starting at the IP header.
+	 */
+	if( netpkt_levelup(pkt) ) goto DROP;
+	
+	size = NETICMP_ERROR_MAX - sizeof(fnet_ip_header_t) - sizeof(fnet_icmp_err_header_t);
+	if( NETPKT_LENGTH(pkt) > size )
+		netpkt_setlength(pkt,size);
+	
+	/* Construct ICMP error header.*/
+	if( netpkt_pushfront( pkt, sizeof(fnet_icmp_err_header_t) ) ) goto DROP;
+	
+	if( netpkt_pullup_lite( pkt, sizeof(fnet_icmp_err_header_t) ) ) goto DROP;
+	
+	err_header = netpkt_data(pkt);
+	err_header->header.type = type;
+	err_header->header.code = code;
+	err_header->data        = hton32(param);
+	
+	neticmp_output(nif,pkt,dst_addr,src_addr);
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
@@ -23,6 +23,7 @@
 #include <netipv6/defs.h>
 #include <netipv6/if.h>
 #include <netnd6/receive.h>
+#include <netmld/input.h>
 #include <netprot/checksum.h>
 #include <netprot/notify.h>
 #include <netstd/endianness.h>
@@ -81,8 +82,7 @@ void neticmp6_input(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_so
 	 * Multicast Listener Query.
 	 **************************/
 	case FNET_ICMP6_TYPE_MULTICAST_LISTENER_QUERY:
-		//fnet_mld_query_receive(netif, src_ip, dest_ip, nb, ip6_nb);
-		netpkt_free(pkt);
+		netmld_query_receive(nif,pkt,&src_ip);
 		break;
 	/**************************
 	 * Echo Request.
@@ -27,10 +27,6 @@
 
 #include <netstd/endianness.h>
 
-/* TODO: move this elsewhere. */
-#define FNET_IP6_DEFAULT_MTU     1280u   /* Minimum IPv6 datagram size which    
-                                          * must be supported by all IPv6 hosts */
-
 void neticmp6_output(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr,uint8_t hop_limit){
 	fnet_icmp6_header_t                     *hdr;
 	uint16_t                                checksum;
@@ -38,7 +34,7 @@ void neticmp6_output(netif_t *nif,netpkt_t *pkt, net_sockaddr_t *src_addr, net_s
 	hdr           = netpkt_data(pkt);
 	/* Checksum calculation.*/
 	hdr->checksum = 0u;
-	checksum = netprot_checksum_pseudo_start(pkt,IP_PROTOCOL_ICMP6,(uint16_t)NETPKT_LENGTH(pkt));
+	checksum = netprot_checksum_pseudo_start(pkt,IP_PROTOCOL_ICMP6,NETPKT_LENGTH(pkt));
 	hdr->checksum = netprot_checksum_pseudo_end(
 			checksum,
 			(uint8_t*)&(src_addr->ip.v6),
@@ -112,8 +108,8 @@ void neticmp6_error(netif_t *nif,netpkt_t *pkt,uint32_t protocol, net_sockaddr_t
 	/* Increase the pkt->level up to 3, if below. */
 	while(pkt->level<3) netpkt_levelup(pkt);
 	
-	/* Limit to FNET_IP6_DEFAULT_MTU. */
-	size = FNET_IP6_DEFAULT_MTU - sizeof(fnet_icmp6_err_header_t) + sizeof(fnet_ip6_header_t);
+	/* Limit to IP6_DEFAULT_MTU. */
+	size = IP6_DEFAULT_MTU - sizeof(fnet_icmp6_err_header_t) + sizeof(fnet_ip6_header_t);
         if( NETPKT_LENGTH(pkt) > size)
 		netpkt_setlength(pkt,size);
 	
@@ -0,0 +1,194 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#include <netif/addrclass.h>
+#include <netipv4/defs.h>
+#include <netipv6/defs.h>
+#include <netipv6/if.h>
+#include <netipv4/if.h>
+#include <netstd/hash.h>
+#include <netstd/seqlock.h>
+#include <netstd/mem.h>
+
+#define NETIF_ADDRCLASS_MASK (NETIF_ADDRCLASS_SIZE-1)
+
+static const ipv6_addr_t   ip6_addr_nodelocal_allnodes       = IP6_ADDR_NODELOCAL_ALLNODES_INIT;
+static const ipv6_addr_t   ip6_addr_linklocal_allnodes       = IP6_ADDR_LINKLOCAL_ALLNODES_INIT;
+
+static inline void netif_addrclass_map4(ipv6_addr_t *addr, ipv4_addr_t addr4){
+	addr->addr32[0] = 0;
+	addr->addr32[1] = 0;
+	addr->addr[8]   = 0x00;
+	addr->addr[9]   = 0x00;
+	addr->addr[10]  = 0xff;
+	addr->addr[11]  = 0xff;
+	addr->addr32[3] = addr4;
+}
+
+/*
+ * Adds an address, or adds 'klass' to an address, that is already in the
+ * table. So an address, that is in the table, has all of its classes.
+ */
+static void netif_addrclass_add(netif_addrclass_t *ac, const ipv6_addr_t *addr, uint8_t klass, uint32_t *count){
+	uint32_t i;
+	
+	for(i = net_hash128(addr->addr32) ; ; i++){
+		i &= NETIF_ADDRCLASS_MASK;
+		if(! ac->table[i].klass ) break;
+		if( IP6ADDR_EQ(ac->table[i].addr,*addr) ){
+			ac->table[i].klass |= klass;
+			return;
+		}
+	}
+	
+	/* Keep the table at most half full, so that probe sequences stay short. */
+	if( *count >= (NETIF_ADDRCLASS_SIZE/2) ){
+		ac->overflow = 1;
+		return;
+	}
+	
+	ac->table[i].addr  = *addr;
+	ac->table[i].klass = klass;
+	(*count)++;
+}
+
+static void netif_addrclass_add4(netif_addrclass_t *ac, ipv4_addr_t addr4, uint8_t klass, uint32_t *count){
+	ipv6_addr_t addr;
+	
+	netif_addrclass_map4(&addr,addr4);
+	netif_addrclass_add(ac,&addr,klass,count);
+}
+
+void netif_addrclass_rebuild(netif_t *nif){
+	netif_addrclass_t   *ac;
+	netipv6_if_t        *nif6;
+	netipv4_if_t        *nif4;
+	uint32_t            count = 0, j;
+	int                 i;
+	
+	ac = nif->addrclass;
+	
+	if(! ac ) return;
+	
+	net_mutex_lock(ac->lock);
+	
+	net_seq_write_begin(&(ac->seq));
+	
+	net_bzero(ac->table,sizeof(ac->table));
+	ac->overflow = 0;
+	
+	/*
+	 * IPv6 unicast addresses and their solicited-node groups first: They are
+	 * few (NETIPV6_IF_ADDR_MAX), and ND depends on them.
+	 */
+	nif6 = nif->ipv6;
+	if( nif6 ){
+		for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
+			/* Skip NOT_USED addresses. */
+			if( !nif6->addrs[i].used ) continue;
+			
+			netif_addrclass_add(ac,&(nif6->addrs[i].address),NETIF_ADDRCLASS_LOCAL,&count);
+			
+			/* The Solicited Multicast address is only set, if ND6 is supported. */
+			if( IP6_ADDR_IS_MULTICAST(nif6->addrs[i].solicited_multicast_addr) )
+				netif_addrclass_add(ac,&(nif6->addrs[i].solicited_multicast_addr),NETIF_ADDRCLASS_SOLICITED,&count);
+		}
+	}
+	
+	/*
+	 * IPv4.
+	 */
+	if(! IP4_ADDR_IS_UNSPECIFIED(nif->ipv4.address) )
+		netif_addrclass_add4(ac,nif->ipv4.address,NETIF_ADDRCLASS_LOCAL,&count);
+	
+	netif_addrclass_add4(ac,IP4_ADDR_BROADCAST,NETIF_ADDRCLASS_BROADCAST,&count);          /* Limited broadcast */
+	netif_addrclass_add4(ac,0,NETIF_ADDRCLASS_BROADCAST,&count);
+	netif_addrclass_add4(ac,IP4_ADDR_LINK_LOCAL_BROADCAST,NETIF_ADDRCLASS_BROADCAST,&count); /* Link-local broadcast (RFC3927)*/
+	netif_addrclass_add4(ac,nif->ipv4.netbroadcast,NETIF_ADDRCLASS_BROADCAST,&count);
+	netif_addrclass_add4(ac,nif->ipv4.subnetbroadcast,NETIF_ADDRCLASS_BROADCAST,&count);
+	netif_addrclass_add4(ac,nif->ipv4.subnet,NETIF_ADDRCLASS_BROADCAST,&count);
+	
+	nif4 = nif->ipv4_addrs;
+	if( nif4 ){
+		net_mutex_lock(nif4->lock);
+		for(j=0;j<NETIPV4_IF_SUBNET_MAX;++j){
+			if( !nif4->subnets[j].refc ) continue;
+			netif_addrclass_add4(ac,nif4->subnets[j].subnetbroadcast,NETIF_ADDRCLASS_BROADCAST,&count);
+			netif_addrclass_add4(ac,nif4->subnets[j].subnet,NETIF_ADDRCLASS_BROADCAST,&count);
+		}
+		for(j=0;j<NETIPV4_IF_ADDR_TAB;++j){
+			if( !nif4->table[j].used ) continue;
+			netif_addrclass_add4(ac,nif4->table[j].address,NETIF_ADDRCLASS_LOCAL,&count);
+		}
+		net_mutex_unlock(nif4->lock);
+	}
+	
+	/*
+	 * IPv6 multicast groups.
+	 */
+	if( nif6 ){
+		netif_addrclass_add(ac,&ip6_addr_nodelocal_allnodes,NETIF_ADDRCLASS_MULTICAST,&count);
+		netif_addrclass_add(ac,&ip6_addr_linklocal_allnodes,NETIF_ADDRCLASS_MULTICAST,&count);
+		
+		net_mutex_lock(nif6->mcast_lock);
+		for(j=0;j<nif6->multicasts.size;++j){
+			if( !nif6->multicasts.entries[j].used ) continue;
+			if( !nif6->multicasts.entries[j].refc ) continue;
+			
+			netif_addrclass_add(ac,&(nif6->multicasts.entries[j].multicast),NETIF_ADDRCLASS_MULTICAST,&count);
+		}
+		net_mutex_unlock(nif6->mcast_lock);
+	}
+	
+	net_seq_write_end(&(ac->seq));
+	
+	net_mutex_unlock(ac->lock);
+}
+
+int netif_addrclass_get6(netif_t *nif, const ipv6_addr_t *addr){
+	netif_addrclass_t   *ac;
+	uint32_t            seq, i, n;
+	int                 klass;
+	
+	ac = nif->addrclass;
+	
+	do{
+		seq = net_seq_read_begin(&(ac->seq));
+		
+		klass = 0;
+		i = net_hash128(addr->addr32);
+		for(n = 0 ; n < NETIF_ADDRCLASS_SIZE ; n++, i++){
+			i &= NETIF_ADDRCLASS_MASK;
+			if(! ac->table[i].klass ) break;
+			if( IP6ADDR_EQ(ac->table[i].addr,*addr) ){
+				klass = ac->table[i].klass;
+				break;
+			}
+		}
+		if( (! klass) && ac->overflow ) klass = NETIF_ADDRCLASS_OVERFLOW;
+	}while( net_seq_read_retry(&(ac->seq),seq) );
+	
+	return klass;
+}
+
+int netif_addrclass_get4(netif_t *nif, ipv4_addr_t addr4){
+	ipv6_addr_t addr;
+	
+	netif_addrclass_map4(&addr,addr4);
+	return netif_addrclass_get6(nif,&addr);
+}
+
@@ -31,6 +31,8 @@
 #include <netnd6/table.h>
 #include <netnd6/send.h>
 
+#include <netarp/table.h>
+
 
 /************************************************************************
  * Ethernet Multicast Address
@@ -85,13 +87,9 @@ void netif_send_l2_all(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t prot
 	netpkt_free_all(pkt);
 }
 
-/**
- * @brief Default implementation of netif_api->ifapi_send_l3_ipv4.
- * @param nif   netif-instance
- * @param pkt   network packet
- * @param pkt   destination IPv4-address (Pointer)
- */
-void netif_api_send_l3_ipv4(netif_t* nif,netpkt_t* pkt,void* addr){
+typedef void (*send2_t)(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t protocol);
+
+static void netif_api_send_l3_ipv4_gen(netif_t* nif,netpkt_t* pkt,void* addr, send2_t send2){
 	mac_addr_t macaddr; /* 48-bit destination address */
 	ipv4_addr_t ipaddr;
 	
@@ -108,18 +106,34 @@ void netif_api_send_l3_ipv4(netif_t* nif,netpkt_t* pkt,void* addr){
 	}else if(IP4_ADDR_IS_MULTICAST(ipaddr)) {
 		FNET_ETH_MULTICAST_IP4_TO_MAC(ipaddr,macaddr.mac);
 	}else{
-		/* Unicast address. */
+		/* Unicast address. The whole chain is held, if unresolved. */
 		if(! netarp_tab_lookup(nif,ipaddr,&macaddr,pkt) ) return;
 	}
-	nif->netif_class->ifapi_send_l2(nif,pkt,&macaddr,NETPROT_L3_IPV4);
+	send2(nif,pkt,&macaddr,NETPROT_L3_IPV4);
 }
 
-static inline void netif_enqueue_chain(netpkt_t* pkt, netpkt_t* ll){
-	while(pkt->next_chain) pkt = pkt->next_chain;
-	pkt->next_chain = ll;
+/**
+ * @brief Default implementation of netif_api->ifapi_send_l3_ipv4.
+ * @param nif   netif-instance
+ * @param pkt   network packet
+ * @param pkt   destination IPv4-address (Pointer)
+ */
+void netif_api_send_l3_ipv4(netif_t* nif,netpkt_t* pkt,void* addr){
+	pkt->next_chain = 0;
+	netif_api_send_l3_ipv4_gen( nif, pkt, addr, nif->netif_class->ifapi_send_l2 );
 }
 
-typedef void (*send2_t)(netif_t* nif,netpkt_t* pkt,mac_addr_t* addr,uint16_t protocol);
+/**
+ * @brief Default implementation of netif_api->ifapi_send_l3_ipv4_all.
+ * @param nif   netif-instance
+ * @param pkt   network packet
+ * @param pkt   destination IPv4-address (Pointer)
+ *
+ * This function sends an entire chain of packets at once.
+ */
+void netif_api_send_l3_ipv4_all(netif_t* nif,netpkt_t* pkt,void* addr){
+	netif_api_send_l3_ipv4_gen( nif, pkt, addr, nif->netif_class->ifapi_send_l2_all );
+}
 
 static void netif_api_send_l3_ipv6_gen(netif_t* nif,netpkt_t* pkt, void* srcaddr,void* addr, send2_t send2){
 	hwaddr_t      hwaddr;
@@ -143,14 +157,16 @@ static void netif_api_send_l3_ipv6_gen(netif_t* nif,netpkt_t* pkt, void* srcaddr
 	 ********************************************/
 	else{
 		fnet_nd6_neighbor_entry_t *neighbor;
+		netpkt_t *next, *drops = 0;
 		char send_solicitation = 0;
 		
 		/*
 		 * Detecting, whether ipaddr os on-link; 1st pass.
 		 *
-		 * This can be done without the need to hold the nd6-lock.
+		 * This can be done without the need to hold the nd6-lock. A next hop,
+		 * that the caller has taken from the FIB, is on-link.
 		 */
-		char is_onlink = IP6_ADDR_IS_LINKLOCAL(ipaddr) ? 1 : 0;
+		char is_onlink = ( IP6_ADDR_IS_LINKLOCAL(ipaddr) || (pkt->flags & NETPKT_FLAG_NH_ONLINK) ) ? 1 : 0;
 		
 		if(srcaddr)
 			ipsrc  = *((ipv6_addr_t*)srcaddr);
@@ -238,9 +254,15 @@ static void netif_api_send_l3_ipv6_gen(netif_t* nif,netpkt_t* pkt, void* srcaddr
 			
 		if(neighbor->state == FNET_ND6_NEIGHBOR_STATE_INCOMPLETE)
 		{
-			netif_enqueue_chain(pkt,neighbor->waiting_pkts);
-			neighbor->waiting_pkts = pkt;
+			for(; pkt ; pkt = next){
+				next = pkt->next_chain;
+				netpkt_queue_enqueue(
+					&(neighbor->waiting_pkts), &(nif->nd6->waiting_stats), pkt,
+					FNET_ND6_WAITING_PKTS_MAX, FNET_ND6_WAITING_PKTS_TOTAL_MAX, &drops);
+			}
 			net_mutex_unlock(nif->nd6->nd6_lock);
+			if( drops )
+				netpkt_free_all(drops);
 			if( send_solicitation ) 
 				netnd6_neighbor_solicitation_send(nif, &ipsrc, 0 /* NULL for AR */, &ipaddr);
 			return;
@@ -19,8 +19,18 @@
 #include <netipv4/check.h>
 
 #include <netipv4/defs.h>
+#include <netipv4/ctrl.h>
+#include <netif/addrclass.h>
 
 int netipv4_addr_is_broadcast(netif_t *nif,ipv4_addr_t addr){
+	int klass;
+	
+	/* If the table has overflowed, a miss is checked below. */
+	if( nif && nif->addrclass ){
+		klass = netif_addrclass_get4(nif,addr);
+		if(! (klass & NETIF_ADDRCLASS_OVERFLOW) )
+			return (klass & NETIF_ADDRCLASS_BROADCAST) ? 1 : 0;
+	}
 	
 	if(
 		IP4ADDR_EQ(addr,IP4_ADDR_BROADCAST)|| /* Limited broadcast */
@@ -33,7 +43,28 @@ int netipv4_addr_is_broadcast(netif_t *nif,ipv4_addr_t addr){
 		IP4ADDR_EQ(addr,nif->ipv4.subnetbroadcast)||
 		IP4ADDR_EQ(addr,nif->ipv4.subnet)
 	) return 1;
-	return 0;
+	return netipv4_addr_in_subnets(nif,addr,1);
+}
+
+int netipv4_addr_classify(netif_t *nif,ipv4_addr_t addr){
+	int klass;
+	
+	if( nif->addrclass ){
+		klass = netif_addrclass_get4(nif,addr);
+		
+		/*
+		 * The classification table may not hold all additional addresses, if
+		 * there are too many of them. Then a miss is checked below.
+		 */
+		if(! (klass & NETIF_ADDRCLASS_OVERFLOW) ) return klass;
+	}
+	
+	klass = 0;
+	if( netipv4_addr_is_broadcast(nif,addr) )
+		klass |= NETIF_ADDRCLASS_BROADCAST;
+	if( netipv4_addr_is_own(nif,addr) )
+		klass |= NETIF_ADDRCLASS_LOCAL;
+	return klass;
 }
 
 int netipv4_addr_is_onlink(netif_t *nif,ipv4_addr_t addr){
@@ -43,6 +74,10 @@ int netipv4_addr_is_onlink(netif_t *nif,ipv4_addr_t addr){
 		 * Is the IPv4 address on-link?
 		 */
 		IP4ADDR_EQ( (nif->ipv4.subnetmask & addr) , nif->ipv4.subnet ) ||
+		/*
+		 * Is it in one of the secondary subnets?
+		 */
+		netipv4_addr_in_subnets(nif,addr,0) ||
 		/* RFC3927: If the destination address is in the 169.254/16 prefix, then the sender
 		 * MUST send its packet directly to the destination on the same physical link.  This MUST be
 		 * done whether the interface is configured with a Link-Local or a routable IPv4 address.
@@ -0,0 +1,223 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv4/ctrl.h>
+#include <netipv4/if.h>
+#include <netipv4/defs.h>
+#include <netif/addrclass.h>
+#include <netstd/hash.h>
+#include <netstd/seqlock.h>
+
+#define ADDR_TAB_MASK (NETIPV4_IF_ADDR_TAB-1)
+
+/*
+ * Returns the slot of the address, or NETIPV4_IF_ADDR_TAB if not found.
+ */
+static uint32_t netipv4_addr_find(netipv4_if_t *nif4, ipv4_addr_t addr){
+	uint32_t i,n;
+	
+	for(i = net_hash32(addr)&ADDR_TAB_MASK, n = 0 ; n < NETIPV4_IF_ADDR_TAB ; n++, i = (i+1)&ADDR_TAB_MASK){
+		if(! nif4->table[i].used ) break;
+		if( IP4ADDR_EQ(nif4->table[i].address,addr) ) return i;
+	}
+	return NETIPV4_IF_ADDR_TAB;
+}
+
+/* The hash of an address table entry. */
+#define ADDR_HOME(e) net_hash32((e)->address)
+
+/*
+ * Removes the entry at slot 'i' (backward shift deletion).
+ */
+static void netipv4_addr_remove(netipv4_if_t *nif4, uint32_t i){
+	NET_HASH_REMOVE(nif4->table,i,ADDR_TAB_MASK,ADDR_HOME);
+	nif4->count--;
+}
+
+int netipv4_bind_addr_prv(netif_t *nif, ipv4_addr_t addr, ipv4_addr_t subnetmask){
+	netipv4_if_t *nif4;
+	uint32_t i,s,free_s;
+	ipv4_addr_t subnet;
+	int result = -1;
+	
+	nif4 = nif->ipv4_addrs;
+	if(! nif4 ) return -1;
+	
+	if( IP4_ADDR_IS_UNSPECIFIED(addr) || IP4_ADDR_IS_MULTICAST(addr) ) return -1;
+	
+	subnet = addr & subnetmask;
+	
+	net_mutex_lock(nif4->lock);
+	
+	/* Already bound? */
+	if( netipv4_addr_find(nif4,addr) < NETIPV4_IF_ADDR_TAB ){
+		result = 0;
+		goto UNLOCK;
+	}
+	
+	if( nif4->count >= NETIPV4_IF_ADDR_MAX ) goto UNLOCK;
+	
+	/* Find the subnet, or a free subnet slot. */
+	free_s = NETIPV4_IF_SUBNET_MAX;
+	for(s = 0 ; s < NETIPV4_IF_SUBNET_MAX ; ++s){
+		if(! nif4->subnets[s].refc ){
+			if( free_s == NETIPV4_IF_SUBNET_MAX ) free_s = s;
+			continue;
+		}
+		if( IP4ADDR_EQ(nif4->subnets[s].subnet,subnet) && IP4ADDR_EQ(nif4->subnets[s].subnetmask,subnetmask) ) break;
+	}
+	if( s == NETIPV4_IF_SUBNET_MAX ){
+		s = free_s;
+		if( s == NETIPV4_IF_SUBNET_MAX ) goto UNLOCK;
+	}
+	
+	net_seq_write_begin(&(nif4->seq));
+	
+	if(! nif4->subnets[s].refc ){
+		nif4->subnets[s].subnet          = subnet;
+		nif4->subnets[s].subnetmask      = subnetmask;
+		nif4->subnets[s].subnetbroadcast = subnet | ~subnetmask;
+		nif4->subnets[s].address         = addr;
+	}
+	nif4->subnets[s].refc++;
+	
+	for(i = net_hash32(addr)&ADDR_TAB_MASK ; nif4->table[i].used ; i = (i+1)&ADDR_TAB_MASK);
+	nif4->table[i].address = addr;
+	nif4->table[i].subnet  = (uint8_t)s;
+	nif4->table[i].used    = 1;
+	nif4->count++;
+	
+	net_seq_write_end(&(nif4->seq));
+	result = 0;
+UNLOCK:
+	net_mutex_unlock(nif4->lock);
+	
+	if(! result )
+		netif_addrclass_rebuild(nif);
+	return result;
+}
+
+int netipv4_unbind_addr_prv(netif_t *nif, ipv4_addr_t addr){
+	netipv4_if_t *nif4;
+	netipv4_if_subnet_t *subnet;
+	uint32_t i,j;
+	
+	nif4 = nif->ipv4_addrs;
+	if(! nif4 ) return -1;
+	
+	net_mutex_lock(nif4->lock);
+	
+	i = netipv4_addr_find(nif4,addr);
+	if( i >= NETIPV4_IF_ADDR_TAB ){
+		net_mutex_unlock(nif4->lock);
+		return -1;
+	}
+	
+	net_seq_write_begin(&(nif4->seq));
+	
+	subnet = &(nif4->subnets[nif4->table[i].subnet]);
+	netipv4_addr_remove(nif4,i);
+	
+	/* Drop the subnet, or pick another source address for it. */
+	if(! --(subnet->refc) ) goto DONE;
+	if(! IP4ADDR_EQ(subnet->address,addr) ) goto DONE;
+	for(j = 0 ; j < NETIPV4_IF_ADDR_TAB ; ++j){
+		if(! nif4->table[j].used ) continue;
+		if( (nif4->subnets + nif4->table[j].subnet) != subnet ) continue;
+		subnet->address = nif4->table[j].address;
+		break;
+	}
+DONE:
+	net_seq_write_end(&(nif4->seq));
+	
+	net_mutex_unlock(nif4->lock);
+	
+	netif_addrclass_rebuild(nif);
+	return 0;
+}
+
+int netipv4_addr_is_own(netif_t *nif, ipv4_addr_t addr){
+	netipv4_if_t *nif4;
+	uint32_t seq;
+	int result;
+	
+	if( IP4ADDR_EQ(nif->ipv4.address,addr) ) return 1;
+	
+	nif4 = nif->ipv4_addrs;
+	if(! nif4 ) return 0;
+	
+	do{
+		seq = net_seq_read_begin(&(nif4->seq));
+		
+		result = netipv4_addr_find(nif4,addr) < NETIPV4_IF_ADDR_TAB;
+	}while( net_seq_read_retry(&(nif4->seq),seq) );
+	
+	return result;
+}
+
+ipv4_addr_t netipv4_select_src_addr(netif_t *nif, ipv4_addr_t dest){
+	netipv4_if_t *nif4;
+	ipv4_addr_t result;
+	uint32_t seq, s;
+	
+	nif4 = nif->ipv4_addrs;
+	
+	/* The primary subnet comes first. */
+	if( (! nif4) || IP4ADDR_EQ( (nif->ipv4.subnetmask & dest) , nif->ipv4.subnet ) )
+		return nif->ipv4.address;
+	
+	do{
+		seq = net_seq_read_begin(&(nif4->seq));
+		
+		result = nif->ipv4.address;
+		for(s = 0 ; s < NETIPV4_IF_SUBNET_MAX ; ++s){
+			if(! nif4->subnets[s].refc ) continue;
+			if(! IP4ADDR_EQ( (nif4->subnets[s].subnetmask & dest) , nif4->subnets[s].subnet ) ) continue;
+			result = nif4->subnets[s].address;
+			break;
+		}
+	}while( net_seq_read_retry(&(nif4->seq),seq) );
+	
+	return result;
+}
+
+int netipv4_addr_in_subnets(netif_t *nif, ipv4_addr_t addr, int broadcast){
+	netipv4_if_t *nif4;
+	uint32_t seq, s;
+	int result;
+	
+	nif4 = nif->ipv4_addrs;
+	if(! nif4 ) return 0;
+	
+	do{
+		seq = net_seq_read_begin(&(nif4->seq));
+		
+		result = 0;
+		for(s = 0 ; s < NETIPV4_IF_SUBNET_MAX ; ++s){
+			if(! nif4->subnets[s].refc ) continue;
+			if( broadcast ){
+				if(! ( IP4ADDR_EQ(addr,nif4->subnets[s].subnetbroadcast) || IP4ADDR_EQ(addr,nif4->subnets[s].subnet) ) ) continue;
+			}else{
+				if(! IP4ADDR_EQ( (nif4->subnets[s].subnetmask & addr) , nif4->subnets[s].subnet ) ) continue;
+			}
+			result = 1;
+			break;
+		}
+	}while( net_seq_read_retry(&(nif4->seq),seq) );
+	
+	return result;
+}
+
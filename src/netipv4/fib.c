@@ -0,0 +1,370 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv4/fib.h>
+#include <netipv4/defs.h>
+#include <netipv4/check.h>
+#include <netstd/endianness.h>
+#include <netstd/hash.h>
+#include <netstd/seqlock.h>
+#include <netstd/mem.h>
+
+#define FIB_EXT          0x8000u
+#define FIB_IDX          0x7fffu
+#define FIB_TBL24_SIZE   (1u<<24)
+#define FIB_TBL8_SIZE    (NETIPV4_FIB_TBL8_MAX<<8)
+#define ROUTE_TAB_MASK   (NETIPV4_FIB_ROUTE_TAB-1)
+
+netipv4_fib_t *netipv4_fib = 0;
+
+/* Netmask of a prefix length, in host byte order. */
+static inline uint32_t netipv4_fib_mask(uint8_t length){
+	return length ? (0xffffffffu << (32-length)) : 0;
+}
+
+/*
+ * Returns the slot of the route, or NETIPV4_FIB_ROUTE_TAB if not found.
+ */
+static uint32_t netipv4_fib_route_find(netipv4_fib_t *fib, ipv4_addr_t prefix, uint8_t length){
+	uint32_t i,n;
+	
+	for(i = net_hash32((uint32_t)prefix ^ length)&ROUTE_TAB_MASK, n = 0 ; n < NETIPV4_FIB_ROUTE_TAB ; n++, i = (i+1)&ROUTE_TAB_MASK){
+		if(! fib->routes[i].used ) break;
+		if( IP4ADDR_EQ(fib->routes[i].prefix,prefix) && (fib->routes[i].length == length) ) return i;
+	}
+	return NETIPV4_FIB_ROUTE_TAB;
+}
+
+/* The hash of a route table entry. */
+#define ROUTE_HOME(e) net_hash32((uint32_t)(e)->prefix ^ (e)->length)
+
+/*
+ * Removes the route at slot 'i' (backward shift deletion).
+ */
+static void netipv4_fib_route_remove(netipv4_fib_t *fib, uint32_t i){
+	NET_HASH_REMOVE(fib->routes,i,ROUTE_TAB_MASK,ROUTE_HOME);
+	fib->count--;
+}
+
+/*
+ * Returns a next hop for (nif, gateway), or 0, if the next hop table is full.
+ * Index 0 is reserved for "no route".
+ */
+static uint16_t netipv4_fib_nh_get(netipv4_fib_t *fib, netif_t *nif, ipv4_addr_t gateway){
+	uint16_t i,free_i = 0;
+	
+	for(i = 1 ; i < NETIPV4_FIB_NH_MAX ; ++i){
+		if(! fib->nexthops[i].refc ){
+			if(! free_i ) free_i = i;
+			continue;
+		}
+		if( (fib->nexthops[i].nif == nif) && IP4ADDR_EQ(fib->nexthops[i].gateway,gateway) ){
+			fib->nexthops[i].refc++;
+			return i;
+		}
+	}
+	if( free_i ){
+		fib->nexthops[free_i].nif     = nif;
+		fib->nexthops[free_i].gateway = gateway;
+		fib->nexthops[free_i].refc    = 1;
+	}
+	return free_i;
+}
+
+static inline void netipv4_fib_nh_put(netipv4_fib_t *fib, uint16_t nh){
+	if( nh ) fib->nexthops[nh].refc--;
+}
+
+/*
+ * If all entries of the tbl8 group at tbl24[i] are equal and belong to a
+ * prefix of at most /24, the group is merged back into tbl24 and freed.
+ */
+static void netipv4_fib_tbl8_collapse(netipv4_fib_t *fib, uint32_t i){
+	uint32_t g,base,j;
+	uint16_t e;
+	uint8_t d;
+	
+	g = fib->tbl24[i] & FIB_IDX;
+	base = g<<8;
+	e = fib->tbl8[base];
+	d = fib->depth8[base];
+	if( d > 24 ) return;
+	for(j = 1 ; j < 256 ; ++j)
+		if( (fib->tbl8[base+j] != e) || (fib->depth8[base+j] != d) ) return;
+	
+	fib->tbl24[i]   = e;
+	fib->depth24[i] = d;
+	fib->tbl8_used[g] = 0;
+}
+
+/*
+ * Sets an entry. When adding ('del' = 0), entries of prefixes up to 'length'
+ * are overwritten; when deleting, only those of exactly 'length'.
+ */
+static inline void netipv4_fib_set(uint16_t *entry, uint8_t *d, uint8_t length, uint16_t nh, uint8_t depth, int del){
+	if( del ? (*d != length) : (*d > length) ) return;
+	*entry = nh;
+	*d     = depth;
+}
+
+/*
+ * Writes 'nh'/'depth' into all entries covered by 'p'/'length' ('p' in host
+ * byte order), see netipv4_fib_set().
+ * Return 0 on success, non-0 if no tbl8 group is available.
+ */
+static int netipv4_fib_write(netipv4_fib_t *fib, uint32_t p, uint8_t length, uint16_t nh, uint8_t depth, int del){
+	uint32_t i,j,first,last,base,g;
+	uint16_t e;
+	
+	if( length <= 24 ){
+		first = p>>8;
+		last  = first + (1u<<(24-length));
+		for(i = first ; i < last ; ++i){
+			e = fib->tbl24[i];
+			if( e & FIB_EXT ){
+				base = (e & FIB_IDX)<<8;
+				for(j = 0 ; j < 256 ; ++j)
+					netipv4_fib_set(&fib->tbl8[base+j],&fib->depth8[base+j],length,nh,depth,del);
+				if( del ) netipv4_fib_tbl8_collapse(fib,i);
+			}else
+				netipv4_fib_set(&fib->tbl24[i],&fib->depth24[i],length,nh,depth,del);
+		}
+		return 0;
+	}
+	
+	i = p>>8;
+	e = fib->tbl24[i];
+	if( e & FIB_EXT ){
+		base = (e & FIB_IDX)<<8;
+	}else{
+		if( del ) return 0;
+		
+		/* Allocate a tbl8 group, inheriting the tbl24 entry. */
+		for(g = 0 ; g < NETIPV4_FIB_TBL8_MAX ; ++g)
+			if(! fib->tbl8_used[g] ) break;
+		if( g == NETIPV4_FIB_TBL8_MAX ) return -1;
+		fib->tbl8_used[g] = 1;
+		base = g<<8;
+		for(j = 0 ; j < 256 ; ++j){
+			fib->tbl8[base+j]   = e;
+			fib->depth8[base+j] = fib->depth24[i];
+		}
+		fib->tbl24[i] = FIB_EXT|g;
+	}
+	
+	first = p & 0xff;
+	last  = first + (1u<<(32-length));
+	for(j = first ; j < last ; ++j)
+		netipv4_fib_set(&fib->tbl8[base+j],&fib->depth8[base+j],length,nh,depth,del);
+	if( del ) netipv4_fib_tbl8_collapse(fib,i);
+	return 0;
+}
+
+/*
+ * Removes the route at slot 'r'. The entries fall back to the longest
+ * shorter prefix covering the route, if any.
+ */
+static void netipv4_fib_del_prv(netipv4_fib_t *fib, uint32_t r){
+	uint32_t p,k;
+	uint16_t repl_nh = 0;
+	uint8_t length,l,repl_depth = 0;
+	
+	length = fib->routes[r].length;
+	p = ntoh32(fib->routes[r].prefix);
+	
+	for(l = length ; l-- > 0 ; ){
+		k = netipv4_fib_route_find(fib,hton32(p & netipv4_fib_mask(l)),l);
+		if( k == NETIPV4_FIB_ROUTE_TAB ) continue;
+		repl_nh    = fib->routes[k].nh;
+		repl_depth = l;
+		break;
+	}
+	
+	netipv4_fib_write(fib,p,length,repl_nh,repl_depth,1);
+	netipv4_fib_nh_put(fib,fib->routes[r].nh);
+	netipv4_fib_route_remove(fib,r);
+}
+
+int netipv4_fib_init(netipv4_fib_t *fib){
+	fib->seq   = 0;
+	fib->count = 0;
+	
+	fib->tbl24   = net_malloc(sizeof(uint16_t)*FIB_TBL24_SIZE);
+	fib->depth24 = net_malloc(FIB_TBL24_SIZE);
+	fib->tbl8    = net_malloc(sizeof(uint16_t)*FIB_TBL8_SIZE);
+	fib->depth8  = net_malloc(FIB_TBL8_SIZE);
+	
+	if( (!fib->tbl24) || (!fib->depth24) || (!fib->tbl8) || (!fib->depth8) ){
+		netipv4_fib_destroy(fib);
+		return -1;
+	}
+	
+	net_bzero(fib->tbl24,sizeof(uint16_t)*FIB_TBL24_SIZE);
+	net_bzero(fib->depth24,FIB_TBL24_SIZE);
+	net_bzero(fib->tbl8,sizeof(uint16_t)*FIB_TBL8_SIZE);
+	net_bzero(fib->depth8,FIB_TBL8_SIZE);
+	net_bzero(fib->tbl8_used,sizeof(fib->tbl8_used));
+	net_bzero(fib->nexthops,sizeof(fib->nexthops));
+	net_bzero(fib->routes,sizeof(fib->routes));
+	return 0;
+}
+
+void netipv4_fib_destroy(netipv4_fib_t *fib){
+	if( fib->tbl24 )   net_free(fib->tbl24);
+	if( fib->depth24 ) net_free(fib->depth24);
+	if( fib->tbl8 )    net_free(fib->tbl8);
+	if( fib->depth8 )  net_free(fib->depth8);
+	fib->tbl24   = 0;
+	fib->depth24 = 0;
+	fib->tbl8    = 0;
+	fib->depth8  = 0;
+}
+
+int netipv4_fib_add(netipv4_fib_t *fib, ipv4_addr_t prefix, uint8_t length, netif_t *nif, ipv4_addr_t gateway){
+	uint32_t p,r;
+	uint16_t nh;
+	int result = -1;
+	
+	if( (length > 32) || (! nif) ) return -1;
+	
+	p = ntoh32(prefix) & netipv4_fib_mask(length);
+	prefix = hton32(p);
+	
+	net_mutex_lock(fib->lock);
+	
+	r = netipv4_fib_route_find(fib,prefix,length);
+	if( (r == NETIPV4_FIB_ROUTE_TAB) && (fib->count >= NETIPV4_FIB_ROUTE_MAX) ) goto UNLOCK;
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	nh = netipv4_fib_nh_get(fib,nif,gateway);
+	if(! nh ) goto DONE;
+	
+	if( r < NETIPV4_FIB_ROUTE_TAB ){
+		/* Replace the next hop of the existing route. */
+		netipv4_fib_write(fib,p,length,nh,length,1);
+		netipv4_fib_nh_put(fib,fib->routes[r].nh);
+		fib->routes[r].nh = nh;
+	}else{
+		if( netipv4_fib_write(fib,p,length,nh,length,0) ){
+			netipv4_fib_nh_put(fib,nh);
+			goto DONE;
+		}
+		for(
+			r = net_hash32((uint32_t)prefix ^ length)&ROUTE_TAB_MASK;
+			fib->routes[r].used;
+			r = (r+1)&ROUTE_TAB_MASK
+		);
+		fib->routes[r].prefix = prefix;
+		fib->routes[r].length = length;
+		fib->routes[r].nh     = nh;
+		fib->routes[r].used   = 1;
+		fib->count++;
+	}
+	result = 0;
+	
+DONE:
+	net_seq_write_end(&(fib->seq));
+UNLOCK:
+	net_mutex_unlock(fib->lock);
+	return result;
+}
+
+int netipv4_fib_del(netipv4_fib_t *fib, ipv4_addr_t prefix, uint8_t length){
+	uint32_t r;
+	int result = -1;
+	
+	if( length > 32 ) return -1;
+	
+	prefix = hton32(ntoh32(prefix) & netipv4_fib_mask(length));
+	
+	net_mutex_lock(fib->lock);
+	
+	r = netipv4_fib_route_find(fib,prefix,length);
+	if( r == NETIPV4_FIB_ROUTE_TAB ) goto UNLOCK;
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	netipv4_fib_del_prv(fib,r);
+	result = 0;
+	
+	net_seq_write_end(&(fib->seq));
+UNLOCK:
+	net_mutex_unlock(fib->lock);
+	return result;
+}
+
+void netipv4_fib_flush_if(netipv4_fib_t *fib, netif_t *nif){
+	uint32_t r;
+	
+	net_mutex_lock(fib->lock);
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	for(r = 0 ; r < NETIPV4_FIB_ROUTE_TAB ; ){
+		if( fib->routes[r].used && (fib->nexthops[fib->routes[r].nh].nif == nif) ){
+			/* The backward shift may move another route into slot 'r'. */
+			netipv4_fib_del_prv(fib,r);
+			continue;
+		}
+		++r;
+	}
+	
+	net_seq_write_end(&(fib->seq));
+	
+	net_mutex_unlock(fib->lock);
+}
+
+int netipv4_fib_lookup(netipv4_fib_t *fib, ipv4_addr_t dst, netif_t **nif, ipv4_addr_t *nexthop){
+	uint32_t a,seq;
+	uint16_t e;
+	netif_t *rnif;
+	ipv4_addr_t gateway;
+	
+	a = ntoh32(dst);
+	
+	do{
+		seq = net_seq_read_begin(&(fib->seq));
+		
+		e = fib->tbl24[a>>8];
+		if( e & FIB_EXT ) e = fib->tbl8[((e & FIB_IDX)<<8)|(a & 0xff)];
+		rnif    = fib->nexthops[e].nif;
+		gateway = fib->nexthops[e].gateway;
+	}while( net_seq_read_retry(&(fib->seq),seq) );
+	
+	if(! e ) return -1;
+	
+	*nif     = rnif;
+	*nexthop = IP4_ADDR_IS_UNSPECIFIED(gateway) ? dst : gateway;
+	return 0;
+}
+
+int netipv4_route(netif_t **nif, ipv4_addr_t dst, ipv4_addr_t *nexthop, int do_not_route){
+	netif_t *rnif;
+	
+	if(! *nif ){
+		if( (! netipv4_fib) || netipv4_fib_lookup(netipv4_fib,dst,nif,nexthop) ) return -1;
+		if( do_not_route ) *nexthop = dst;
+	}else if( do_not_route || netipv4_addr_is_onlink(*nif,dst) || IP4_ADDR_IS_MULTICAST(dst) ){
+		*nexthop = dst;
+	}else{
+		/* Prefer the next hop from the FIB, if it routes over this interface. */
+		if( (! netipv4_fib) || netipv4_fib_lookup(netipv4_fib,dst,&rnif,nexthop) || (rnif != *nif) )
+			*nexthop = (*nif)->ipv4.gateway;
+	}
+	return 0;
+}
+
@@ -0,0 +1,133 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv4/forward.h>
+#include <netipv4/defs.h>
+#include <netipv4/ipv4_header.h>
+#include <netipv4/fib.h>
+#include <netipv4/fragment.h>
+#include <netipv4/ctrl.h>
+#include <neticmp/output.h>
+#include <neticmp/icmp_header.h>
+#include <netif/ifapi.h>
+#include <netsock/addr.h>
+#include <netprot/checksum.h>
+#include <netstd/endianness.h>
+
+/* Addresses, that must never be forwarded (RFC 1812 5.3.7, RFC 3927 2.7). */
+#define MARTIAN(a) ( \
+	IP4_ADDR_IS_UNSPECIFIED(a) || IP4_ADDR_IS_LOOPBACK(a) || IP4_ADDR_IS_LINK_LOCAL(a) || \
+	IP4_ADDR_IS_MULTICAST(a) || IP4_CLASS_E(a) )
+
+void netipv4_forward(netif_t *netif, netpkt_t *pkt){
+	fnet_ip_header_t   *hdr;
+	netif_t            *onif;
+	ipv4_addr_t        nexthop;
+	net_sockaddr_t     src_addr;
+	net_sockaddr_t     dst_addr;
+	uint32_t           header_length;
+	uint32_t           param = 0;
+	uint16_t           oldval,newval;
+	uint8_t            protocol;
+	uint8_t            type,code;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_ip_header_t)) ) goto DROP;
+	
+	hdr = netpkt_data(pkt);
+	
+	src_addr.type  = NET_SKA_IN;
+	src_addr.ip.v4 = hdr->source_addr;
+	dst_addr.type  = NET_SKA_IN;
+	dst_addr.ip.v4 = hdr->desination_addr;
+	
+	/*
+	 * RFC 1812 5.3.4: Link-layer and IP broadcasts are not forwarded; nor are
+	 * multicasts, as there is no multicast routing.
+	 */
+	if( pkt->flags & (NETPKT_FLAG_BROAD_L2|NETPKT_FLAG_BROAD_L3) ) goto DROP;
+	
+	if( MARTIAN(dst_addr.ip.v4) || MARTIAN(src_addr.ip.v4) || IP4ADDR_EQ(src_addr.ip.v4,IP4_ADDR_BROADCAST) ) goto DROP;
+	
+	/*
+	 * RFC 1812 5.3.1: If the TTL is reduced to zero (or less), the packet MUST be
+	 * discarded, and [...] the router MUST send an ICMP Time Exceeded message.
+	 */
+	if( hdr->ttl <= 1 ){
+		type = FNET_ICMP_TIMXCEED;
+		code = FNET_ICMP_TIMXCEED_INTRANS;
+		goto ERROR;
+	}
+	
+	if( (! netipv4_fib) || netipv4_fib_lookup(netipv4_fib,dst_addr.ip.v4,&onif,&nexthop) ){
+		type = FNET_ICMP_UNREACHABLE;
+		code = FNET_ICMP_UNREACHABLE_NET;
+		goto ERROR;
+	}
+	
+	if( NETPKT_LENGTH(pkt) > onif->netif_mtu ){
+		/*
+		 * RFC 1191: The Destination Unreachable message carries the MTU of
+		 * the next-hop network in the low-order 16 bits.
+		 */
+		if( ntoh16(hdr->flags_fragment_offset) & FNET_IP_DF ){
+			type  = FNET_ICMP_UNREACHABLE;
+			code  = FNET_ICMP_UNREACHABLE_NEEDFRAG;
+			param = onif->netif_mtu & 0xffffu;
+			goto ERROR;
+		}
+	}
+	
+	/*
+	 * Decrement the TTL, and update the header checksum incrementally
+	 * (RFC 1624). The TTL is the upper half of a 16-bit word, the protocol
+	 * field the lower half.
+	 */
+	oldval = hton16( (uint16_t)((hdr->ttl<<8)|hdr->protocol) );
+	hdr->ttl--;
+	newval = hton16( (uint16_t)((hdr->ttl<<8)|hdr->protocol) );
+	hdr->checksum = netprot_checksum_update16(hdr->checksum,oldval,newval);
+	
+	/* RFC 1812 5.2.6: Datagrams without DF are fragmented to fit the MTU. */
+	if( NETPKT_LENGTH(pkt) > onif->netif_mtu ){
+		netipv4_fragment(onif,pkt,&nexthop);
+		return;
+	}
+	
+	/*
+	 * The packet is sent as is; the link-layer header is put into the
+	 * headroom, in front of the IP header.
+	 */
+	onif->netif_class->ifapi_send_l3_ipv4(onif,pkt,&nexthop);
+	return;
+	
+ERROR:
+	header_length = (uint32_t)FNET_IP_HEADER_GET_HEADER_LENGTH(hdr) << 2;
+	protocol      = hdr->protocol;
+	
+	/* neticmp_error() expects the payload on the current level. */
+	if( netpkt_levelup(pkt) ) goto DROP;
+	
+	if( netpkt_pullfront(pkt,header_length) ) goto DROP;
+	
+	/* The error is sent from our address, facing the source. */
+	dst_addr.ip.v4 = netipv4_select_src_addr(netif,src_addr.ip.v4);
+	
+	neticmp_error(netif,pkt,protocol,&src_addr,&dst_addr,type,code,param);
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
@@ -0,0 +1,139 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv4/fragment.h>
+#include <netipv4/ipv4_header.h>
+#include <netif/ifapi.h>
+#include <netprot/checksum.h>
+#include <netstd/endianness.h>
+#include <netstd/mem.h>
+#include <netmem/allocpkt.h>
+
+/* IHL is 4 bits, counting 32-bit words. */
+#define IP_HEADER_MAX 60
+
+/*
+ * RFC 791 3.2: Options, whose copied flag is set, go into all fragments; the
+ * others only into the first one. Builds the header of the subsequent
+ * fragments into 'dst', and returns its length.
+ */
+static uint32_t netipv4_fragment_header(uint8_t *dst, const uint8_t *src, uint32_t hlen){
+	uint32_t i, n, len;
+	
+	memcpy(dst,src,sizeof(fnet_ip_header_t));
+	n = sizeof(fnet_ip_header_t);
+	
+	for(i = sizeof(fnet_ip_header_t) ; i < hlen ; i += len){
+		/* End of Option List. */
+		if( src[i] == 0 ) break;
+		
+		/* No Operation; not copied. */
+		if( src[i] == 1 ){
+			len = 1;
+			continue;
+		}
+		
+		if( (i+1) >= hlen ) break;
+		len = src[i+1];
+		if( (len < 2) || ((i+len) > hlen) ) break;
+		
+		if( src[i] & 0x80 ){
+			memcpy(dst+n,src+i,len);
+			n += len;
+		}
+	}
+	
+	/* Pad with End of Option List to a multiple of 32 bits. */
+	while( n & 3 ) dst[n++] = 0;
+	
+	dst[0] = 0x40 | (uint8_t)(n>>2);
+	return n;
+}
+
+void netipv4_fragment(netif_t *nif, netpkt_t *pkt, ipv4_addr_t *nexthop){
+	fnet_ip_header_t   *hdr;
+	netpkt_t           *chain, **tail, *frag;
+	uint8_t            first[IP_HEADER_MAX];
+	uint8_t            other[IP_HEADER_MAX];
+	const uint8_t      *fhdr;
+	uint32_t           hlen, olen, flen, length, off, n, max;
+	uint16_t           ffo, mf;
+	
+	chain = 0;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_ip_header_t)) ) goto DROP;
+	
+	hdr  = netpkt_data(pkt);
+	hlen = (uint32_t)FNET_IP_HEADER_GET_HEADER_LENGTH(hdr) << 2;
+	if( hlen < sizeof(fnet_ip_header_t) ) goto DROP;
+	
+	if( netpkt_copyout(pkt,0,first,hlen) ) goto DROP;
+	
+	hdr = (fnet_ip_header_t*)first;
+	ffo = ntoh16(hdr->flags_fragment_offset);
+	if( ffo & FNET_IP_DF ) goto DROP;
+	
+	length = NETPKT_LENGTH(pkt) - hlen;
+	olen   = netipv4_fragment_header(other,first,hlen);
+	
+	tail = &chain;
+	fhdr = first;
+	flen = hlen;
+	for(off = 0 ; off < length ; off += n){
+		/* The data of all fragments but the last is a multiple of 8 octets. */
+		max = (nif->netif_mtu > flen) ? ((nif->netif_mtu - flen) & ~7u) : 0;
+		if(! max ) goto DROP;
+		
+		n = length - off;
+		if( n > max ) n = max;
+		
+		if(! (frag = netmem_alloc_pkt(n)) ) goto DROP;
+		*tail = frag;
+		tail  = &(frag->next_chain);
+		*tail = 0;
+		
+		if( netpkt_copyout(pkt,hlen+off,netpkt_data(frag),n) ) goto DROP;
+		
+		if( netpkt_leveldown(frag) ) goto DROP;
+		
+		if( netpkt_pushfront(frag,flen) ) goto DROP;
+		
+		if( netpkt_pullup_lite(frag,flen) ) goto DROP;
+		
+		memcpy(netpkt_data(frag),fhdr,flen);
+		
+		/* A fragment of a fragment keeps the MF flag in its last piece. */
+		mf = ( ((off+n) < length) ? FNET_IP_MF : (ffo & FNET_IP_MF) );
+		
+		hdr = netpkt_data(frag);
+		hdr->total_length          = hton16((uint16_t)(flen+n));
+		hdr->flags_fragment_offset = hton16( (uint16_t)( (ffo & (FNET_IP_FLAG_MASK & ~FNET_IP_MF)) | mf | (((ffo & FNET_IP_OFFSET_MASK) + (off>>3)) & FNET_IP_OFFSET_MASK) ) );
+		hdr->checksum              = 0;
+		hdr->checksum              = netprot_checksum_buf((void*)hdr,flen);
+		
+		fhdr = other;
+		flen = olen;
+	}
+	
+	netpkt_free(pkt);
+	
+	if( chain ) nif->netif_class->ifapi_send_l3_ipv4_all(nif,chain,nexthop);
+	return;
+DROP:
+	netpkt_free_all(chain);
+	netpkt_free(pkt);
+}
+
@@ -15,31 +15,52 @@
  */
 
 #include <netipv4/ipv4_idents.h>
+#include <netstd/atomic.h>
+#include <netstd/random.h>
+#include <netstd/siphash.h>
 
-static const uint32_t FNV_prime = 16777619U;
-static const uint32_t FNV_basis = 2166136261U;
-
-static inline uint32_t fnv1a_int(uint32_t hash,uint32_t data){
-	hash ^= (data&0xff);
-	hash *= FNV_prime;
-	hash ^= (data >> 8);
-	hash *= FNV_prime;
-	hash ^= (data >> 16);
-	hash *= FNV_prime;
-	hash ^= (data >> 24);
-	hash *= FNV_prime;
-	return hash;
+/*
+ * Initializes the ID generator state with random keys and counters.
+ *
+ * RFC 7739 4.3: The counters are initialized to random values, so that the
+ * IDs of a new (or restarted) system are not predictable.
+ */
+void netipv4_id_init(struct netipv4_idt *idt){
+	uint32_t i;
+	
+	for(i = 0 ; i < 4 ; ++i)
+		idt->key[i] = net_random_u32();
+	for(i = 0 ; i < NETIPV4_ID_TAB_SIZE ; ++i)
+		idt->table[i] = net_random_u32();
+	net_memory_barrier();
 }
 
 /*
  * Returns the next value for the ID field.
+ *
+ * RFC 7739 4.3: The ID is taken from one of NETIPV4_ID_TAB_SIZE counters,
+ * selected by a keyed hash (SipHash) over the source and destination
+ * addresses. A second part of the hash is added as an offset, so that flows
+ * sharing a counter cannot learn each other's IDs.
+ *
+ * The counter is incremented with an atomic fetch-add, so that concurrent
+ * senders never get the same value, without taking a lock.
  */
 uint32_t netipv4_next_id(netif_t *nif,ipv4_addr_t src,ipv4_addr_t dest){
-	uint32_t hash = FNV_basis;
-	hash = fnv1a_int(hash,(uint32_t)src);
-	hash = fnv1a_int(hash,(uint32_t)dest);
-	/* TODO atomic operation or locks. */
-	uint32_t nextid = (nif->ipv4_id->table[hash&NETIPV4_ID_TAB_MASK]++);
-	return (uint16_t)nextid;
+	struct netipv4_idt *idt;
+	ipv4_addr_t addrs[2];
+	uint64_t hash;
+	
+	idt = nif->ipv4_id;
+	
+	/* No ID table: fall back to random IDs. */
+	if(! idt ) return (uint16_t)net_random_u32();
+	
+	/* The lower half selects the counter, the upper half is the offset. */
+	addrs[0] = src;
+	addrs[1] = dest;
+	hash = net_siphash(idt->key,addrs,sizeof(addrs));
+	
+	return (uint16_t)(net_atomic_fetch_add(&(idt->table[hash&NETIPV4_ID_TAB_MASK]),1) + (uint32_t)(hash >> 32));
 }
 
@@ -19,6 +19,8 @@
 #include <netipv4/defs.h>
 #include <netipv4/check.h>
 #include <netipv4/ipv4_header.h>
+#include <netipv4/forward.h>
+#include <netif/addrclass.h>
 
 #include <netsock/addr.h>
 #include <netprot/input.h>
@@ -35,6 +37,7 @@ void netipv4_input( netif_t *netif, netpkt_t *pkt ){
 	size_t              header_length;
 	uint16_t            fragment;
 	uint8_t             protocol;
+	int                 klass;
 	net_sockaddr_t      src_addr;
 	net_sockaddr_t      dst_addr;
 	
@@ -63,12 +66,14 @@ void netipv4_input( netif_t *netif, netpkt_t *pkt ){
 	/* Loopback packets skip the address validation. */
 	if( netif->flags & NETIF_IS_LOOPBACK ) goto CHECK_DONE;
 	
+	klass = netipv4_addr_classify(netif,destination_addr);
+	
 	/*
 	 * Notify upper layer protocols, that the incoming datagram has a
 	 * multicast address.
 	 */
 	if(
-		netipv4_addr_is_broadcast(netif,destination_addr)||
+		(klass & NETIF_ADDRCLASS_BROADCAST)||
 		/* ((destination_addr==0u) && pkt->flags & NETPKT_FLAG_BROAD_L2 )|| */
 		(IP4_ADDR_IS_MULTICAST(destination_addr))
 	) pkt->flags |= NETPKT_FLAG_BROAD_L3;
@@ -79,11 +84,14 @@ void netipv4_input( netif_t *netif, netpkt_t *pkt ){
 	if( (pkt->flags & NETPKT_FLAG_NO_UNICAST_L3) && !(pkt->flags & NETPKT_FLAG_BROAD_L3) )
 		goto DROP;
 	
-	/* If not for me, drop! */
+	/* If not for me, forward or drop! */
 	if(!(
 		(pkt->flags & NETPKT_FLAG_BROAD_L3)||
-		IP4ADDR_EQ(netif->ipv4.address,destination_addr)
-	))goto DROP;
+		(klass & NETIF_ADDRCLASS_LOCAL)
+	)){
+		if( netif->flags & NETIF_FORWARDING ) goto FORWARD;
+		goto DROP;
+	}
 	
 CHECK_DONE:
 	fragment = ntoh16(hdr->flags_fragment_offset);
@@ -119,6 +127,13 @@ CHECK_DONE:
 	 * fnet_icmp_error(netif, FNET_ICMP_UNREACHABLE, FNET_ICMP_UNREACHABLE_PROTOCOL, ip4_nb);
 	 */
 	
+	return;
+FORWARD:
+	if(pkt_length > total_length){
+		/* Logical size and the physical size of the packet should be the same.*/
+		netpkt_setlength(pkt,(uint32_t)total_length);
+	}
+	netipv4_forward(netif,pkt);
 	return;
 DROP:
 	netpkt_free(pkt);
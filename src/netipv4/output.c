@@ -21,6 +21,9 @@
 #include <netipv4/check.h>
 #include <netipv4/ipv4_header.h>
 #include <netipv4/ipv4_idents.h>
+#include <netipv4/ctrl.h>
+#include <netipv4/fib.h>
+#include <netipv4/fragment.h>
 #include <netstd/endianness.h>
 #include <netif/ifapi.h>
 #include <netprot/checksum.h>
@@ -43,27 +46,30 @@ void netipv4_output(
 	ipv4_addr_t        dst_ip;
 	ipv4_addr_t        send_addr;
 	
+	/*
+	 * If no interface is given, the FIB selects the interface and the next hop.
+	 */
+	if( netipv4_route(&nif,dst_addr->ip.v4,&send_addr,do_not_route) ) goto DROP;
+	
+	/* If source address not specified, use address of outgoing interface */
+	if( IP4ADDR_EQ(src_addr->ip.v4,0) ) src_addr->ip.v4 = netipv4_select_src_addr(nif,dst_addr->ip.v4);
+	
 	src_ip = src_addr->ip.v4;
 	dst_ip = dst_addr->ip.v4;
 	
-	if(nif == 0) goto DROP;
-	
-	/* If source address not specified, use address of outgoing interface */
-	if( IP4ADDR_EQ(src_addr->ip.v4,0) ) src_addr->ip.v4 = nif->ipv4.address;
+	total_length = NETPKT_LENGTH(pkt) + sizeof(fnet_ip_header_t);
 	
-	total_length = NETPKT_LENGTH(pkt);
-	/* if((nb->total_length + sizeof(fnet_ip_header_t)) > FNET_IP_MAX_PACKET) */
+	/*
+	 * IPv4 has no jumbograms. Even on links with MTUs beyond 64K, such as the
+	 * loopback, the Total Length field limits the datagram to 65,535 octets.
+	 */
+	if( total_length > 0xffffu ) goto DROP;
 	
 	fragment = 0;
 	if( DF ) fragment |= FNET_IP_DF;
 	
 	if( netpkt_leveldown(pkt) ) goto DROP;
 	
-	if( do_not_route || netipv4_addr_is_onlink(nif,dst_ip) || IP4_ADDR_IS_MULTICAST(dst_ip) )
-		send_addr = dst_ip;
-	else
-		send_addr = nif->ipv4.gateway;
-	
 	/* Construct IP header */
 	if( netpkt_pushfront( pkt, sizeof(fnet_ip_header_t) ) ) goto DROP;
 	
@@ -94,12 +100,13 @@ void netipv4_output(
 	
 	if(total_length > nif->netif_mtu) /* IP Fragmentation. */
 	{
-		// TODO: IP fragmentation
-		goto DROP;
+		/* A datagram with DF, that exceeds the MTU, is dropped. */
+		if( DF ) goto DROP;
+		netipv4_fragment(nif,pkt,&send_addr);
 	}else{
 		nif->netif_class->ifapi_send_l3_ipv4(nif,pkt,&send_addr);
 	}
-	
+	return;
 DROP:
 	netpkt_free(pkt);
 }
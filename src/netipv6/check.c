@@ -17,8 +17,11 @@
  */
 
 #include <netipv6/check.h>
+#include <netipv6/srcsel.h>
 #include <netipv6/defs.h>
 #include <netipv6/if.h>
+#include <netipv6/multicast.h>
+#include <netif/addrclass.h>
 #include <netpkt/flags.h>
 #include <netstd/mem.h>
 
@@ -39,7 +42,7 @@ int netipv6_deactivated(netif_t *nif){
  * Returns non-0 if the address is directed at ourself.
  */
 int netipv6_addr_is_self(netif_t *nif, ipv6_addr_t *addr, uint16_t pkt_flags){
-	int i;
+	int i, klass;
 	netipv6_if_t* nif6;
 	
 	if( (nif->flags) & NETIF_IS_LOOPBACK ) return -1;
@@ -75,7 +78,18 @@ int netipv6_addr_is_self(netif_t *nif, ipv6_addr_t *addr, uint16_t pkt_flags){
 		case 1:
 			return 0;
 		}
-		return -1;
+		
+		/*
+		 * Accept joined groups only. The classification table holds fewer
+		 * entries, than there may be groups: On a miss, ask the group table.
+		 */
+		if( nif->addrclass && (netif_addrclass_get6(nif,addr) & (NETIF_ADDRCLASS_MULTICAST|NETIF_ADDRCLASS_SOLICITED)) )
+			return -1;
+		
+		/* The All-nodes groups are always joined. */
+		if( IP6ADDR_EQ(*addr,ip6_addr_nodelocal_allnodes) || IP6ADDR_EQ(*addr,ip6_addr_linklocal_allnodes) )
+			return -1;
+		return netipv6_multicast_is_member(nif,addr);
 	}
 	
 	/*
@@ -83,6 +97,13 @@ int netipv6_addr_is_self(netif_t *nif, ipv6_addr_t *addr, uint16_t pkt_flags){
 	 */
 	if( pkt_flags & NETPKT_FLAG_NO_UNICAST_L3 ) return 0;
 	
+	/* If the table has overflowed, a miss is checked below. */
+	if( nif->addrclass ){
+		klass = netif_addrclass_get6(nif,addr);
+		if(! (klass & NETIF_ADDRCLASS_OVERFLOW) )
+			return (klass & NETIF_ADDRCLASS_LOCAL) ? -1 : 0;
+	}
+	
 	nif6 = nif->ipv6;
 	
 	for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
@@ -96,9 +117,16 @@ int netipv6_addr_is_self(netif_t *nif, ipv6_addr_t *addr, uint16_t pkt_flags){
 }
 
 int netipv6_addr_is_own_ip6_solicited_multicast(netif_t *nif, ipv6_addr_t *addr){
-	int i;
+	int i, klass;
 	netipv6_if_t* nif6;
 	
+	/* If the table has overflowed, a miss is checked below. */
+	if( nif->addrclass ){
+		klass = netif_addrclass_get6(nif,addr);
+		if(! (klass & NETIF_ADDRCLASS_OVERFLOW) )
+			return (klass & NETIF_ADDRCLASS_SOLICITED) ? -1 : 0;
+	}
+	
 	nif6 = nif->ipv6;
 	
 	for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
@@ -114,49 +142,10 @@ int netipv6_addr_is_own_ip6_solicited_multicast(netif_t *nif, ipv6_addr_t *addr)
 
 /*
  * Selects the best source address to use with a destination address.
- * Just enough to implement Neighbor Solicitation Message.
+ * See netipv6_select_src_addr().
  */
 int netipv6_select_src_addr_nsol(netif_t *nif, ipv6_addr_t *src, const ipv6_addr_t *dest){
-	int i,j;
-	int best,best_cp;
-	netipv6_if_t* nif6;
-	
-	nif6 = nif->ipv6;
-	
-	/*
-	 * Perform a "Longest Prefix Search" on all IPv6 addresses.
-	 */
-	best = NETIPV6_IF_ADDR_MAX;
-	best_cp = 0;
-	for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
-		/* Skip NOT_USED addresses. */
-		if( !nif6->addrs[i].used ) continue;
-		
-		/* Figure out the common prefix length. */
-		for(j = 0 ; j<16 ; ++j ) {
-			if(nif6->addrs[i].address.addr[j] != dest->addr[j]) break;
-		}
-		
-		if( j > best_cp ) {
-			best_cp = j;
-			best = i;
-		}
-		
-		/*
-		 * IBM z/OS:
-		 *   If either address is the destination address, choose that
-		 *   address as the source address and terminate the entire
-		 *   algorithm.
-		 */
-		if( j == 16) break;
-	}
-	
-	if( best != NETIPV6_IF_ADDR_MAX ){
-		*src = nif6->addrs[best].address;
-		return -1;
-	}
-	
-	return 0;
+	return netipv6_select_src_addr(nif,src,dest);
 }
 
 /*
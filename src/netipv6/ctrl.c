@@ -23,6 +23,8 @@
 #include <netif/mac.h>
 #include <netnd6/table.h>
 #include <netipv6/multicast.h>
+#include <netif/addrclass.h>
+#include <netipv6/srcsel.h>
 
 #define IPV6_PREFIX_LENGTH_DEFAULT       (64U)            /* Default prefix length, in bits.*/
 
@@ -148,6 +150,10 @@ int netipv6_bind_addr_prv(
 		/* Set lifetime, in seconds.*/
 		if_addr_ptr->lifetime = lifetime;
 		
+		if_addr_ptr->prefix_length = prefix_length;
+		
+		if_addr_ptr->used = 1;
+		
 		/* If supports ND6. */
 		if(nif->nd6){
 			/*
@@ -181,6 +187,8 @@ int netipv6_bind_addr_prv(
 		{
 			if_addr_ptr->state = FNET_NETIF_IP6_ADDR_STATE_PREFERRED;
 		}
+		netif_addrclass_rebuild(nif);
+		netipv6_srcsel_invalidate(nif);
 		result = 0;
 	}
 COMPLETE:
@@ -195,6 +203,9 @@ int netipv6_unbind_addr_prv ( netif_t *nif, netipv6_if_addr_t *if_addr) {
 	
 	/* Mark as Not Used.*/
 	if_addr->used = 0;
+	
+	netif_addrclass_rebuild(nif);
+	netipv6_srcsel_invalidate(nif);
 	return 0;
 }
 
@@ -16,6 +16,7 @@
  *   limitations under the License.
  */
 #include <netipv6/exthdr.h>
+#include <netipv6/srh.h>
 
 #include <netipv6/ipv6_header.h>
 
@@ -28,167 +29,154 @@ enum{
 	I6OPT_DISCARD_UICMP,
 };
 
-static int netipv6_ext_options(void *data,size_t size){
-	fnet_ip6_option_header_t *option;
+/*
+ * Classes of the Next Header values.
+ */
+enum{
+	I6EXT_UPPER = 0,  /* Upper-layer protocol (or unsupported header); ends the chain. */
+	I6EXT_OPTIONS,    /* Hop-by-Hop or Destination Options header. */
+	I6EXT_ROUTING,    /* Routing header. */
+	I6EXT_FRAGMENT,   /* Fragment header. */
+	I6EXT_NO_NEXT,    /* No Next Header. */
+};
 
-	while(size){
-		option=data;
-		switch(option->type){
-		/* The RFC2460 supports only PAD0 and PADN options.*/
-		case FNET_IP6_OPTION_TYPE_PAD1:
-			data++;
-			size--;
-			break;
-		case FNET_IP6_OPTION_TYPE_PADN:
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			break;
+const uint8_t netipv6_ext_class[256] = {
+	[FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS]   = I6EXT_OPTIONS,
+	[FNET_IP6_TYPE_DESTINATION_OPTIONS]  = I6EXT_OPTIONS,
+	[FNET_IP6_TYPE_ROUTING_HEADER]       = I6EXT_ROUTING,
+	[FNET_IP6_TYPE_FRAGMENT_HEADER]      = I6EXT_FRAGMENT,
+	[FNET_IP6_TYPE_NO_NEXT_HEADER]       = I6EXT_NO_NEXT,
+};
+
+/*
+ * Classes of the Option Types.
+ */
+enum{
+	I6OPT_UNKNOWN = 0, /* Unrecognized; the highest-order two bits specify the action. */
+	I6OPT_PAD1,        /* Pad1; a single octet without length field. */
+	I6OPT_SKIP,        /* Recognized, but has no effect on us. */
+	I6OPT_JUMBO,       /* Jumbo Payload. */
+};
+
+static const uint8_t netipv6_ext_option_class[256] = {
+	/* The RFC2460 supports only PAD0 and PADN options.*/
+	[FNET_IP6_OPTION_TYPE_PAD1]          = I6OPT_PAD1,
+	[FNET_IP6_OPTION_TYPE_PADN]          = I6OPT_SKIP,
+	
+	/* RFC 2711: Router Alert. We are not a router. */
+	[FNET_IP6_OPTION_TYPE_ROUTER_ALERT]  = I6OPT_SKIP,
+	
+	/*
+	 * RFC 6275  6.3.  Home Address Option:
+	 * 
+	 *  The Home Address option is carried by the Destination Option
+	 *  extension header (Next Header value = 60).  It is used in a packet
+	 *  sent by a mobile node while away from home, to inform the recipient
+	 *  of the mobile node's home address.
+	 * 
+	 *  Option Type
+	 *    201 = 0xC9
+	 *
+	 * We recognize this option, but we cannot consume the Home Address (yet).
+	 *
+	 * The option length is required to be 16, however, when the peer violates the
+	 * protocol, we are going to silently ignore it.
+	 */
+	[0xC9]                               = I6OPT_SKIP,
+	
+	/*
+	 * RFC 6788   7.  Line-Identification Option (LIO)
+	 *
+	 *   The Line-Identification Option (LIO) is a destination option that can
+	 *   be included in IPv6 datagrams that tunnel Router Solicitation and
+	 *   Router Advertisement messages.
+	 *
+	 * We recognize this option, but we cannot consume it (yet).
+	 */
+	[0x8C]                               = I6OPT_SKIP,
+	
+	/* Endpoint Identification (DEPRECATED) [[CHARLES LYNN]] */
+	[0x8A]                               = I6OPT_SKIP,
+	/* Deprecated [RFC7731] */
+	[0x4D]                               = I6OPT_SKIP,
+	
+	/*
+	 * RFC 7731 6.1. MPL Option:
+	 *
+	 *    The MPL Option is carried in MPL Data Messages in an IPv6 Hop-by-Hop
+	 *    Options header, immediately following the IPv6 header.
+	 *
+	 * We fundamentally understand it, but it has no effect on us.
+	 */
+	[0x6D]                               = I6OPT_SKIP,
+	
+	/*
+	 * RFC 6553   3.  Format of the RPL Option
+	 *
+	 * We fundamentally understand it, but it has no effect on us.
+	 */
+	[0x63]                               = I6OPT_SKIP,
+	
+	/* RFC 2675: Jumbo Payload. */
+	[FNET_IP6_OPTION_TYPE_JUMBO]         = I6OPT_JUMBO,
+};
+
+/*
+ * Processes the options of a Hop-by-Hop or Destination Options header. The
+ * options must reside in contiguous area of memory.
+ *
+ * On I6OPT_DISCARD_ICMP and I6OPT_DISCARD_UICMP, *poffset is set to the offset
+ * of the unrecognized option. If a Jumbo Payload option is found, its offset
+ * is stored in *pjumbo.
+ */
+static int netipv6_ext_options(const uint8_t *data, uint32_t size, uint32_t *poffset, uint32_t *pjumbo){
+	uint32_t i, length;
+	uint8_t  type;
+	
+	for(i = 0 ; i < size ; i += length){
+		type = data[i];
 		
-		/*
-		 * RFC 6275  6.3.  Home Address Option:
-		 * 
-		 *  The Home Address option is carried by the Destination Option
-		 *  extension header (Next Header value = 60).  It is used in a packet
-		 *  sent by a mobile node while away from home, to inform the recipient
-		 *  of the mobile node's home address.
-		 * 
-		 *  The Home Address option is encoded in type-length-value (TLV) format
-		 *  as follows:
-		 *  
-		 *  Option Type
-		 *    201 = 0xC9
-		 *
-		 *  Option Length:
-		 *    8-bit unsigned integer.  Length of the option, in octets,
-		 *    excluding the Option Type and Option Length fields.  This field
-		 *    MUST be set to 16.
-		 */
-		case 0xC9:
-			/*
-			 * We recognize this option, but we cannot consume the Home Address (yet).
-			 *
-			 * The option length is required to be 16, however, when the peer violates the
-			 * protocol, we are going to silently ignore it.
-			 */
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			break;
+		if( netipv6_ext_option_class[type] == I6OPT_PAD1 ){
+			length = 1;
+			continue;
+		}
 		
-		/*
-		 * RFC 6788   7.  Line-Identification Option (LIO)
-		 *
-		 *   The Line-Identification Option (LIO) is a destination option that can
-		 *   be included in IPv6 datagrams that tunnel Router Solicitation and
-		 *   Router Advertisement messages.  The use of the Line-ID option in any
-		 *   other IPv6 datagrams is not defined by this document.  Multiple Line-
-		 *   ID destination options MUST NOT be present in the same IPv6 datagram.
-		 *   The LIO has no alignment requirement.
-		 *
-		 *    0                   1                   2                   3
-		 *    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-		 *                                   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *                                   |  Option Type  | Option Length |
-		 *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *   | LineIDLen     |     Line ID...
-		 *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *
-		 *                Figure 4: Line-Identification Option Layout
-		 *
-		 */
-		case 0x8C:
-			/*
-			 * We recognize this option, but we cannot consume it (yet).
-			 *
-			 */
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			break;
+		/* The option must not exceed the header. */
+		if( (i+2) > size ) return I6OPT_DISCARD;
+		length = sizeof(fnet_ip6_option_header_t) + (uint32_t)data[i+1];
+		if( (i+length) > size ) return I6OPT_DISCARD;
 		
-		/* Endpoint Identification (DEPRECATED) [[CHARLES LYNN]] */
-		case 0x8A:
-		/* Deprecated [RFC7731] */
-		case 0x4D:
-			/*
-			 * We recognize this option. Skip it!
-			 */
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			break;
+		if( netipv6_ext_option_class[type] == I6OPT_JUMBO ){
+			*pjumbo = i;
+			continue;
+		}
 		
-		/* RFC 7731 6.1. MPL Option */
-		/*
-		 * RFC 7731 6.1. MPL Option:
-		 *
-		 *    The MPL Option is carried in MPL Data Messages in an IPv6 Hop-by-Hop
-		 *    Options header, immediately following the IPv6 header.  The MPL
-		 *    Option has the following format:
-		 * 
-		 *       0                   1                   2                   3
-		 *       0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-		 *                                      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *                                      |  Option Type  |  Opt Data Len |
-		 *      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *      | S |M|V|  rsv  |   sequence    |      seed-id (optional)       |
-		 *      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 */
-		case 0x6D:
-			/*
-			 * We fundamentally understand it, but it has no effect on us.
-			 */
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			break;
-		/*
-		 * RFC 6553   3.  Format of the RPL Option
-		 *
-		 *      0                   1                   2                   3
-		 *      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-		 *                                     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *                                     |  Option Type  |  Opt Data Len |
-		 *     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *     |O|R|F|0|0|0|0|0| RPLInstanceID |          SenderRank           |
-		 *     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *     |                         (sub-TLVs)                            |
-		 *     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-		 *
-		 *                           Figure 1: RPL Option
-		 */
-		case 0x63:
-			/*
-			 * We fundamentally understand it, but it has no effect on us.
-			 */
-			data += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
-			size += sizeof(fnet_ip6_option_header_t) + (size_t)option->data_length;
+		if( netipv6_ext_option_class[type] != I6OPT_UNKNOWN ) continue;
+		
+		/* The Option Type identifiers are internally encoded such that their
+		 * highest-order two bits specify the action that must be taken if the
+		 * processing IPv6 node does not recognize the Option Type.*/
+		switch(type & FNET_IP6_OPTION_TYPE_UNRECOGNIZED_MASK){
+		/* 00 - skip over this option and continue processing the header.*/
+		case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_SKIP:
 			break;
-		/*
-		 * XXX Jumbo Payload [RFC2675]
-		 * case 0xC2:
-		 */
-		/* Unrecognized Options.*/
-		default:
-			/* The Option Type identifiers are internally encoded such that their
-			 * highest-order two bits specify the action that must be taken if the
-			 * processing IPv6 node does not recognize the Option Type.*/
-			switch(option->type & FNET_IP6_OPTION_TYPE_UNRECOGNIZED_MASK){
-			/* 00 - skip over this option and continue processing the header.*/
-			case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_SKIP:
-				break;
-			/* 01 - discard the packet. */
-			case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD:
-				return I6OPT_DISCARD;
-			/* 10 - discard the packet and, regardless of whether or not the
-			 *      packet's Destination Address was a multicast address, send an
-			 *      ICMP Parameter Problem, Code 2, message to the packet's
-			 *      Source Address, pointing to the unrecognized Option Type.*/
-			case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD_ICMP:
-				return I6OPT_DISCARD_ICMP;
-			/* 11 - discard the packet and, only if the packet's Destination
-			 *      Address was not a multicast address, send an ICMP Parameter
-			 *      Problem, Code 2, message to the packet's Source Address,
-			 *      pointing to the unrecognized Option Type.*/
-			case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD_UICMP:
-				return I6OPT_DISCARD_UICMP;
-			}
+		/* 01 - discard the packet. */
+		case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD:
+			return I6OPT_DISCARD;
+		/* 10 - discard the packet and, regardless of whether or not the
+		 *      packet's Destination Address was a multicast address, send an
+		 *      ICMP Parameter Problem, Code 2, message to the packet's
+		 *      Source Address, pointing to the unrecognized Option Type.*/
+		case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD_ICMP:
+			*poffset = i;
+			return I6OPT_DISCARD_ICMP;
+		/* 11 - discard the packet and, only if the packet's Destination
+		 *      Address was not a multicast address, send an ICMP Parameter
+		 *      Problem, Code 2, message to the packet's Source Address,
+		 *      pointing to the unrecognized Option Type.*/
+		case FNET_IP6_OPTION_TYPE_UNRECOGNIZED_DISCARD_UICMP:
+			*poffset = i;
+			return I6OPT_DISCARD_UICMP;
 		}
 	}
 	return I6OPT_KEEP;
@@ -197,7 +185,12 @@ static int netipv6_ext_options(void *data,size_t size){
 void netipv6_ext_header_process(netif_t *netif, uint8_t *pnext_header, ipv6_addr_t *src, ipv6_addr_t *dst, netpkt_t **ppkt){
 	netpkt_t*                  pkt;
 	uint32_t                   hcount;
+	uint32_t                   total;
+	uint32_t                   offset;
+	uint32_t                   jumbo;
+	uint8_t                    *option;
 	uint8_t                    next_header;
+	uint8_t                    klass;
 	netipv6_ext_generic_t      *opt_hdr;
 	size_t                     size;
 	
@@ -212,56 +205,143 @@ void netipv6_ext_header_process(netif_t *netif, uint8_t *pnext_header, ipv6_addr
 	pkt = *ppkt;
 	next_header = *pnext_header;
 	hcount = 0;
+	total = 0;
 	
 	/* Process headers.*/
 	for(;;)
 	{
+		klass = netipv6_ext_class[next_header];
+		
+		/* Fast path: The upper-layer header (TCP, UDP, ICMPv6, ...) has been reached. */
+		if( klass == I6EXT_UPPER ) break;
+		
 		/* IPv6 nodes must accept and attempt to process extension headers in
 		 * any order and occurring any number of times in the same packet,
 		 * except for the Hop-by-Hop Options header which is restricted to
 		 * appear immediately after an IPv6 header only.*/
 		if( hcount && ( next_header==FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS ) ) goto DROP;
 		
-		hcount++;
+		/* Bound the work spent on long (or malicious) header chains. */
+		if( ++hcount > NETIPV6_EXT_MAX_HEADERS ) goto DROP;
+		
+		switch(klass){
+		case I6EXT_NO_NEXT: goto DROP;
+		case I6EXT_FRAGMENT:
+			/*
+			 * RFC 2675 3: A jumbogram must not carry a Fragment header. The
+			 * Parameter Problem points to the first octet of the Fragment header.
+			 */
+			if( pkt->ipv6.jumbo ){
+				pkt->ipv6.error_pointer = NETPKT_OFFSET(pkt);
+				goto ICMP_ERROR;
+			}
+			// TODO: IPv6 reassembly
+			goto DROP;
+		}
+		
+		/*
+		 * The Options and Routing headers are multiples of 8 octets, thus at least
+		 * 8 octets long. Pulling up 8 octets covers the common, short headers at once.
+		 */
+		if( netpkt_pullup(pkt,8) ) goto DROP;
+		opt_hdr = netpkt_data(pkt);
+		size = (opt_hdr->hdr_ext_length * 8) + 8;
+		
+		total += size;
+		if( total > NETIPV6_EXT_MAX_BYTES ) goto DROP;
+		
+		pkt->ipv6.error_pointer = NETPKT_OFFSET(pkt);
 		
-		switch(next_header){
-		case FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS:
-		case FNET_IP6_TYPE_DESTINATION_OPTIONS:
-			if( netpkt_pullup(pkt,sizeof(netipv6_ext_generic_t)) ) goto DROP;
-			opt_hdr = netpkt_data(pkt);
-			next_header = opt_hdr->next_header;
-			pkt->ipv6.error_pointer = NETPKT_OFFSET(pkt);
-			size = (opt_hdr->hdr_ext_length * 8) + 8;
-			if( netpkt_pullup(pkt,size) ) goto DROP;
+		if( klass == I6EXT_OPTIONS ){
+			if( size > 8 ){
+				if( netpkt_pullup(pkt,size) ) goto DROP;
+				opt_hdr = netpkt_data(pkt);
+			}
 			
-			switch( netipv6_ext_options(netpkt_data(pkt)+2,size-2) ){
+			jumbo = size;
+			switch( netipv6_ext_options(((uint8_t*)opt_hdr)+2,size-2,&offset,&jumbo) ){
 			case I6OPT_DISCARD_UICMP:
 				if( IP6_ADDR_IS_MULTICAST(*dst) ) goto DROP;
+				/* fall through */
 			case I6OPT_DISCARD_ICMP:
+				/* Point to the unrecognized Option Type. */
+				pkt->ipv6.error_pointer += 2 + offset;
 				goto ICMP_ERROR;
 			case I6OPT_DISCARD:
 				goto DROP;
 			}
 			
-			if( netpkt_pullfront(pkt,size ) ) goto DROP;
-			break;
-		case FNET_IP6_TYPE_ROUTING_HEADER:
-			if( netpkt_pullup(pkt,sizeof(netipv6_ext_generic_t)) ) goto DROP;
-			opt_hdr = netpkt_data(pkt);
-			next_header = opt_hdr->next_header;
-			pkt->ipv6.error_pointer = NETPKT_OFFSET(pkt);
-			size = (opt_hdr->hdr_ext_length * 8) + 8;
-			/* TODO: handle routing header. */
-			if( netpkt_pullfront(pkt,size ) ) goto DROP;
-			break;
-		case FNET_IP6_TYPE_NO_NEXT_HEADER: goto DROP;
-		case FNET_IP6_TYPE_FRAGMENT_HEADER:
-			// TODO: IPv6 reassembly
-			goto DROP;
-		default: goto DONE;
+			/*
+			 * RFC 2675 3: The Jumbo Payload option is only valid in the Hop-by-Hop
+			 * Options header of a packet with a zero Payload Length, and vice versa.
+			 */
+			if( jumbo < size ){
+				option = ((uint8_t*)opt_hdr) + 2 + jumbo;
+				pkt->ipv6.error_pointer += 2 + jumbo;
+				
+				/* Found in a Destination Options header, or the Payload Length is non-zero. */
+				if( (next_header != FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS) || (! pkt->ipv6.jumbo) ) goto ICMP_ERROR;
+				
+				/* Alignment requirement 4n+2, and 4 octets of data. */
+				if( (((2 + jumbo) & 3) != 2) || (option[1] != 4) ) goto ICMP_ERROR;
+				
+				offset =
+					((uint32_t)option[2] << 24) |
+					((uint32_t)option[3] << 16) |
+					((uint32_t)option[4] << 8) |
+					((uint32_t)option[5]);
+				
+				/* The Jumbo Payload Length must be greater than 65,535. */
+				pkt->ipv6.error_pointer += 2;
+				if( offset <= 0xffffu ) goto ICMP_ERROR;
+				
+				/* The Jumbo Payload Length counts from the Hop-by-Hop Options header. */
+				if( offset > NETPKT_LENGTH(pkt) ) goto DROP;
+				if( offset < NETPKT_LENGTH(pkt) ) netpkt_setlength(pkt,offset);
+			}else if( pkt->ipv6.jumbo && (next_header == FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS) ) goto DROP;
 		}
+		
+		if( klass == I6EXT_ROUTING ){
+			if( size > 8 ){
+				if( netpkt_pullup(pkt,size) ) goto DROP;
+				opt_hdr = netpkt_data(pkt);
+			}
+			
+			/*
+			 * RFC 8200 4.4: If Segments Left is zero, the node must ignore the Routing
+			 * header and proceed to process the next header in the packet.
+			 */
+			while( ((fnet_ip6_routing_header_t*)opt_hdr)->segments_left ){
+				/*
+				 * RFC 8200 4.4: If [...] Segments Left is non-zero, the node must discard
+				 * the packet and send an ICMP Parameter Problem, Code 0, message to the
+				 * packet's Source Address, pointing to the unrecognized Routing Type.
+				 *
+				 * This includes the Type 0 Routing Header (deprecated by RFC 5095).
+				 */
+				if( ((fnet_ip6_routing_header_t*)opt_hdr)->routing_type != FNET_IP6_ROUTING_TYPE_SRH ){
+					pkt->ipv6.error_pointer += 2;
+					goto ICMP_ERROR;
+				}
+				
+				switch( netipv6_srh_process(netif,pkt,size,dst) ){
+				case NETIPV6_SRH_FORWARDED:
+					*ppkt = 0;
+					return;
+				case NETIPV6_SRH_DROP:
+					goto DROP;
+				case NETIPV6_SRH_ICMP:
+					goto ICMP_ERROR;
+				}
+				
+				/* The next segment is ourself: The header may have been moved. */
+				opt_hdr = netpkt_data(pkt);
+			}
+		}
+		
+		next_header = opt_hdr->next_header;
+		if( netpkt_pullfront(pkt,size ) ) goto DROP;
 	}
-DONE:
 	*pnext_header = next_header;
 	return;
 DROP:
@@ -274,4 +354,3 @@ ICMP_ERROR:
 	*ppkt = 0;
 	return;
 }
-
@@ -0,0 +1,410 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv6/fib.h>
+#include <netipv6/defs.h>
+#include <netstd/seqlock.h>
+#include <netstd/mem.h>
+
+/*
+ * The pools have some slack at the end, so that a lookup, that races with an
+ * update and sees a stale base index, still stays within the pools.
+ */
+#define FIB_SLACK          16
+#define FIB_LEVELS         32
+#define POPCOUNT(x)        __builtin_popcount(x)
+
+netipv6_fib_t *netipv6_fib = 0;
+
+/* Returns the 4-bit chunk of the address at 'level'. */
+static inline uint32_t netipv6_fib_chunk(const ipv6_addr_t *addr, uint32_t level){
+	if( level >= FIB_LEVELS ) return 0;
+	return (level & 1) ? (addr->addr[level>>1] & 0xf) : (addr->addr[level>>1] >> 4);
+}
+
+/* Returns the bit in 'internal' of the prefix of length 'l' (0-3) within the chunk 'c'. */
+static inline uint32_t netipv6_fib_ibit(uint32_t l, uint32_t c){
+	return ((1u<<l)-1) + (c>>(4-l));
+}
+
+/*
+ * Block allocation. Index 0 is never a block (nodes[0] is the root, results[0]
+ * is reserved), so 0 terminates the free lists and signals failure.
+ */
+static uint32_t netipv6_fib_node_alloc(netipv6_fib_t *fib, uint32_t size){
+	uint32_t b;
+	
+	b = fib->node_free[size];
+	if( b ){
+		fib->node_free[size] = fib->nodes[b].child_base;
+		return b;
+	}
+	if( (fib->node_top + size) > NETIPV6_FIB_NODE_MAX ) return 0;
+	b = fib->node_top;
+	fib->node_top += size;
+	return b;
+}
+
+static void netipv6_fib_node_free(netipv6_fib_t *fib, uint32_t b, uint32_t size){
+	if(! size ) return;
+	fib->nodes[b].child_base = fib->node_free[size];
+	fib->node_free[size] = b;
+}
+
+static uint32_t netipv6_fib_result_alloc(netipv6_fib_t *fib, uint32_t size){
+	uint32_t b;
+	
+	b = fib->result_free[size];
+	if( b ){
+		fib->result_free[size] = fib->results[b];
+		return b;
+	}
+	if( (fib->result_top + size) > NETIPV6_FIB_RESULT_MAX ) return 0;
+	b = fib->result_top;
+	fib->result_top += size;
+	return b;
+}
+
+static void netipv6_fib_result_free(netipv6_fib_t *fib, uint32_t b, uint32_t size){
+	if(! size ) return;
+	fib->results[b] = (uint16_t)fib->result_free[size];
+	fib->result_free[size] = b;
+}
+
+/*
+ * Returns a next hop for (nif, gateway), or 0, if the next hop table is full.
+ * Index 0 is reserved for "no route".
+ */
+static uint16_t netipv6_fib_nh_get(netipv6_fib_t *fib, netif_t *nif, const ipv6_addr_t *gateway){
+	uint16_t i,free_i = 0;
+	
+	for(i = 1 ; i < NETIPV6_FIB_NH_MAX ; ++i){
+		if(! fib->nexthops[i].refc ){
+			if(! free_i ) free_i = i;
+			continue;
+		}
+		if( (fib->nexthops[i].nif == nif) && IP6ADDR_EQ(fib->nexthops[i].gateway,*gateway) ){
+			fib->nexthops[i].refc++;
+			return i;
+		}
+	}
+	if( free_i ){
+		fib->nexthops[free_i].nif     = nif;
+		fib->nexthops[free_i].gateway = *gateway;
+		fib->nexthops[free_i].refc    = 1;
+	}
+	return free_i;
+}
+
+static inline void netipv6_fib_nh_put(netipv6_fib_t *fib, uint16_t nh){
+	if( nh ) fib->nexthops[nh].refc--;
+}
+
+/*
+ * Returns the child 'c' of the node 'n'. If it doesn't exist and 'create' is
+ * non-0, an empty child is inserted. Returns 0, if there is no such child.
+ */
+static uint32_t netipv6_fib_child(netipv6_fib_t *fib, uint32_t n, uint32_t c, int create){
+	netipv6_fib_node_t *node;
+	uint32_t pos,k,b,i;
+	
+	node = &fib->nodes[n];
+	pos = POPCOUNT(node->external & ((1u<<c)-1));
+	if( node->external & (1u<<c) ) return node->child_base + pos;
+	if(! create ) return 0;
+	
+	/* Copy the children into a larger block, leaving a hole at 'pos'. */
+	k = POPCOUNT(node->external);
+	b = netipv6_fib_node_alloc(fib,k+1);
+	if(! b ) return 0;
+	for(i = 0 ; i < pos ; ++i) fib->nodes[b+i] = fib->nodes[node->child_base+i];
+	for(i = pos ; i < k ; ++i) fib->nodes[b+i+1] = fib->nodes[node->child_base+i];
+	net_bzero(&fib->nodes[b+pos],sizeof(netipv6_fib_node_t));
+	
+	netipv6_fib_node_free(fib,node->child_base,k);
+	node->child_base = b;
+	node->external |= 1u<<c;
+	return b+pos;
+}
+
+/*
+ * Removes the child 'c' of the node 'n'. The block shrinks in place; the
+ * last slot is freed as a block of size 1.
+ */
+static void netipv6_fib_child_remove(netipv6_fib_t *fib, uint32_t n, uint32_t c){
+	netipv6_fib_node_t *node;
+	uint32_t pos,k,i;
+	
+	node = &fib->nodes[n];
+	pos = POPCOUNT(node->external & ((1u<<c)-1));
+	k = POPCOUNT(node->external);
+	for(i = pos+1 ; i < k ; ++i) fib->nodes[node->child_base+i-1] = fib->nodes[node->child_base+i];
+	node->external &= ~(1u<<c);
+	netipv6_fib_node_free(fib,node->child_base+k-1,1);
+}
+
+/*
+ * Removes the prefix 'bit' from the node 'n'.
+ */
+static void netipv6_fib_result_remove(netipv6_fib_t *fib, uint32_t n, uint32_t bit){
+	netipv6_fib_node_t *node;
+	uint32_t pos,k,i;
+	
+	node = &fib->nodes[n];
+	pos = POPCOUNT(node->internal & ((1u<<bit)-1));
+	k = POPCOUNT(node->internal);
+	netipv6_fib_nh_put(fib,fib->results[node->result_base+pos]);
+	for(i = pos+1 ; i < k ; ++i) fib->results[node->result_base+i-1] = fib->results[node->result_base+i];
+	node->internal &= ~(1u<<bit);
+	netipv6_fib_result_free(fib,node->result_base+k-1,1);
+	fib->count--;
+}
+
+/*
+ * Removes empty nodes along 'path' (bottom up). 'path[i+1]' is the child
+ * 'chunks[i]' of 'path[i]'.
+ */
+static void netipv6_fib_prune(netipv6_fib_t *fib, uint32_t *path, uint8_t *chunks, uint32_t depth){
+	for( ; depth > 0 ; --depth){
+		if( fib->nodes[path[depth]].internal || fib->nodes[path[depth]].external ) break;
+		netipv6_fib_child_remove(fib,path[depth-1],chunks[depth-1]);
+	}
+}
+
+/*
+ * Removes all routes via 'nif' below the node 'n'.
+ * Returns non-0, if the node is empty afterwards.
+ */
+static int netipv6_fib_flush_node(netipv6_fib_t *fib, uint32_t n, netif_t *nif){
+	netipv6_fib_node_t *node;
+	uint32_t c,bit,pos;
+	
+	node = &fib->nodes[n];
+	
+	/* Go from the highest bit down, so that the positions below stay valid. */
+	for(c = 16 ; c-- > 0 ; ){
+		if(! (node->external & (1u<<c)) ) continue;
+		if( netipv6_fib_flush_node(fib,node->child_base + POPCOUNT(node->external & ((1u<<c)-1)),nif) )
+			netipv6_fib_child_remove(fib,n,c);
+	}
+	for(bit = 15 ; bit-- > 0 ; ){
+		if(! (node->internal & (1u<<bit)) ) continue;
+		pos = POPCOUNT(node->internal & ((1u<<bit)-1));
+		if( fib->nexthops[fib->results[node->result_base+pos]].nif == nif )
+			netipv6_fib_result_remove(fib,n,bit);
+	}
+	return !(node->internal || node->external);
+}
+
+int netipv6_fib_init(netipv6_fib_t *fib){
+	fib->seq   = 0;
+	fib->count = 0;
+	
+	fib->nodes   = net_malloc(sizeof(netipv6_fib_node_t)*(NETIPV6_FIB_NODE_MAX+FIB_SLACK));
+	fib->results = net_malloc(sizeof(uint16_t)*(NETIPV6_FIB_RESULT_MAX+FIB_SLACK));
+	
+	if( (!fib->nodes) || (!fib->results) ){
+		netipv6_fib_destroy(fib);
+		return -1;
+	}
+	
+	net_bzero(fib->nodes,sizeof(netipv6_fib_node_t)*(NETIPV6_FIB_NODE_MAX+FIB_SLACK));
+	net_bzero(fib->results,sizeof(uint16_t)*(NETIPV6_FIB_RESULT_MAX+FIB_SLACK));
+	net_bzero(fib->node_free,sizeof(fib->node_free));
+	net_bzero(fib->result_free,sizeof(fib->result_free));
+	net_bzero(fib->nexthops,sizeof(fib->nexthops));
+	fib->node_top   = 1;
+	fib->result_top = 1;
+	return 0;
+}
+
+void netipv6_fib_destroy(netipv6_fib_t *fib){
+	if( fib->nodes )   net_free(fib->nodes);
+	if( fib->results ) net_free(fib->results);
+	fib->nodes   = 0;
+	fib->results = 0;
+}
+
+int netipv6_fib_add(netipv6_fib_t *fib, const ipv6_addr_t *prefix, uint8_t length, netif_t *nif, const ipv6_addr_t *gateway){
+	static const ipv6_addr_t unspecified = {{0}};
+	netipv6_fib_node_t *node;
+	uint32_t path[FIB_LEVELS+1];
+	uint8_t chunks[FIB_LEVELS];
+	uint32_t level,n,c,bit,pos,k,b,i;
+	uint16_t nh,old;
+	int result = -1;
+	
+	if( (length > 128) || (! nif) ) return -1;
+	if(! gateway ) gateway = &unspecified;
+	
+	net_mutex_lock(fib->lock);
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	nh = netipv6_fib_nh_get(fib,nif,gateway);
+	if(! nh ) goto DONE;
+	
+	/* Walk down to the node, where the prefix ends, creating nodes as needed. */
+	path[0] = n = 0;
+	for(level = 0 ; level < (uint32_t)(length>>2) ; ++level){
+		chunks[level] = c = netipv6_fib_chunk(prefix,level);
+		n = netipv6_fib_child(fib,n,c,1);
+		if(! n ) goto FAIL;
+		path[level+1] = n;
+	}
+	
+	node = &fib->nodes[n];
+	bit = netipv6_fib_ibit(length & 3,netipv6_fib_chunk(prefix,level));
+	pos = POPCOUNT(node->internal & ((1u<<bit)-1));
+	
+	if( node->internal & (1u<<bit) ){
+		/* Replace the next hop of the existing route. */
+		old = fib->results[node->result_base+pos];
+		fib->results[node->result_base+pos] = nh;
+		netipv6_fib_nh_put(fib,old);
+	}else{
+		/* Copy the next hops into a larger block, inserting the new one at 'pos'. */
+		k = POPCOUNT(node->internal);
+		b = netipv6_fib_result_alloc(fib,k+1);
+		if(! b ) goto FAIL;
+		for(i = 0 ; i < pos ; ++i) fib->results[b+i] = fib->results[node->result_base+i];
+		for(i = pos ; i < k ; ++i) fib->results[b+i+1] = fib->results[node->result_base+i];
+		fib->results[b+pos] = nh;
+		
+		netipv6_fib_result_free(fib,node->result_base,k);
+		node->result_base = b;
+		node->internal |= 1u<<bit;
+		fib->count++;
+	}
+	result = 0;
+	goto DONE;
+	
+FAIL:
+	netipv6_fib_nh_put(fib,nh);
+	netipv6_fib_prune(fib,path,chunks,level);
+DONE:
+	net_seq_write_end(&(fib->seq));
+	
+	net_mutex_unlock(fib->lock);
+	return result;
+}
+
+int netipv6_fib_del(netipv6_fib_t *fib, const ipv6_addr_t *prefix, uint8_t length){
+	uint32_t path[FIB_LEVELS+1];
+	uint8_t chunks[FIB_LEVELS];
+	uint32_t level,n,c,bit;
+	int result = -1;
+	
+	if( length > 128 ) return -1;
+	
+	net_mutex_lock(fib->lock);
+	
+	path[0] = n = 0;
+	for(level = 0 ; level < (uint32_t)(length>>2) ; ++level){
+		chunks[level] = c = netipv6_fib_chunk(prefix,level);
+		n = netipv6_fib_child(fib,n,c,0);
+		if(! n ) goto UNLOCK;
+		path[level+1] = n;
+	}
+	
+	bit = netipv6_fib_ibit(length & 3,netipv6_fib_chunk(prefix,level));
+	if(! (fib->nodes[n].internal & (1u<<bit)) ) goto UNLOCK;
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	netipv6_fib_result_remove(fib,n,bit);
+	netipv6_fib_prune(fib,path,chunks,level);
+	result = 0;
+	
+	net_seq_write_end(&(fib->seq));
+UNLOCK:
+	net_mutex_unlock(fib->lock);
+	return result;
+}
+
+void netipv6_fib_flush_if(netipv6_fib_t *fib, netif_t *nif){
+	net_mutex_lock(fib->lock);
+	
+	net_seq_write_begin(&(fib->seq));
+	
+	netipv6_fib_flush_node(fib,0,nif);
+	
+	net_seq_write_end(&(fib->seq));
+	
+	net_mutex_unlock(fib->lock);
+}
+
+int netipv6_fib_lookup(netipv6_fib_t *fib, const ipv6_addr_t *dst, netif_t **nif, ipv6_addr_t *nexthop){
+	const netipv6_fib_node_t *node;
+	uint32_t seq,level,n,c,l,bit,internal,external;
+	uint16_t best;
+	netif_t *rnif;
+	ipv6_addr_t gateway;
+	
+	do{
+		seq = net_seq_read_begin(&(fib->seq));
+		
+		best = 0;
+		n = 0;
+		for(level = 0 ; ; ++level){
+			node = &fib->nodes[n];
+			c = netipv6_fib_chunk(dst,level);
+			
+			/* The longest prefix ending within this node. */
+			internal = node->internal;
+			if( internal ){
+				for(l = 4 ; l-- > 0 ; ){
+					bit = netipv6_fib_ibit(l,c);
+					if(! (internal & (1u<<bit)) ) continue;
+					best = fib->results[node->result_base + POPCOUNT(internal & ((1u<<bit)-1))];
+					break;
+				}
+			}
+			
+			external = node->external;
+			if( (level == FIB_LEVELS) || !(external & (1u<<c)) ) break;
+			n = node->child_base + POPCOUNT(external & ((1u<<c)-1));
+		}
+		
+		/* A racing update may have left us with garbage. The retry will fix it. */
+		if( best >= NETIPV6_FIB_NH_MAX ) best = 0;
+		rnif    = fib->nexthops[best].nif;
+		gateway = fib->nexthops[best].gateway;
+	}while( net_seq_read_retry(&(fib->seq),seq) );
+	
+	if(! best ) return -1;
+	
+	*nif     = rnif;
+	*nexthop = IP6_ADDR_IS_UNSPECIFIED(gateway) ? *dst : gateway;
+	return 0;
+}
+
+int netipv6_route(netif_t **nif, const ipv6_addr_t *dst, ipv6_addr_t *nexthop){
+	netif_t *rnif;
+	
+	if(! *nif ){
+		if( (! netipv6_fib) || netipv6_fib_lookup(netipv6_fib,dst,nif,nexthop) ) return -1;
+		return 1;
+	}
+	
+	/* Multicast and link-local destinations are never routed. */
+	if( (! IP6_ADDR_IS_MULTICAST(*dst)) && (! IP6_ADDR_IS_LINKLOCAL(*dst)) ){
+		if( netipv6_fib && (! netipv6_fib_lookup(netipv6_fib,dst,&rnif,nexthop)) && (rnif == *nif) ) return 1;
+	}
+	*nexthop = *dst;
+	return 0;
+}
+
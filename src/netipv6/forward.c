@@ -0,0 +1,122 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv6/forward.h>
+#include <netipv6/defs.h>
+#include <netipv6/ipv6_header.h>
+#include <netipv6/fib.h>
+#include <netipv6/srcsel.h>
+#include <neticmp6/output.h>
+#include <neticmp6/icmp6_header.h>
+#include <netif/ifapi.h>
+#include <netsock/addr.h>
+
+void netipv6_forward(netif_t *netif, netpkt_t *pkt){
+	fnet_ip6_header_t  *hdr;
+	netif_t            *onif;
+	ipv6_addr_t        nexthop;
+	net_sockaddr_t     src_addr;
+	net_sockaddr_t     dst_addr;
+	uint32_t           param = 0;
+	uint8_t            next_header;
+	uint8_t            type,code;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_ip6_header_t)) ) goto DROP;
+	
+	hdr = netpkt_data(pkt);
+	
+	src_addr.type  = NET_SKA_IN6;
+	src_addr.ip.v6 = hdr->source_addr;
+	dst_addr.type  = NET_SKA_IN6;
+	dst_addr.ip.v6 = hdr->destination_addr;
+	
+	/*
+	 * There is no multicast routing.
+	 *
+	 * RFC 4291 2.5.6: Routers must not forward any packets with Link-Local
+	 * source or destination addresses to other links.
+	 */
+	if( pkt->flags & (NETPKT_FLAG_BROAD_L2|NETPKT_FLAG_BROAD_L3) ) goto DROP;
+	
+	if(
+		IP6_ADDR_IS_MULTICAST(dst_addr.ip.v6) ||
+		IP6_ADDR_IS_LINKLOCAL(dst_addr.ip.v6) ||
+		IP6_ADDR_IS_LINKLOCAL(src_addr.ip.v6) ||
+		IP6_ADDR_IS_UNSPECIFIED(src_addr.ip.v6)
+	) goto DROP;
+	
+	/*
+	 * RFC 4443 3.3: If a router receives a packet with a Hop Limit of zero, or
+	 * if a router decrements a packet's Hop Limit to zero, it MUST discard the
+	 * packet and originate an ICMPv6 Time Exceeded message with Code 0.
+	 */
+	if( hdr->hop_limit <= 1 ){
+		type = FNET_ICMP6_TYPE_TIME_EXCEED;
+		code = FNET_ICMP6_CODE_TE_HOP_LIMIT;
+		goto ERROR;
+	}
+	
+	onif = 0;
+	if( netipv6_route(&onif,&(dst_addr.ip.v6),&nexthop) < 0 ){
+		type = FNET_ICMP6_TYPE_DEST_UNREACH;
+		code = FNET_ICMP6_CODE_DU_NO_ROUTE;
+		goto ERROR;
+	}
+	
+	/*
+	 * RFC 4443 3.2: A Packet Too Big MUST be sent by a router in response to a
+	 * packet that it cannot forward because the packet is larger than the MTU
+	 * of the outgoing link.
+	 */
+	if( NETPKT_LENGTH(pkt) > onif->netif_mtu ){
+		type  = FNET_ICMP6_TYPE_PACKET_TOOBIG;
+		code  = FNET_ICMP6_CODE_PTB;
+		param = (uint32_t)onif->netif_mtu;
+		goto ERROR;
+	}
+	
+	hdr->hop_limit--;
+	
+	/*
+	 * The packet is sent as is. The neighbor resolution finds the link-layer
+	 * address of the next hop, and puts the link-layer header into the
+	 * headroom. The source address is not ours, so it is not passed.
+	 */
+	pkt->flags |= NETPKT_FLAG_NH_ONLINK;
+	onif->netif_class->ifapi_send_l3_ipv6(onif,pkt,0,&nexthop);
+	return;
+	
+ERROR:
+	next_header = hdr->next_header;
+	
+	/* The ICMPv6 parameter. */
+	pkt->ipv6.error_pointer    = param;
+	pkt->ipv6.param_is_pointer = 0;
+	
+	/* neticmp6_error() expects the payload on the current level. */
+	if( netpkt_levelup(pkt) ) goto DROP;
+	
+	if( netpkt_pullfront(pkt,sizeof(fnet_ip6_header_t)) ) goto DROP;
+	
+	/* The error is sent from our address, facing the source. */
+	if(! netipv6_select_src_addr(netif,&(dst_addr.ip.v6),&(src_addr.ip.v6)) ) goto DROP;
+	
+	neticmp6_error(netif,pkt,next_header,&src_addr,&dst_addr,type,code);
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
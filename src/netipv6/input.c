@@ -22,6 +22,7 @@
 #include <netipv6/check.h>
 #include <netipv6/defs.h>
 #include <netipv6/exthdr.h>
+#include <netipv6/forward.h>
 #include <netprot/input.h>
 #include <netstd/endianness.h>
 
@@ -45,6 +46,18 @@ void netipv6_input( netif_t *netif, netpkt_t *pkt ){
 	pkt_length     = NETPKT_LENGTH(pkt);
 	total_length = hton16(hdr->length)+sizeof(fnet_ip6_header_t);
 	
+	/*
+	 * RFC 2675: A Payload Length of zero indicates a jumbogram. The actual length
+	 * is taken from the Jumbo Payload option, that must be carried in a
+	 * Hop-by-Hop Options header. Until then, the whole packet is taken.
+	 */
+	pkt->ipv6.jumbo = 0;
+	if( hdr->length == 0 ){
+		if( hdr->next_header != FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS ) goto DROP;
+		pkt->ipv6.jumbo = 1;
+		total_length = pkt_length;
+	}
+	
 	/*
 	 * Ensuring correct packet bounds, packet sanity.
 	 * 
@@ -66,10 +79,16 @@ void netipv6_input( netif_t *netif, netpkt_t *pkt ){
 	dst_addr.ip.v6 = hdr->destination_addr;
 	next_header    = hdr->next_header;
 	
-	if(
-		IP6_ADDR_IS_MULTICAST(src_addr.ip.v6)||
-		(!netipv6_addr_is_self(netif,&(dst_addr.ip.v6),pkt->flags))
-	) goto DROP;
+	if( IP6_ADDR_IS_MULTICAST(src_addr.ip.v6) ) goto DROP;
+	
+	/* If not for me, forward or drop! */
+	if(! netipv6_addr_is_self(netif,&(dst_addr.ip.v6),pkt->flags) ){
+		if( (netif->flags & NETIF_FORWARDING) && !IP6_ADDR_IS_MULTICAST(dst_addr.ip.v6) ){
+			netipv6_forward(netif,pkt);
+			return;
+		}
+		goto DROP;
+	}
 	
 	/*
 	 * Notify upper layer protocols, that the incoming datagram has a
@@ -97,8 +116,10 @@ void netipv6_input( netif_t *netif, netpkt_t *pkt ){
 	/********************************************
 	 * Extension headers processing.
 	 *********************************************/
-	netipv6_ext_header_process(netif, &next_header, &(src_addr.ip.v6), &(dst_addr.ip.v6), &pkt);
-	if(! pkt ) return;
+	if( NETIPV6_EXT_IS_HEADER(next_header) ){
+		netipv6_ext_header_process(netif, &next_header, &(src_addr.ip.v6), &(dst_addr.ip.v6), &pkt);
+		if(! pkt ) return;
+	}
 	
 	/* Note: (http://www.cisco.com/web/about/ac123/ac147/archived_issues/ipj_9-3/ipv6_internals.html)
 	 * Note that there is no standard extension header format, meaning that when a host
@@ -16,6 +16,142 @@
 
 #include <netipv6/multicast.h>
 #include <netipv6/if.h>
+#include <netipv6/defs.h>
+#include <netif/addrclass.h>
+#include <netstd/mem.h>
+#include <netstd/hash.h>
+
+#define MCAST_BLOOM_MASK (NETIPV6_IF_MULTCAST_BLOOM-1)
+
+static const ipv6_addr_t   ip6_addr_linklocal_allnodes       = IP6_ADDR_LINKLOCAL_ALLNODES_INIT;
+
+static inline void netipv6_multicast_bloom_set(volatile uint32_t *bloom, uint32_t h){
+	uint32_t b1 = h & MCAST_BLOOM_MASK;
+	uint32_t b2 = (h>>16) & MCAST_BLOOM_MASK;
+	bloom[b1>>5] |= 1u<<(b1&31);
+	bloom[b2>>5] |= 1u<<(b2&31);
+}
+
+static inline int netipv6_multicast_bloom_test(volatile uint32_t *bloom, uint32_t h){
+	uint32_t b1 = h & MCAST_BLOOM_MASK;
+	uint32_t b2 = (h>>16) & MCAST_BLOOM_MASK;
+	return (bloom[b1>>5] & (1u<<(b1&31))) && (bloom[b2>>5] & (1u<<(b2&31)));
+}
+
+/*
+ * Returns the slot of the group, or tab->size if not found.
+ */
+static uint32_t netipv6_multicast_find(netipv6_if_mcast_tab_t *tab, const ipv6_addr_t *ip_addr, uint32_t h){
+	uint32_t i,n,mask;
+	
+	if(! tab->size ) return 0;
+	mask = tab->size-1;
+	
+	for(i = h&mask, n = 0 ; n < tab->size ; n++, i = (i+1)&mask){
+		if(! tab->entries[i].used ) break;
+		if( IP6ADDR_EQ(*ip_addr,tab->entries[i].multicast) ) return i;
+	}
+	return tab->size;
+}
+
+/*
+ * Returns a free slot for the group. The table must not be full.
+ */
+static uint32_t netipv6_multicast_free_slot(netipv6_if_mcast_tab_t *tab, uint32_t h){
+	uint32_t i,mask;
+	
+	mask = tab->size-1;
+	for(i = h&mask ; tab->entries[i].used ; i = (i+1)&mask);
+	return i;
+}
+
+/*
+ * Reallocates the table with 'size' slots.
+ * Return 0 on success, non-0 on error.
+ */
+static int netipv6_multicast_resize(netipv6_if_mcast_tab_t *tab, uint32_t size){
+	netipv6_if_multicast_t *entries;
+	uint32_t i,j;
+	
+	entries = net_malloc(sizeof(netipv6_if_multicast_t)*size);
+	if(! entries ) return -1;
+	net_bzero(entries,sizeof(netipv6_if_multicast_t)*size);
+	
+	for(i = 0 ; i < tab->size ; ++i){
+		if(! tab->entries[i].used ) continue;
+		for(
+			j = net_hash128(tab->entries[i].multicast.addr32) & (size-1);
+			entries[j].used;
+			j = (j+1)&(size-1)
+		);
+		entries[j] = tab->entries[i];
+	}
+	
+	if( tab->entries ) net_free(tab->entries);
+	tab->entries = entries;
+	tab->size = size;
+	return 0;
+}
+
+/* The hash of a group table entry. */
+#define MCAST_HOME(e) net_hash128((e)->multicast.addr32)
+
+/*
+ * Removes the entry at slot 'i' (backward shift deletion).
+ */
+static void netipv6_multicast_remove(netipv6_if_mcast_tab_t *tab, uint32_t i){
+	NET_HASH_REMOVE(tab->entries,i,tab->size-1,MCAST_HOME);
+	tab->count--;
+}
+
+/*
+ * Shrinks the table, if it is less than 1/8 full.
+ */
+static void netipv6_multicast_shrink(netipv6_if_mcast_tab_t *tab){
+	if( (tab->size > NETIPV6_IF_MULTCAST_MIN) && ((tab->count*8) < tab->size) )
+		netipv6_multicast_resize(tab, tab->size/2); /* On failure, we keep the larger table. */
+}
+
+/*
+ * Recomputes the Bloom filter, after an entry has been removed.
+ *
+ * The filter is computed aside and stored word by word, so the bits of the
+ * remaining groups never disappear for concurrent readers.
+ */
+static void netipv6_multicast_bloom_rebuild(netipv6_if_mcast_tab_t *tab){
+	uint32_t bloom[NETIPV6_IF_MULTCAST_BLOOM/32];
+	uint32_t i;
+	
+	net_bzero(bloom,sizeof(bloom));
+	for(i = 0 ; i < tab->size ; ++i){
+		if(! tab->entries[i].used ) continue;
+		netipv6_multicast_bloom_set(bloom,net_hash128(tab->entries[i].multicast.addr32));
+	}
+	for(i = 0 ; i < (NETIPV6_IF_MULTCAST_BLOOM/32) ; ++i)
+		tab->bloom[i] = bloom[i];
+}
+
+/*
+ * RFC3810 6: The link-scope all-nodes address (FF02::1) is handled as a special
+ * case. It is never reported. Neither are groups of reserved or
+ * interface-local scope.
+ */
+int netipv6_multicast_reportable(const ipv6_addr_t *ip_addr){
+	if( IP6ADDR_EQ(*ip_addr,ip6_addr_linklocal_allnodes) ) return 0;
+	return IP6_ADDR_MULTICAST_SCOPE(*ip_addr) > 1;
+}
+
+/*
+ * Schedules State-Change Reports for the entry. Must hold the mcast_lock.
+ */
+static inline void netipv6_multicast_state_change(netipv6_if_t *nif6, netipv6_if_multicast_t *entry){
+	entry->reported = 0;
+	entry->rexmit = NETIPV6_IF_MLD_ROBUSTNESS;
+	
+	/* RFC3810 6.1: The report is sent as soon as possible. */
+	nif6->mld_change_pending = 1;
+	nif6->mld_change_time = net_timer_ms();
+}
 
 /*
  * Join a IPv6 multicast group.
@@ -23,41 +159,71 @@
  */
 int netipv6_multicast_join_prv(netif_t *netif, const ipv6_addr_t *ip_addr){
 	netipv6_if_t *nif6;
-	int i,freei;
-
+	netipv6_if_mcast_tab_t *tab;
+	uint32_t h,i;
+	int result = 0;
+	
 	nif6 = netif->ipv6;
-
-	freei = NETIPV6_IF_MULTCAST_MAX;
-	for( i = 0 ; i < NETIPV6_IF_MULTCAST_MAX ; ++i ){
-		if(! nif6->multicasts[i].used ){
-			if(freei == NETIPV6_IF_MULTCAST_MAX) freei = i;
-			continue;
-		}
-		if(! IP6ADDR_EQ(*ip_addr,nif6->multicasts[i].multicast) ) continue;
-		
+	tab = &(nif6->multicasts);
+	h = net_hash128(ip_addr->addr32);
+	
+	net_mutex_lock(nif6->mcast_lock);
+	
+	i = netipv6_multicast_find(tab,ip_addr,h);
+	if( i < tab->size ){
 		/* Increment usage counter. */
-		nif6->multicasts[i].refc++;
-		
-		/* MLDone already sent? */
-		if( nif6->multicasts[i].mlddone ){
-			nif6->multicasts[i].reported = 0;
-			nif6->multicasts[i].mlddone = 0;
+		if( tab->entries[i].refc++ ){
+			net_mutex_unlock(nif6->mcast_lock);
+			return 0;
 		}
-		return 0;
+		
+		/*
+		 * The group was being left. Cancel the MLD-Done and report the
+		 * group again.
+		 */
+		tab->entries[i].mlddone = 0;
+		netipv6_multicast_state_change(nif6,&(tab->entries[i]));
+		goto UNLOCK;
+	}
+	
+	if( tab->count >= NETIPV6_IF_MULTCAST_MAX ){
+		result = -1;
+		goto UNLOCK;
 	}
 	
 	/*
-	 * No free entry?
+	 * Keep the table at most half full.
 	 */
-	if( freei == NETIPV6_IF_MULTCAST_MAX) return -1;
+	if( ((tab->count+1)*2) > tab->size ){
+		if( netipv6_multicast_resize(tab, tab->size ? tab->size*2 : NETIPV6_IF_MULTCAST_MIN) ){
+			result = -1;
+			goto UNLOCK;
+		}
+	}
 	
-	nif6->multicasts[freei].multicast = *ip_addr;
-	nif6->multicasts[freei].refc = 1; /* Just created, so Reference counter will be 1. */
-	nif6->multicasts[freei].used = 1;
-	nif6->multicasts[freei].reported = 0;
-	nif6->multicasts[freei].mlddone = 0;
+	i = netipv6_multicast_free_slot(tab,h);
+	tab->entries[i].multicast = *ip_addr;
+	tab->entries[i].refc = 1; /* Just created, so Reference counter will be 1. */
+	tab->entries[i].used = 1;
+	tab->entries[i].mlddone = 0;
+	tab->entries[i].pending = 0;
+	tab->count++;
 	
-	return 0;
+	if( netipv6_multicast_reportable(ip_addr) )
+		netipv6_multicast_state_change(nif6,&(tab->entries[i]));
+	else{
+		tab->entries[i].reported = 1;
+		tab->entries[i].rexmit = 0;
+	}
+	
+	netipv6_multicast_bloom_set(tab->bloom,h);
+	
+UNLOCK:
+	net_mutex_unlock(nif6->mcast_lock);
+	
+	if(! result )
+		netif_addrclass_rebuild(netif);
+	return result;
 }
 
 /*
@@ -66,21 +232,115 @@ int netipv6_multicast_join_prv(netif_t *netif, const ipv6_addr_t *ip_addr){
  */
 int netipv6_multicast_leave_prv(netif_t *netif, const ipv6_addr_t *ip_addr){
 	netipv6_if_t *nif6;
-	int i;
-
+	netipv6_if_mcast_tab_t *tab;
+	uint32_t i;
+	int removed = 0;
+	
 	nif6 = netif->ipv6;
-
-	for( i = 0 ; i < NETIPV6_IF_MULTCAST_MAX ; ++i ){
-		if( nif6->multicasts[i].used ) continue;
-		if( IP6ADDR_EQ(*ip_addr,nif6->multicasts[i].multicast) ) break;
-	}
+	tab = &(nif6->multicasts);
+	
+	net_mutex_lock(nif6->mcast_lock);
+	
+	i = netipv6_multicast_find(tab,ip_addr,net_hash128(ip_addr->addr32));
 	
 	/* Not found? */
-	if( i == NETIPV6_IF_MULTCAST_MAX) return -1;
+	if( i >= tab->size ){
+		net_mutex_unlock(nif6->mcast_lock);
+		return -1;
+	}
+	
+	if(tab->entries[i].refc)
+		tab->entries[i].refc--;
+	
+	/* The last user has left the group. */
+	if(! tab->entries[i].refc ){
+		removed = 1;
+		tab->entries[i].pending = 0;
+		
+		/*
+		 * Report the change to the routers, unless they never learned about
+		 * the group, because it is not reportable or no report has been sent yet.
+		 * The entry is removed by netipv6_multicast_purge_prv(), when done.
+		 */
+		if( netipv6_multicast_reportable(ip_addr) &&
+			(tab->entries[i].reported || (tab->entries[i].rexmit < NETIPV6_IF_MLD_ROBUSTNESS)) )
+		{
+			netipv6_multicast_state_change(nif6,&(tab->entries[i]));
+		}else{
+			netipv6_multicast_remove(tab,i);
+			netipv6_multicast_bloom_rebuild(tab);
+			netipv6_multicast_shrink(tab);
+		}
+	}
 	
-	if(nif6->multicasts[i].refc)
-		nif6->multicasts[i].refc--;
+	net_mutex_unlock(nif6->mcast_lock);
+	
+	if( removed )
+		netif_addrclass_rebuild(netif);
 	return 0;
 }
 
+/*
+ * Returns non-0 if the interface has joined the IPv6 multicast group.
+ */
+int netipv6_multicast_is_member(netif_t *netif, const ipv6_addr_t *ip_addr){
+	netipv6_if_t *nif6;
+	uint32_t h,i;
+	int result;
+	
+	nif6 = netif->ipv6;
+	h = net_hash128(ip_addr->addr32);
+	
+	/* Fast reject: most foreign groups are filtered without taking the lock. */
+	if(! netipv6_multicast_bloom_test(nif6->multicasts.bloom,h) ) return 0;
+	
+	net_mutex_lock(nif6->mcast_lock);
+	i = netipv6_multicast_find(&(nif6->multicasts),ip_addr,h);
+	result = ((i < nif6->multicasts.size) && nif6->multicasts.entries[i].refc) ? -1 : 0;
+	net_mutex_unlock(nif6->mcast_lock);
+	
+	return result;
+}
+
+/*
+ * Returns the entry of the group, or NULL if not found.
+ * Must hold the mcast_lock.
+ */
+netipv6_if_multicast_t *netipv6_multicast_lookup_prv(netif_t *netif, const ipv6_addr_t *ip_addr){
+	netipv6_if_mcast_tab_t *tab;
+	uint32_t i;
+	
+	tab = &(netif->ipv6->multicasts);
+	
+	i = netipv6_multicast_find(tab,ip_addr,net_hash128(ip_addr->addr32));
+	if( i >= tab->size ) return 0;
+	return &(tab->entries[i]);
+}
+
+/*
+ * Removes the groups, that have been left and whose MLD-Done has been sent.
+ * Must hold the mcast_lock.
+ */
+void netipv6_multicast_purge_prv(netif_t *netif){
+	netipv6_if_mcast_tab_t *tab;
+	uint32_t i;
+	int removed = 0;
+	
+	tab = &(netif->ipv6->multicasts);
+	
+	for(i = 0 ; i < tab->size ; ){
+		if( tab->entries[i].used && tab->entries[i].mlddone && !tab->entries[i].refc ){
+			/* The backward shift moves the next entry into slot 'i'. */
+			netipv6_multicast_remove(tab,i);
+			removed = 1;
+			continue;
+		}
+		i++;
+	}
+	
+	if( removed ){
+		netipv6_multicast_bloom_rebuild(tab);
+		netipv6_multicast_shrink(tab);
+	}
+}
 
@@ -23,6 +23,8 @@
 #include <netipv6/ipv6_header.h>
 #include <netipv6/check.h>
 #include <netipv6/if.h>
+#include <netipv6/fib.h>
+#include <netipv6/srcsel.h>
 
 #include <netif/ifapi.h>
 
@@ -38,11 +40,27 @@ void netipv6_output(
 	uint8_t tclass
 ) {
 	fnet_ip6_header_t   *ip6_header;
+	uint8_t             *jumbo;
 	uint32_t            total_length;
 	uint32_t            payload_length;
 	ipv6_addr_t         dst_ip;
+	ipv6_addr_t         nexthop;
+	netif_t             *rnif;
+	int                 onlink;
 	
-	if(nif == 0) goto DROP;
+	/*
+	 * If no interface is given, the FIB selects the interface. The next hop is
+	 * handed to the neighbor resolution, so that it doesn't look it up again.
+	 */
+	rnif = nif;
+	onlink = netipv6_route(&rnif,&(dst_addr->ip.v6),&nexthop);
+	if( onlink < 0 ) goto DROP;
+	if(nif == 0){
+		nif = rnif;
+		if( IP6_ADDR_IS_UNSPECIFIED(src_addr->ip.v6) ){
+			if(! netipv6_select_src_addr(nif,&(src_addr->ip.v6),&(dst_addr->ip.v6)) ) goto DROP;
+		}
+	}
 	
 	/* RFC 4862: By disabling IP operation, the node will then not
 	 * send any IP packets from the interface.*/
@@ -65,6 +83,35 @@ void netipv6_output(
 	/****** Construct IP header. ******/
 	if( netpkt_leveldown(pkt) ) goto DROP;
 	
+	/*
+	 * RFC 2675: Payloads longer than 65,535 octets are sent as jumbograms, with
+	 * a zero Payload Length and a Jumbo Payload option in a Hop-by-Hop Options
+	 * header. The link MTU must be large enough anyways.
+	 */
+	if( payload_length > 0xffffu ){
+		/* We don't merge the option into an existing Hop-by-Hop Options header. */
+		if( protocol == FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS ) goto DROP;
+		
+		if( netpkt_pushfront( pkt, 8 ) ) goto DROP;
+		
+		if( netpkt_pullup_lite( pkt, 8 ) ) goto DROP;
+		
+		payload_length += 8;
+		
+		jumbo = netpkt_data(pkt);
+		jumbo[0] = protocol;                    /* Next Header. */
+		jumbo[1] = 0;                           /* Hdr Ext Len. */
+		jumbo[2] = FNET_IP6_OPTION_TYPE_JUMBO;  /* At offset 2, which satisfies 4n+2 alignment. */
+		jumbo[3] = 4;                           /* Opt Data Len. */
+		jumbo[4] = (uint8_t)(payload_length>>24);
+		jumbo[5] = (uint8_t)(payload_length>>16);
+		jumbo[6] = (uint8_t)(payload_length>>8);
+		jumbo[7] = (uint8_t)(payload_length);
+		
+		protocol       = FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS;
+		payload_length = 0;                     /* Payload Length field is 0. */
+	}
+	
 	if( netpkt_pushfront( pkt, sizeof(fnet_ip6_header_t) ) ) goto DROP;
 	
 	if( netpkt_pullup_lite( pkt, sizeof(fnet_ip6_header_t) ) ) goto DROP;
@@ -73,7 +120,7 @@ void netipv6_output(
 	ip6_header->version__tclass   =  (6 << 4) | (tclass>>4);
 	ip6_header->tclass__flowl     =  tclass << 4;
 	ip6_header->flowl             =  0u;
-	ip6_header->length            =  hton16((uint16_t)payload_length); /* XXX: jumbo frames? */
+	ip6_header->length            =  hton16((uint16_t)payload_length);
 	ip6_header->next_header       =  protocol;
 	ip6_header->hop_limit         =  hop_limit;
 	ip6_header->source_addr       =  src_addr->ip.v6;
@@ -86,9 +133,13 @@ void netipv6_output(
 		// TODO: IP fragmentation
 		goto DROP;
 	}else{
-		nif->netif_class->ifapi_send_l3_ipv6(nif,pkt,&(src_addr->ip.v6),&dst_ip);
+		if( onlink )
+			pkt->flags |= NETPKT_FLAG_NH_ONLINK;
+		else
+			pkt->flags &= ~NETPKT_FLAG_NH_ONLINK;
+		nif->netif_class->ifapi_send_l3_ipv6(nif,pkt,&(src_addr->ip.v6),&nexthop);
 	}
-
+	return;
 DROP:
 	netpkt_free(pkt);
 }
@@ -0,0 +1,227 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv6/srcsel.h>
+#include <netipv6/if.h>
+#include <netipv6/defs.h>
+#include <netstd/atomic.h>
+#include <netstd/hash.h>
+#include <netstd/seqlock.h>
+
+#define SRCSEL_CACHE_MASK (NETIPV6_IF_SRCSEL_CACHE_SIZE-1)
+
+/*
+ * RFC 6724 2.1: The default policy table. Only the labels are needed for the
+ * source address selection.
+ */
+typedef struct {
+	uint8_t   prefix[16];
+	uint8_t   prefix_length;
+	uint8_t   label;
+} netipv6_policy_t;
+
+static const netipv6_policy_t netipv6_policy_table[] = {
+	{ {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},                  128,  0 },  /* ::1/128       */
+	{ {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},                    0,  1 },  /* ::/0          */
+	{ {0,0,0,0,0,0,0,0,0,0,0xff,0xff,0,0,0,0},             96,  4 },  /* ::ffff:0:0/96 */
+	{ {0x20,0x02,0,0,0,0,0,0,0,0,0,0,0,0,0,0},             16,  2 },  /* 2002::/16     */
+	{ {0x20,0x01,0,0,0,0,0,0,0,0,0,0,0,0,0,0},             32,  5 },  /* 2001::/32     */
+	{ {0xfc,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},                 7, 13 },  /* fc00::/7      */
+	{ {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},                   96,  3 },  /* ::/96         */
+	{ {0xfe,0xc0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},             10, 11 },  /* fec0::/10     */
+	{ {0x3f,0xfe,0,0,0,0,0,0,0,0,0,0,0,0,0,0},             16, 12 },  /* 3ffe::/16     */
+};
+
+#define NETIPV6_POLICY_COUNT (sizeof(netipv6_policy_table)/sizeof(netipv6_policy_t))
+
+/*
+ * Returns the length of the longest common prefix of the two addresses.
+ */
+static uint32_t netipv6_common_prefix_len(const ipv6_addr_t *a, const uint8_t *b){
+	uint32_t i;
+	uint8_t x;
+	
+	for(i = 0 ; i < 16 ; ++i){
+		x = a->addr[i] ^ b[i];
+		if(! x ) continue;
+		return (i*8) + (__builtin_clz((uint32_t)x) - 24);
+	}
+	return 128;
+}
+
+/*
+ * RFC 6724 2.1: Label(A), the label of the longest matching prefix.
+ */
+static uint8_t netipv6_policy_label(const ipv6_addr_t *addr){
+	uint32_t i;
+	int best = 1, best_len = -1;
+	
+	for(i = 0 ; i < NETIPV6_POLICY_COUNT ; ++i){
+		if( (int)netipv6_policy_table[i].prefix_length <= best_len ) continue;
+		if( netipv6_common_prefix_len(addr,netipv6_policy_table[i].prefix) < netipv6_policy_table[i].prefix_length ) continue;
+		best     = netipv6_policy_table[i].label;
+		best_len = netipv6_policy_table[i].prefix_length;
+	}
+	return (uint8_t)best;
+}
+
+/*
+ * RFC 6724 3.1: Scope(A). Unicast addresses are treated like multicast
+ * addresses of the same scope: The loopback address and link-local addresses
+ * have link-local scope, all other unicast addresses have global scope.
+ */
+static int netipv6_addr_scope(const ipv6_addr_t *addr){
+	if( IP6_ADDR_IS_MULTICAST(*addr) ) return IP6_ADDR_MULTICAST_SCOPE(*addr);
+	if( IP6_ADDR_IS_LINKLOCAL(*addr) ) return 0x2;
+	if( (addr->addr32[0] == 0) && (addr->addr32[1] == 0) && (addr->addr32[2] == 0) &&
+		(addr->addr[12] == 0) && (addr->addr[13] == 0) && (addr->addr[14] == 0) && (addr->addr[15] == 1) )
+		return 0x2;
+	if( (addr->addr[0] == 0xfeU) && ((addr->addr[1] & 0xc0U) == 0xc0U) ) return 0x5; /* Site-local (deprecated). */
+	return 0xe;
+}
+
+/*
+ * RFC 6724 5: Compares the candidate source addresses SA and SB.
+ * Returns non-0, if SB is preferred over SA.
+ */
+static int netipv6_srcsel_prefer(const netipv6_if_addr_t *sa, const netipv6_if_addr_t *sb, const ipv6_addr_t *dest, int dest_scope, uint8_t dest_label){
+	int scope_a, scope_b, match_a, match_b;
+	uint32_t len_a, len_b, plen;
+	
+	/* Rule 1: Prefer same address. (Handled by the caller.) */
+	
+	/* Rule 2: Prefer appropriate scope. */
+	scope_a = netipv6_addr_scope(&(sa->address));
+	scope_b = netipv6_addr_scope(&(sb->address));
+	if( scope_a < scope_b ) return scope_a < dest_scope;
+	if( scope_b < scope_a ) return scope_b >= dest_scope;
+	
+	/* Rule 3: Avoid deprecated addresses. */
+	if( sa->state != sb->state ){
+		if( sa->state == FNET_NETIF_IP6_ADDR_STATE_DEPRECATED ) return 1;
+		if( sb->state == FNET_NETIF_IP6_ADDR_STATE_DEPRECATED ) return 0;
+	}
+	
+	/*
+	 * Rule 4: Prefer home addresses. Rule 5: Prefer outgoing interface.
+	 * Rule 5.5: Prefer addresses in a prefix advertised by the next-hop.
+	 * Not applicable, as there is no Mobile IPv6 and the selection is done
+	 * per interface.
+	 */
+	
+	/* Rule 6: Prefer matching label. */
+	match_a = (netipv6_policy_label(&(sa->address)) == dest_label);
+	match_b = (netipv6_policy_label(&(sb->address)) == dest_label);
+	if( match_a != match_b ) return match_b;
+	
+	/* Rule 7: Prefer temporary addresses. (There are no temporary addresses.) */
+	
+	/*
+	 * Rule 8: Use longest matching prefix. CommonPrefixLen(S, D) only looks at
+	 * the prefix portion of S.
+	 */
+	len_a = netipv6_common_prefix_len(dest,sa->address.addr);
+	plen  = sa->prefix_length ? sa->prefix_length : 64;
+	if( len_a > plen ) len_a = plen;
+	len_b = netipv6_common_prefix_len(dest,sb->address.addr);
+	plen  = sb->prefix_length ? sb->prefix_length : 64;
+	if( len_b > plen ) len_b = plen;
+	return len_b > len_a;
+}
+
+/*
+ * Performs the actual selection.
+ */
+static int netipv6_srcsel_compute(netif_t *nif, ipv6_addr_t *src, const ipv6_addr_t *dest){
+	netipv6_if_t *nif6;
+	netipv6_if_addr_t *best = 0, *cand;
+	int i, dest_scope;
+	uint8_t dest_label;
+	
+	nif6 = nif->ipv6;
+	
+	dest_scope = netipv6_addr_scope(dest);
+	dest_label = netipv6_policy_label(dest);
+	
+	for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
+		cand = &(nif6->addrs[i]);
+		
+		/* Skip NOT_USED addresses. */
+		if( !cand->used ) continue;
+		
+		/* RFC 6724 4: Tentative addresses are not candidates. */
+		if( cand->state == FNET_NETIF_IP6_ADDR_STATE_TENTATIVE ) continue;
+		
+		/* Rule 1: Prefer same address. */
+		if( IP6ADDR_EQ(cand->address,*dest) ){
+			best = cand;
+			break;
+		}
+		
+		if( (! best) || netipv6_srcsel_prefer(best,cand,dest,dest_scope,dest_label) ) best = cand;
+	}
+	
+	if(! best ) return 0;
+	*src = best->address;
+	return -1;
+}
+
+int netipv6_select_src_addr(netif_t *nif, ipv6_addr_t *src, const ipv6_addr_t *dest){
+	netipv6_if_srcsel_cache_t *cache;
+	netipv6_if_srcsel_entry_t *entry, copy;
+	uint32_t gen, seq, h;
+	
+	cache = &(nif->ipv6->srcsel);
+	h = net_hash128(dest->addr32) & SRCSEL_CACHE_MASK;
+	entry = &(cache->entries[h]);
+	
+	/*
+	 * The generation must be read before the selection, so that an address
+	 * change during the selection renders the new entry stale.
+	 */
+	gen = cache->addr_gen;
+	net_memory_barrier();
+	
+	/* Lookup the cache. */
+	seq = net_seq_read_begin(&(cache->seq));
+	copy = *entry;
+	if( (! net_seq_read_retry(&(cache->seq),seq)) && copy.used && (copy.gen == gen) && IP6ADDR_EQ(copy.destination,*dest) ){
+		*src = copy.source;
+		return -1;
+	}
+	
+	if(! netipv6_srcsel_compute(nif,src,dest) ) return 0;
+	
+	/* Update the cache. */
+	net_mutex_lock(cache->lock);
+	net_seq_write_begin(&(cache->seq));
+	
+	entry->destination = *dest;
+	entry->source      = *src;
+	entry->gen         = gen;
+	entry->used        = 1;
+	
+	net_seq_write_end(&(cache->seq));
+	net_mutex_unlock(cache->lock);
+	
+	return -1;
+}
+
+void netipv6_srcsel_invalidate(netif_t *nif){
+	if(! nif->ipv6 ) return;
+	net_atomic_fetch_add(&(nif->ipv6->srcsel.addr_gen),1);
+}
+
@@ -0,0 +1,93 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netipv6/srh.h>
+#include <netipv6/ipv6_header.h>
+#include <netipv6/check.h>
+#include <netipv6/defs.h>
+#include <netipv6/forward.h>
+
+int netipv6_srh_process(netif_t *nif, netpkt_t *pkt, size_t size, ipv6_addr_t *dst){
+	fnet_ip6_srh_t      *srh;
+	fnet_ip6_header_t   *ip6_header;
+	ipv6_addr_t         *segments;
+	ipv6_addr_t         next;
+	uint32_t            entries;
+	
+	srh = netpkt_data(pkt);
+	segments = (ipv6_addr_t*)&srh[1];
+	
+	/*
+	 * RFC 8754 4.3.1.1: If Last Entry > max_last_entry [...] or Segments Left
+	 * is greater than (Last Entry+1), send an ICMP Parameter Problem, Code 0,
+	 * to the Source Address, pointing to the offending field, and discard the
+	 * packet.
+	 *
+	 * max_last_entry = ( Hdr Ext Len / 2 ) - 1
+	 */
+	entries = (uint32_t)srh->last_entry + 1;
+	if( (entries*sizeof(ipv6_addr_t)) > (size - sizeof(fnet_ip6_srh_t)) ){
+		pkt->ipv6.error_pointer += 4;
+		return NETIPV6_SRH_ICMP;
+	}
+	if( srh->routing_header.segments_left > entries ){
+		pkt->ipv6.error_pointer += 3;
+		return NETIPV6_SRH_ICMP;
+	}
+	
+	/*
+	 * Decrement Segments Left by 1.
+	 * Copy Segment List[Segments Left] from the SRH to the destination address
+	 * of the IPv6 header.
+	 */
+	srh->routing_header.segments_left--;
+	next = segments[srh->routing_header.segments_left];
+	
+	/* RFC 8754 4.3.1.1: If the updated IPv6 Destination Address is multicast, discard the packet. */
+	if( IP6_ADDR_IS_MULTICAST(next) || IP6_ADDR_IS_UNSPECIFIED(next) ) return NETIPV6_SRH_DROP;
+	
+	/* Select the IPv6 header. */
+	if( netpkt_switchlevel(pkt,-1) ) return NETIPV6_SRH_DROP;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_ip6_header_t)) ) return NETIPV6_SRH_DROP;
+	
+	ip6_header = netpkt_data(pkt);
+	ip6_header->destination_addr = next;
+	*dst = next;
+	
+	if( netipv6_addr_is_self(nif,&next,pkt->flags) ){
+		/*
+		 * The next segment is ourself. The remaining segments are processed
+		 * locally, without a round trip through the interface.
+		 */
+		if( netpkt_switchlevel(pkt,1) ) return NETIPV6_SRH_DROP;
+		if( netpkt_pullup(pkt,size) ) return NETIPV6_SRH_DROP;
+		return NETIPV6_SRH_LOCAL;
+	}
+	
+	/*
+	 * Resubmit the packet to the IPv6 module for transmission to the new
+	 * destination. The SRH, that has been updated in place, is sent as is.
+	 *
+	 * netipv6_forward() selects the outgoing interface and the next hop from
+	 * the FIB, and handles the Hop Limit: RFC 8754 4.3.1.1: If the IPv6 Hop
+	 * Limit is less than or equal to 1, send an ICMP Time Exceeded [...] and
+	 * discard the packet.
+	 */
+	netipv6_forward(nif,pkt);
+	return NETIPV6_SRH_FORWARDED;
+}
+
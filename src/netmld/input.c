@@ -0,0 +1,118 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netmld/input.h>
+#include <netmld/mld_header.h>
+#include <netipv6/if.h>
+#include <netipv6/defs.h>
+#include <netipv6/multicast.h>
+#include <netstd/endianness.h>
+#include <netstd/random.h>
+#include <netstd/time.h>
+
+/*
+ * RFC3810 5.1.3: Decodes the Maximum Response Code into the Maximum Response
+ * Delay (in ms).
+ *
+ *   0 1 2 3 4 5 6 7 8 9 A B C D E F
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |1| exp |          mant         |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+static net_time_t netmld_max_resp_delay(uint16_t code){
+	if( code < 32768u ) return code;
+	return ((net_time_t)((code & 0x0fffu) | 0x1000u)) << (((code >> 12) & 0x7u) + 3);
+}
+
+void netmld_query_receive(netif_t *nif, netpkt_t *pkt, ipv6_addr_t *src_ip){
+	netipv6_if_t                *nif6;
+	netipv6_if_multicast_t      *entry;
+	fnet_mld_header_t           *query;
+	ipv6_addr_t                 group;
+	net_time_t                  now, delay, due;
+	uint32_t                    length;
+	
+	nif6 = nif->ipv6;
+	
+	length = NETPKT_LENGTH(pkt);
+	
+	/*
+	 * RFC3810 5.1.14: Queries with a source address, that is not link-local, are
+	 * silently discarded. The length tells MLDv1 (24 octets) from MLDv2 Queries
+	 * (28 octets or more).
+	 */
+	if( !IP6_ADDR_IS_LINKLOCAL(*src_ip) ) goto DROP;
+	if( length < sizeof(fnet_mld_header_t) ) goto DROP;
+	if( (length > sizeof(fnet_mld_header_t)) && (length < sizeof(fnet_mld_query_v2_t)) ) goto DROP;
+	
+	/* The header must reside in contiguous area of memory. */
+	if( netpkt_pullup(pkt,sizeof(fnet_mld_header_t)) ) goto DROP;
+	
+	query = netpkt_data(pkt);
+	group = query->multicast_addr;
+	
+	/*
+	 * MLDv1 carries the Maximum Response Delay in ms, in MLDv2 it is encoded as
+	 * Maximum Response Code, whose values below 32768 equal the MLDv1 encoding.
+	 */
+	delay = netmld_max_resp_delay(ntoh16(query->max_resp_code));
+	
+	/*
+	 * RFC3810 6.2: The response is delayed by a random amount of time, chosen
+	 * from the range (0, [Maximum Response Delay]). This spreads the Reports of
+	 * all listeners on the link.
+	 */
+	now = net_timer_ms();
+	due = now + (delay ? (net_random_u32() % delay) : 0);
+	
+	net_mutex_lock(nif6->mcast_lock);
+	
+	if( IP6_ADDR_IS_UNSPECIFIED(group) ){
+		/*
+		 * General Query: If there is a pending response to a previous General
+		 * Query, scheduled sooner than the selected delay, no additional response
+		 * needs to be scheduled.
+		 */
+		if( !(nif6->mld_general_pending && (nif6->mld_general_time <= due)) ){
+			nif6->mld_general_pending = 1;
+			nif6->mld_general_time = due;
+		}
+	}else{
+		/*
+		 * Multicast Address Specific Query: The group is reported with the
+		 * pending General Query response anyways, if this one is due sooner.
+		 */
+		if( nif6->mld_general_pending && (nif6->mld_general_time <= due) ) goto UNLOCK;
+		
+		/*
+		 * Multicast Address and Source Specific Queries are answered in the same
+		 * way, as we listen to all sources.
+		 */
+		entry = netipv6_multicast_lookup_prv(nif,&group);
+		if( (! entry) || (! entry->refc) || !netipv6_multicast_reportable(&group) ) goto UNLOCK;
+		
+		if( !(entry->pending && (entry->report_time <= due)) ){
+			entry->pending = 1;
+			entry->report_time = due;
+		}
+	}
+	
+UNLOCK:
+	net_mutex_unlock(nif6->mcast_lock);
+DROP:
+	netpkt_free(pkt);
+}
+
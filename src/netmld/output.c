@@ -0,0 +1,111 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netmld/output.h>
+#include <netmld/mld_header.h>
+#include <netipv6/output.h>
+#include <netipv6/ipv6.h>
+#include <netipv6/ipv6_header.h>
+#include <netipv6/defs.h>
+#include <netipv6/if.h>
+#include <netprot/checksum.h>
+#include <netprot/defaults.h>
+#include <netsock/addr.h>
+#include <netstd/mem.h>
+
+static const ipv6_addr_t   ip6_addr_linklocal_allv2routers       = IP6_ADDR_LINKLOCAL_ALLV2ROUTERS_INIT;
+
+/*
+ * RFC3810 5.2.13: MLDv2 Reports [...] MUST be sent with a valid IPv6
+ * link-local source address, or the unspecified address (::), if the sending
+ * interface has not acquired a valid link-local address yet.
+ */
+static void netmld_select_src(netif_t *nif, ipv6_addr_t *src){
+	netipv6_if_t *nif6;
+	int i;
+	
+	nif6 = nif->ipv6;
+	
+	for(i=0;i<NETIPV6_IF_ADDR_MAX;++i){
+		if( !nif6->addrs[i].used ) continue;
+		if( nif6->addrs[i].state == FNET_NETIF_IP6_ADDR_STATE_TENTATIVE ) continue;
+		if( IP6_ADDR_IS_LINKLOCAL(nif6->addrs[i].address) ){
+			*src = nif6->addrs[i].address;
+			return;
+		}
+	}
+	net_bzero(src,sizeof(ipv6_addr_t));
+}
+
+void netmld_report_send(netif_t *nif, netpkt_t *chain){
+	netpkt_t                *pkt;
+	fnet_mld_report_v2_t    *report;
+	netipv6_ext_generic_t   *hbh;
+	uint8_t                 *options;
+	uint16_t                checksum;
+	net_sockaddr_t          src_addr;
+	net_sockaddr_t          dst_addr;
+	
+	src_addr.type  = NET_SKA_IN6;
+	netmld_select_src(nif,&(src_addr.ip.v6));
+	dst_addr.type  = NET_SKA_IN6;
+	dst_addr.ip.v6 = ip6_addr_linklocal_allv2routers;
+	
+	while(chain){
+		pkt = chain;
+		chain = chain->next_chain;
+		pkt->next_chain = 0;
+		
+		report = netpkt_data(pkt);
+		
+		/* Checksum calculation.*/
+		report->icmp6_header.checksum = 0u;
+		checksum = netprot_checksum_pseudo_start(pkt,IP_PROTOCOL_ICMP6,NETPKT_LENGTH(pkt));
+		report->icmp6_header.checksum = netprot_checksum_pseudo_end(
+				checksum,
+				(uint8_t*)&(src_addr.ip.v6),
+				(uint8_t*)&(dst_addr.ip.v6),
+				sizeof(ipv6_addr_t)
+		);
+		
+		/*
+		 * RFC3810 5: All MLDv2 messages [...] MUST be sent with [...] an IPv6
+		 * Router Alert option in a Hop-by-Hop Options header.
+		 */
+		if( netpkt_pushfront( pkt, 8 ) ) goto DROP;
+		
+		if( netpkt_pullup_lite( pkt, 8 ) ) goto DROP;
+		
+		hbh = netpkt_data(pkt);
+		hbh->next_header    = IP_PROTOCOL_ICMP6;
+		hbh->hdr_ext_length = 0;
+		
+		options = (uint8_t*)&hbh[1];
+		options[0] = FNET_IP6_OPTION_TYPE_ROUTER_ALERT;
+		options[1] = 2;     /* Opt Data Len. */
+		options[2] = 0;     /* Value 0: Datagram contains a Multicast Listener Discovery message. */
+		options[3] = 0;
+		options[4] = FNET_IP6_OPTION_TYPE_PADN;
+		options[5] = 0;
+		
+		/* RFC3810 5: [...] with a link-local IPv6 Source Address, an IPv6 Hop Limit of 1 [...] */
+		netipv6_output(nif,pkt,&src_addr,&dst_addr,FNET_IP6_TYPE_HOP_BY_HOP_OPTIONS,1,0);
+		continue;
+DROP:
+		netpkt_free(pkt);
+	}
+}
+
@@ -0,0 +1,182 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#include <netmld/timer.h>
+#include <netmld/output.h>
+#include <netmld/mld_header.h>
+#include <netipv6/if.h>
+#include <netipv6/defs.h>
+#include <netipv6/multicast.h>
+#include <netipv6/ipv6_header.h>
+#include <netmem/allocpkt.h>
+#include <netstd/endianness.h>
+#include <netstd/random.h>
+#include <netstd/time.h>
+
+/* IPv6 header + Hop-by-Hop Options header (Router Alert). */
+#define NETMLD_OVERHEAD (sizeof(fnet_ip6_header_t) + 8)
+
+/*
+ * A Report message, that is being filled with Multicast Address Records.
+ */
+typedef struct {
+	netpkt_t              *chain;   /* Finished Reports. */
+	netpkt_t              *pkt;     /* Current Report. */
+	fnet_mld_report_v2_t  *report;
+	uint32_t              count;    /* Records in the current Report. */
+	uint32_t              max;      /* Maximum records per Report. */
+	netpkt_t              **tail;
+} netmld_builder_t;
+
+static void netmld_builder_finish(netmld_builder_t *b){
+	if(! b->pkt ) return;
+	b->report->number_of_records = hton16((uint16_t)b->count);
+	netpkt_setlength(b->pkt, sizeof(fnet_mld_report_v2_t) + (b->count*sizeof(fnet_mld_record_t)) );
+	*(b->tail) = b->pkt;
+	b->tail = &(b->pkt->next_chain);
+	b->pkt = 0;
+}
+
+/*
+ * Appends a Multicast Address Record to the current Report, starting a new one
+ * if it is full.
+ * Return 0 on success, non-0 on error.
+ */
+static int netmld_builder_add(netmld_builder_t *b, uint8_t record_type, const ipv6_addr_t *group){
+	fnet_mld_record_t *record;
+	
+	if( b->pkt && (b->count >= b->max) ) netmld_builder_finish(b);
+	
+	if(! b->pkt ){
+		b->pkt = netmem_alloc_pkt(sizeof(fnet_mld_report_v2_t) + (b->max*sizeof(fnet_mld_record_t)));
+		if(! b->pkt ) return -1;
+		b->pkt->next_chain = 0;
+		b->report = netpkt_data(b->pkt);
+		b->report->icmp6_header.type = FNET_ICMP6_TYPE_MULTICAST_LISTENER_REPORT_V2;
+		b->report->icmp6_header.code = 0u;
+		b->report->_reserved = 0u;
+		b->count = 0;
+	}
+	
+	record = ((fnet_mld_record_t*)&(b->report[1])) + b->count;
+	record->record_type       = record_type;
+	record->aux_data_len      = 0u;
+	record->number_of_sources = 0u;
+	record->multicast_addr    = *group;
+	b->count++;
+	return 0;
+}
+
+void netmld_timer(netif_t *nif){
+	netipv6_if_t                *nif6;
+	netipv6_if_mcast_tab_t      *tab;
+	netipv6_if_multicast_t      *entry;
+	netmld_builder_t            builder;
+	net_time_t                  now;
+	size_t                      mtu;
+	uint32_t                    i;
+	int                         general_due, change_due, change_more = 0, done = 0, nomem = 0;
+	uint8_t                     record_type;
+	
+	nif6 = nif->ipv6;
+	
+	if(! nif6 ) return;
+	
+	mtu = nif->netif_mtu;
+	if( mtu < IP6_DEFAULT_MTU ) mtu = IP6_DEFAULT_MTU;
+	
+	builder.chain = 0;
+	builder.pkt   = 0;
+	builder.tail  = &(builder.chain);
+	builder.max   = (mtu - NETMLD_OVERHEAD - sizeof(fnet_mld_report_v2_t)) / sizeof(fnet_mld_record_t);
+	
+	now = net_timer_ms();
+	
+	net_mutex_lock(nif6->mcast_lock);
+	
+	tab = &(nif6->multicasts);
+	
+	general_due = nif6->mld_general_pending && (nif6->mld_general_time <= now);
+	change_due  = nif6->mld_change_pending  && (nif6->mld_change_time  <= now);
+	
+	/*
+	 * Collect the records of all groups, that are due, into as few Reports as
+	 * possible.
+	 */
+	for(i = 0 ; i < tab->size ; ++i){
+		entry = &(tab->entries[i]);
+		if(! entry->used ) continue;
+		
+		if( change_due && entry->rexmit ){
+			/*
+			 * RFC3810 6.1: State-Change Report. We listen to all sources, so a join is
+			 * a change to EXCLUDE {}, and a leave is a change to INCLUDE {}.
+			 */
+			record_type = entry->refc ? FNET_MLD_RECORD_CHANGE_TO_EXCLUDE_MODE : FNET_MLD_RECORD_CHANGE_TO_INCLUDE_MODE;
+			if( netmld_builder_add(&builder,record_type,&(entry->multicast)) ){
+				nomem = 1;
+				break;
+			}
+			
+			/* RFC3810 6.1: The State-Change Report is retransmitted [Robustness Variable] times. */
+			if( --(entry->rexmit) ) change_more = 1;
+			else if( entry->refc ) entry->reported = 1;
+			else { entry->mlddone = 1; done = 1; }
+			
+			/* This Report also carries the current state. */
+			entry->pending = 0;
+			continue;
+		}
+		
+		if(! entry->refc ) continue;
+		if(! netipv6_multicast_reportable(&(entry->multicast)) ) continue;
+		
+		/*
+		 * RFC3810 6.3: Current-State Report, as response to a General or a
+		 * Multicast Address Specific Query.
+		 */
+		if( general_due || (entry->pending && (entry->report_time <= now)) ){
+			if( netmld_builder_add(&builder,FNET_MLD_RECORD_MODE_IS_EXCLUDE,&(entry->multicast)) ){
+				nomem = 1;
+				break;
+			}
+			entry->pending = 0;
+		}
+	}
+	
+	netmld_builder_finish(&builder);
+	
+	/*
+	 * Reschedule. When running out of memory, retry later with the records,
+	 * that could not be sent.
+	 */
+	if( general_due && !nomem ) nif6->mld_general_pending = 0;
+	if( change_due ){
+		if( change_more || nomem )
+			nif6->mld_change_time = now + (net_random_u32() % FNET_MLD_UNSOLICITED_REPORT_INTERVAL);
+		else
+			nif6->mld_change_pending = 0;
+	}
+	
+	/* Remove the groups, we have left. */
+	if( done ) netipv6_multicast_purge_prv(nif);
+	
+	net_mutex_unlock(nif6->mcast_lock);
+	
+	if( builder.chain ) netmld_report_send(nif,builder.chain);
+}
+
@@ -192,8 +192,7 @@ void netnd6_neighbor_advertisement_receive(netif_t *nif,netpkt_t *pkt, ipv6_addr
 			/* - It sends any packets queued for the neighbor awaiting address
 			 *   resolution.
 			 */
-			pkts = neighbor_cache_entry->waiting_pkts;
-			neighbor_cache_entry->waiting_pkts = 0;
+			pkts = netpkt_queue_flush(&(neighbor_cache_entry->waiting_pkts), &(nif->nd6->waiting_stats));
 			queue_addr = neighbor_cache_entry->ip_addr;
 		}
 		else
@@ -255,8 +255,7 @@ static void netnd6_nsol_handle_lla(
 		 * - It sends any packets queued for the neighbor awaiting address
 		 *   resolution.
 		 */
-		pkts = neighbor_cache_entry->waiting_pkts;
-		neighbor_cache_entry->waiting_pkts = 0;
+		pkts = netpkt_queue_flush(&(neighbor_cache_entry->waiting_pkts), &(nif->nd6->waiting_stats));
 		queue_addr = neighbor_cache_entry->ip_addr;
 	}
 	net_mutex_unlock(nif->nd6->nd6_lock);
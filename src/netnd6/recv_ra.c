@@ -22,6 +22,7 @@
 #include <netnd6/nd6_header.h>
 #include <netnd6/if.h>
 #include <netnd6/table.h>
+#include <netnd6/timer.h>
 #include <netnd6/ipv6check.h>
 #include <netnd6/pktcheck.h>
 
@@ -30,15 +31,12 @@
 #include <netipv6/ctrl.h>
 #include <netipv6/check.h>
 #include <netipv6/if.h>
+#include <netipv6/srcsel.h>
 
 #include <netif/ifapi.h>
 
 #include <netstd/endianness.h>
 
-/* TODO: move this elsewhere. */
-#define FNET_IP6_DEFAULT_MTU     1280u   /* Minimum IPv6 datagram size which    
-                                          * must be supported by all IPv6 hosts */
-
 /************************************************************************
 * DESCRIPTION: Adds entry into the Router List.
 *************************************************************************/
@@ -190,7 +188,15 @@ void netnd6_router_advertisement_receive(netif_t *nif,netpkt_t *pkt, ipv6_addr_t
 	 */
 	if(pkt_reachable_time != 0u)
 	{
-		nif->nd6->reachable_time = ntoh32(pkt_reachable_time);
+		/*
+		 * RFC4861 6.3.4: If the new value differs from the previous value, the host
+		 * SHOULD re-compute a new random ReachableTime value.
+		 */
+		if(nif->nd6->base_reachable_time != ntoh32(pkt_reachable_time))
+		{
+			nif->nd6->base_reachable_time = ntoh32(pkt_reachable_time);
+			netnd6_reachable_time_update(nif);
+		}
 	}
 	
 	/*
@@ -212,9 +218,9 @@ void netnd6_router_advertisement_receive(netif_t *nif,netpkt_t *pkt, ipv6_addr_t
 	{
 		if(mtu < nif->nd6->mtu)
 		{
-			if(mtu < FNET_IP6_DEFAULT_MTU)
+			if(mtu < IP6_DEFAULT_MTU)
 			{
-				mtu = FNET_IP6_DEFAULT_MTU;
+				mtu = IP6_DEFAULT_MTU;
 			}
 			nif->nd6->mtu =  mtu;
 			if(nif->ipv6->pmtu > mtu) nif->ipv6->pmtu = mtu;
@@ -251,8 +257,7 @@ void netnd6_router_advertisement_receive(netif_t *nif,netpkt_t *pkt, ipv6_addr_t
 		/*
 		 * Sends any packets queued for the neighbor awaiting address resolution.
 		 */
-		pkts = neighbor_cache_entry->waiting_pkts;
-		neighbor_cache_entry->waiting_pkts = 0;
+		pkts = netpkt_queue_flush(&(neighbor_cache_entry->waiting_pkts), &(nif->nd6->waiting_stats));
 		queue_addr = neighbor_cache_entry->ip_addr;
         }
 	else
@@ -415,6 +420,22 @@ static void netnd6_ra_prefix_option(netif_t *nif, fnet_nd6_option_prefix_header_
 				addr_info->lifetime = (60u * 60u * 2u) /* 2 hours */;
 			}
 			addr_info->creation_time = net_timer_seconds();
+			
+			/*
+			 * RFC4862 5.5.4: An address is deprecated, when its preferred lifetime
+			 * expires. A Preferred Lifetime of zero deprecates it immediately.
+			 */
+			if( addr_info->state != FNET_NETIF_IP6_ADDR_STATE_TENTATIVE ){
+				if( nd_option_prefix->prefered_lifetime == 0u ){
+					if( addr_info->state != FNET_NETIF_IP6_ADDR_STATE_DEPRECATED ){
+						addr_info->state = FNET_NETIF_IP6_ADDR_STATE_DEPRECATED;
+						netipv6_srcsel_invalidate(nif);
+					}
+				}else if( addr_info->state == FNET_NETIF_IP6_ADDR_STATE_DEPRECATED ){
+					addr_info->state = FNET_NETIF_IP6_ADDR_STATE_PREFERRED;
+					netipv6_srcsel_invalidate(nif);
+				}
+			}
 		}
 		else
 		{
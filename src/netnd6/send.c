@@ -115,6 +115,8 @@ void netnd6_neighbor_solicitation_send(netif_t *nif, ipv6_addr_t *src_ip /* NULL
 	 */
 	if(! (pkt = netmem_alloc_pkt(na_packet_size)) ) return;
 	
+	ns_packet                    = netpkt_data(pkt);
+	
 	/*
          * Neighbor Solicitations are multicast when the node needs
          * to resolve an address and unicast when the node seeks to verify the
@@ -165,8 +167,7 @@ void netnd6_neighbor_solicitation_send(netif_t *nif, ipv6_addr_t *src_ip /* NULL
 	}
 	
 	/* Fill ICMP Header */
-	ns_packet                    = netpkt_data(pkt);
-	ns_packet->icmp6_header.type = FNET_ICMP6_TYPE_NEIGHBOR_ADVERTISEMENT;
+	ns_packet->icmp6_header.type = FNET_ICMP6_TYPE_NEIGHBOR_SOLICITATION;
 	ns_packet->icmp6_header.code = 0u;
 	
 	/* Fill NS Header.*/
@@ -144,6 +144,12 @@ fnet_nd6_neighbor_entry_t* netnd6_neighbor_cache_add2(netif_t *nif, ipv6_addr_t
 	
 	/* Fill the informationn.*/
 	
+	/* Drop the packets, that are still waiting on the recycled entry.*/
+	if( entry->waiting_pkts.length ){
+		nd6_if->waiting_stats.drops_evict += entry->waiting_pkts.length;
+		netpkt_free_all(netpkt_queue_flush(&(entry->waiting_pkts), &(nd6_if->waiting_stats)));
+	}
+	
 	/* Clear entry structure.*/
 	net_bzero(entry,sizeof(fnet_nd6_neighbor_entry_t) );
 	entry->ip_addr = *src_ip;
@@ -159,6 +165,66 @@ fnet_nd6_neighbor_entry_t* netnd6_neighbor_cache_add2(netif_t *nif, ipv6_addr_t
 	return entry;
 }
 
+int netnd6_confirm_reachable(netif_t *nif, const ipv6_addr_t *addr){
+	netnd6_if_t                 *nd6_if;
+	int                         i;
+	
+	nd6_if = nif->nd6;
+	
+	if (! nd6_if) return 0;
+	
+	/*
+	 * RFC4861 7.3.1: A neighbor is considered reachable if the node has recently
+	 * received a confirmation that packets sent recently to the neighbor were
+	 * received by its IP layer. Positive confirmation can be gathered from
+	 * hints from upper-layer protocols.
+	 *
+	 * This is called on hot paths (eg. for every TCP ACK), so we don't take the
+	 * nd6-lock. We only stamp the entry; netnd6_timer() applies the state change.
+	 * A race with an entry being recycled only costs us one unneeded probe.
+	 */
+	for(i = 0u; i < FNET_ND6_NEIGHBOR_CACHE_SIZE; i++)
+	{
+		if( (nd6_if->neighbor_cache[i].state != FNET_ND6_NEIGHBOR_STATE_NOTUSED) &&
+			IP6ADDR_EQ(nd6_if->neighbor_cache[i].ip_addr, *addr))
+		{
+			nd6_if->neighbor_cache[i].confirm_time = net_timer_ms();
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void netnd6_confirm_router(netif_t *nif){
+	netnd6_if_t                 *nd6_if;
+	int                         i;
+	
+	nd6_if = nif->nd6;
+	
+	if (! nd6_if) return;
+	
+	/*
+	 * Lock-free, like netnd6_confirm_reachable(). This stamps the router, that
+	 * netnd6_get_router() prefers: the first reachable one.
+	 */
+	for(i = 0u; i < FNET_ND6_NEIGHBOR_CACHE_SIZE; i++)
+	{
+		switch( nd6_if->neighbor_cache[i].state ){
+		case FNET_ND6_NEIGHBOR_STATE_REACHABLE:
+		case FNET_ND6_NEIGHBOR_STATE_DELAY:
+			break;
+		default: continue;
+		}
+		
+		if(!(nd6_if->neighbor_cache[i].is_router)) continue;
+		
+		if(!(nd6_if->neighbor_cache[i].router_lifetime)) continue;
+		
+		nd6_if->neighbor_cache[i].confirm_time = net_timer_ms();
+		return;
+	}
+}
+
 fnet_nd6_prefix_entry_t*   netnd6_prefix_list_get(netif_t *nif, const ipv6_addr_t *prefix){
 	netnd6_if_t                 *nd6_if;
 	int                         i;
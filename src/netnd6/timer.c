@@ -0,0 +1,239 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#include <netnd6/timer.h>
+#include <netnd6/table.h>
+#include <netnd6/send.h>
+#include <netipv6/if.h>
+#include <netipv6/srcsel.h>
+#include <netstd/random.h>
+
+/*
+ * A Neighbor Solicitation, that is sent after the nd6-lock has been released.
+ */
+typedef struct {
+	ipv6_addr_t  src_ip;
+	ipv6_addr_t  targ_ip;
+	char         mode;   /* 0 = DAD, 1 = AR (multicast), 2 = NUD (unicast) */
+} netnd6_timer_ns_t;
+
+#define NETND6_TIMER_NS_MAX (FNET_ND6_NEIGHBOR_CACHE_SIZE + NETIPV6_IF_ADDR_MAX)
+
+void netnd6_reachable_time_update(netif_t *nif){
+	netnd6_if_t  *nd6_if;
+	net_time_t   base;
+	
+	nd6_if = nif->nd6;
+	
+	if (! nd6_if) return;
+	
+	base = nd6_if->base_reachable_time;
+	if(! base) base = FNET_ND6_REACHABLE_TIME;
+	
+	nd6_if->reachable_time = (
+		(base * FNET_ND6_MIN_RANDOM_FACTOR) +
+		(net_random_u32() % ((base * (FNET_ND6_MAX_RANDOM_FACTOR - FNET_ND6_MIN_RANDOM_FACTOR)) + 1))
+	) / 100;
+	nd6_if->reachable_time_stamp = net_timer_ms();
+}
+
+void netnd6_timer(netif_t *nif){
+	netnd6_if_t                 *nd6_if;
+	fnet_nd6_neighbor_entry_t   *entry;
+	netipv6_if_addr_t           *addr;
+	netpkt_t                    *drops = 0;
+	netnd6_timer_ns_t           ns[NETND6_TIMER_NS_MAX];
+	int                         i, n = 0;
+	net_time_t                  now, elapsed, retrans_timer;
+	
+	nd6_if = nif->nd6;
+	
+	if (! nd6_if) return;
+	
+	now = net_timer_ms();
+	
+	/*
+	 * RFC4861 6.3.4: A new random value should be calculated [...] at least every
+	 * few hours even if no Router Advertisements are received.
+	 */
+	if( (! nd6_if->reachable_time) ||
+		(net_timer_get_interval(nd6_if->reachable_time_stamp, now) >= FNET_ND6_REACHABLE_TIME_RENEW) )
+		netnd6_reachable_time_update(nif);
+	
+	retrans_timer = nd6_if->retrans_timer ? nd6_if->retrans_timer : FNET_ND6_RETRANS_TIMER;
+	
+	net_mutex_lock(nd6_if->nd6_lock);
+	
+	/*************************************************************
+	 * Neighbor Unreachability Detection.
+	 *************************************************************/
+	for(i = 0u; i < FNET_ND6_NEIGHBOR_CACHE_SIZE; i++)
+	{
+		entry = &(nd6_if->neighbor_cache[i]);
+		
+		/*
+		 * Apply an upper-layer reachability confirmation, that was
+		 * received since the last state event.
+		 */
+		if( (entry->state > FNET_ND6_NEIGHBOR_STATE_INCOMPLETE) &&
+			(entry->confirm_time > entry->state_time) )
+		{
+			entry->state = FNET_ND6_NEIGHBOR_STATE_REACHABLE;
+			entry->state_time = entry->confirm_time;
+			entry->solicitation_send_counter = 0u;
+		}
+		
+		elapsed = net_timer_get_interval(entry->state_time, now);
+		
+		switch(entry->state){
+		case FNET_ND6_NEIGHBOR_STATE_INCOMPLETE:
+			if(elapsed < retrans_timer) break;
+			
+			/*
+			 * RFC4861 7.2.2: While awaiting a response, the sender SHOULD retransmit
+			 * Neighbor Solicitation messages approximately every RetransTimer
+			 * milliseconds, even in the absence of additional traffic to the neighbor.
+			 */
+			if(entry->solicitation_send_counter < FNET_ND6_MAX_MULTICAST_SOLICIT)
+			{
+				entry->solicitation_send_counter++;
+				entry->state_time = now;
+				ns[n].src_ip  = entry->solicitation_src_ip_addr;
+				ns[n].targ_ip = entry->ip_addr;
+				ns[n].mode    = 1;
+				n++;
+				break;
+			}
+			
+			/*
+			 * RFC4861 7.2.2: If no Neighbor Advertisement is received after
+			 * MAX_MULTICAST_SOLICIT solicitations, address resolution has failed.
+			 *
+			 * The queued packets are locally originated, so the ICMP Address
+			 * Unreachable indication would be delivered to ourselves. We drop them.
+			 */
+			if(entry->waiting_pkts.tail){
+				nd6_if->waiting_stats.drops_failed += entry->waiting_pkts.length;
+				entry->waiting_pkts.tail->next_chain = drops;
+				drops = netpkt_queue_flush(&(entry->waiting_pkts), &(nd6_if->waiting_stats));
+			}
+			entry->state = FNET_ND6_NEIGHBOR_STATE_NOTUSED;
+			break;
+		case FNET_ND6_NEIGHBOR_STATE_REACHABLE:
+			/*
+			 * RFC4861 7.3.3: When ReachableTime milliseconds have passed since receipt of
+			 * the last reachability confirmation for a neighbor, the Neighbor Cache
+			 * entry's state changes from REACHABLE to STALE.
+			 */
+			if(elapsed < nd6_if->reachable_time) break;
+			entry->state = FNET_ND6_NEIGHBOR_STATE_STALE;
+			entry->state_time = now;
+			break;
+		case FNET_ND6_NEIGHBOR_STATE_DELAY:
+			/*
+			 * RFC4861 7.3.3: If the entry is still in the DELAY state when the timer
+			 * expires, the entry's state changes to PROBE.
+			 */
+			if(elapsed < FNET_ND6_DELAY_FIRST_PROBE_TIME) break;
+			entry->state = FNET_ND6_NEIGHBOR_STATE_PROBE;
+			entry->solicitation_send_counter = 1;
+			entry->state_time = now;
+			ns[n].src_ip  = entry->solicitation_src_ip_addr;
+			ns[n].targ_ip = entry->ip_addr;
+			ns[n].mode    = 2;
+			n++;
+			break;
+		case FNET_ND6_NEIGHBOR_STATE_PROBE:
+			if(elapsed < retrans_timer) break;
+			
+			/*
+			 * RFC4861 7.3.3: Upon entering the PROBE state, a node sends a unicast
+			 * Neighbor Solicitation message to the neighbor [...] and retransmits
+			 * them every RetransTimer milliseconds until a reachability confirmation
+			 * is received.
+			 */
+			if(entry->solicitation_send_counter < FNET_ND6_MAX_UNICAST_SOLICIT)
+			{
+				entry->solicitation_send_counter++;
+				entry->state_time = now;
+				ns[n].src_ip  = entry->solicitation_src_ip_addr;
+				ns[n].targ_ip = entry->ip_addr;
+				ns[n].mode    = 2;
+				n++;
+				break;
+			}
+			
+			/*
+			 * RFC4861 7.3.3: If no response is received after waiting RetransTimer
+			 * milliseconds after sending the MAX_UNICAST_SOLICIT solicitations,
+			 * retransmissions cease and the entry SHOULD be deleted.
+			 */
+			entry->state = FNET_ND6_NEIGHBOR_STATE_NOTUSED;
+			entry->router_lifetime = 0u;
+			break;
+		default: break;
+		}
+	}
+	
+	/*************************************************************
+	 * Duplicate Address Detection.
+	 *************************************************************/
+	if(nif->ipv6) for(i = 0u; i < NETIPV6_IF_ADDR_MAX; i++)
+	{
+		addr = &(nif->ipv6->addrs[i]);
+		if(! addr->used ) continue;
+		if(addr->state != FNET_NETIF_IP6_ADDR_STATE_TENTATIVE) continue;
+		if(net_timer_get_interval(addr->state_time, now) < retrans_timer) continue;
+		
+		addr->state_time = now;
+		
+		/*
+		 * RFC4862 5.4.2: Sends DupAddrDetectTransmits Neighbor Solicitations,
+		 * each separated by RetransTimer milliseconds.
+		 */
+		if(addr->dad_transmit_counter < FNET_ND6_DUP_ADDR_DETECT_TRANSMITS)
+		{
+			addr->dad_transmit_counter++;
+			ns[n].targ_ip = addr->address;
+			ns[n].mode    = 0;
+			n++;
+			continue;
+		}
+		
+		/*
+		 * RFC4862 5.4.3: If no duplicate has been detected, after RetransTimer
+		 * milliseconds of the last transmission, the address is unique and is
+		 * assigned to the interface.
+		 */
+		addr->state = FNET_NETIF_IP6_ADDR_STATE_PREFERRED;
+		netipv6_srcsel_invalidate(nif);
+	}
+	
+	net_mutex_unlock(nd6_if->nd6_lock);
+	
+	if(drops)
+		netpkt_free_all(drops);
+	
+	for(i = 0; i < n; i++){
+		switch(ns[i].mode){
+		case 0: netnd6_neighbor_solicitation_send(nif, 0 /* NULL for DAD */, 0, &(ns[i].targ_ip)); break;
+		case 1: netnd6_neighbor_solicitation_send(nif, &(ns[i].src_ip), 0 /* NULL for AR */, &(ns[i].targ_ip)); break;
+		default: netnd6_neighbor_solicitation_send(nif, &(ns[i].src_ip), &(ns[i].targ_ip), &(ns[i].targ_ip)); break;
+		}
+	}
+}
+
@@ -203,6 +203,39 @@ void *netpkt_data(netpkt_t *pkt){
 	return (void*)0;
 }
 
+/*
+ * Copies 'len' bytes, starting 'off' bytes after the current offset, into 'dst'.
+ *
+ * On success it returns 0, non-0 otherwise.
+ */
+int netpkt_copyout(netpkt_t *pkt,uint32_t off,void *dst,uint32_t len){
+	netpkt_seg_t *seg;
+	uint32_t      offset,P;
+	
+	offset = NETPKT_OFFSET(pkt) + off;
+	
+	if( ( offset + len ) > pkt->offset_length ) return -1;
+	
+	seg = pkt->segs;
+	
+	while( seg && len ){
+		P = NETPKT_SEG_LENGTH(seg);
+		
+		if( P > offset ){
+			P -= offset;
+			if( P > len ) P = len;
+			memcpy(dst,seg->data_ptr+offset,P);
+			dst += P;
+			len -= P;
+			offset = 0;
+		}else
+			offset -= P;
+		seg = seg->next;
+	}
+	
+	return len ? -1 : 0;
+}
+
 /*
  * Pull in packet head. Decrease packet data length by removing data from the
  * head of the packet.
@@ -0,0 +1,78 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#include <netpkt/queue.h>
+
+static inline void netpkt_queue_drop_head(netpkt_queue_t *q, netpkt_queue_stats_t *stats, netpkt_t **drops){
+	netpkt_t *old;
+	
+	old = q->head;
+	q->head = old->next_chain;
+	if(! q->head) q->tail = 0;
+	q->length--;
+	stats->queued--;
+	
+	old->next_chain = *drops;
+	*drops = old;
+}
+
+void netpkt_queue_enqueue(netpkt_queue_t *q, netpkt_queue_stats_t *stats, netpkt_t *pkt, uint32_t entry_max, uint32_t table_max, netpkt_t **drops){
+	pkt->next_chain = 0;
+	
+	/*
+	 * The table is full and we have no older packet of our own to replace.
+	 */
+	if( (stats->queued >= table_max) && !(q->length) ){
+		pkt->next_chain = *drops;
+		*drops = pkt;
+		stats->drops_table++;
+		return;
+	}
+	
+	if(q->tail)
+		q->tail->next_chain = pkt;
+	else
+		q->head = pkt;
+	q->tail = pkt;
+	q->length++;
+	stats->queued++;
+	
+	/*
+	 * RFC 4861 7.2.2: When a queue overflows, the new arrival SHOULD replace the oldest entry.
+	 */
+	if(q->length > entry_max){
+		netpkt_queue_drop_head(q,stats,drops);
+		stats->drops_entry++;
+	}else if(stats->queued > table_max){
+		netpkt_queue_drop_head(q,stats,drops);
+		stats->drops_table++;
+	}
+}
+
+netpkt_t* netpkt_queue_flush(netpkt_queue_t *q, netpkt_queue_stats_t *stats){
+	netpkt_t *chain;
+	
+	chain = q->head;
+	stats->queued -= q->length;
+	
+	q->head = 0;
+	q->tail = 0;
+	q->length = 0;
+	
+	return chain;
+}
+
@@ -68,34 +68,50 @@ static uint32_t fnet_checksum_low(uint32_t sum, size_t length, const uint16_t *d
     return sum;
 }
 
+/*
+ * Sums up 'length' bytes, starting at the current offset of the packet.
+ */
 static uint32_t fnet_checksum_pkt(netpkt_t *pkt, size_t length){
 	netpkt_seg_t *seg;
-	size_t       sublen;
+	const uint8_t *ptr;
+	size_t       sublen,offset;
 	uint32_t     sum;
 	uint16_t     oddbuf;
 	uint8_t      oddptr;
 	
 	sum = 0;
+	oddbuf = 0;
+	oddptr = 0;
 	
+	offset = NETPKT_OFFSET(pkt);
 	seg = pkt->segs;
 	
+	/* Skip the segments before the current offset. */
+	while( seg && (NETPKT_SEG_LENGTH(seg) <= offset) ){
+		offset -= NETPKT_SEG_LENGTH(seg);
+		seg = seg->next;
+	}
+	
 	while( seg && length ){
-		sublen = NETPKT_SEG_LENGTH(seg);
+		ptr    = ((const uint8_t*)seg->data_ptr) + offset;
+		sublen = NETPKT_SEG_LENGTH(seg) - offset;
+		offset = 0;
+		seg    = seg->next;
+		if(! sublen ) continue;
 		if( sublen > length ) sublen = length;
 		if(oddptr){
-			oddbuf |= ((const uint8_t*)seg->data_ptr)[0];
+			oddbuf |= ptr[0];
 			sum += (uint32_t)hton16(oddbuf);
-			sum = fnet_checksum_low(sum, (sublen-1)&~1 ,seg->data_ptr+1);
+			sum = fnet_checksum_low(sum, (sublen-1)&~1 ,(const uint16_t*)(ptr+1));
 			oddptr = !(sublen & 1);
 		}else{
-			sum = fnet_checksum_low(sum, sublen&~1 ,seg->data_ptr);
+			sum = fnet_checksum_low(sum, sublen&~1 ,(const uint16_t*)ptr);
 			oddptr = sublen & 1;
 		}
-		oddbuf = ((const uint8_t*)(seg->data_end-1))[0] << 8;
+		oddbuf = ptr[sublen-1] << 8;
 		length -= sublen;
 		/* Add in one accumulated carry (prevent integer overflow) */
 		sum = (sum & 0xffffu) + (sum >> 16);
-		seg = seg->next;
 	}
 	if(oddptr) sum += (uint32_t)hton16(oddbuf&0xff00u);
 		
@@ -136,15 +152,18 @@ uint16_t netprot_checksum(netpkt_t *pkt, size_t len)
     return (uint16_t)(0xffffu & ~sum);
 }
 
-uint16_t netprot_checksum_pseudo_start( netpkt_t *pkt, uint8_t protocol, uint16_t protocol_len ){
-	netpkt_seg_t *seg;
-	const uint16_t *begin,*end;
+uint16_t netprot_checksum_pseudo_start( netpkt_t *pkt, uint8_t protocol, uint32_t protocol_len ){
+	return netprot_checksum_pseudo_start_cov( pkt, protocol, protocol_len, protocol_len );
+}
+
+uint16_t netprot_checksum_pseudo_start_cov( netpkt_t *pkt, uint8_t protocol, uint32_t protocol_len, uint32_t coverage ){
 	uint32_t sum;
 	
 	
-	sum = fnet_checksum_pkt(pkt, (size_t)protocol_len);
+	sum = fnet_checksum_pkt(pkt, (size_t)coverage);
 	sum += (uint32_t)hton16((uint16_t)protocol);
-	sum += (uint32_t)hton16(protocol_len);
+	sum += (uint32_t)hton16((uint16_t)(protocol_len>>16));
+	sum += (uint32_t)hton16((uint16_t)protocol_len);
 	
 	 sum += 0xffffu; /*  + 0xffff acording to RFC1624*/
 
@@ -173,5 +192,18 @@ uint16_t netprot_checksum_pseudo_end( uint16_t sum_s, const uint8_t *ip_src, uin
     return (uint16_t)(0xffffu & ~sum);
 }
 
-
+/*
+ * RFC 1624 3: HC' = ~(~HC + ~m + m'). Unlike RFC 1141, this never yields
+ * 0x0000 for a valid checksum.
+ */
+uint16_t netprot_checksum_update16( uint16_t checksum, uint16_t oldval, uint16_t newval ){
+	uint32_t sum;
+	
+	sum  = (uint16_t)~checksum;
+	sum += (uint16_t)~oldval;
+	sum += newval;
+	sum  = (sum & 0xffffu) + (sum >> 16);
+	sum  = (sum & 0xffffu) + (sum >> 16);
+	return (uint16_t)~sum;
+}
 
@@ -49,6 +49,7 @@ void netprot_input(netif_t *nif, netpkt_t *pkt, uint8_t protocol, net_sockaddr_t
 	/* Extract port numbers from UDP and TCP headers. */
 	switch(protocol){
 	case IP_PROTOCOL_UDP:
+	case IP_PROTOCOL_UDPLITE:
 	case IP_PROTOCOL_TCP:
 		if( netpkt_pullup( pkt, sizeof(gen_tcp_udp_header_t) ) ) goto DROP;
 		porthdr = netpkt_data(pkt);
@@ -72,19 +73,31 @@ void netprot_input(netif_t *nif, netpkt_t *pkt, uint8_t protocol, net_sockaddr_t
 	case IP_PROTOCOL_UDP:
 		if(! nif->sockets ) goto NO_PROTO;
 		flow = netsock_lookup_flow(nif->sockets, protocol, src_addr, dst_addr);
-		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, dst_addr);
+		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, src_addr, dst_addr);
 		
 		if(! flow ) goto NO_PROTO; /* No socket has been found. */
 		
 		netudp_input(nif, pkt, flow, src_addr, dst_addr);
 		return;
+	case IP_PROTOCOL_UDPLITE:
+		/*
+		 * UDP-Lite shares the socket hashtable and the sockets with UDP.
+		 */
+		if(! nif->sockets ) goto NO_PROTO;
+		flow = netsock_lookup_flow(nif->sockets, protocol, src_addr, dst_addr);
+		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, src_addr, dst_addr);
+		
+		if(! flow ) goto NO_PROTO; /* No socket has been found. */
+		
+		netudplite_input(nif, pkt, flow, src_addr, dst_addr);
+		return;
 	case IP_PROTOCOL_TCP:
 		/*
 		 * When no socket hashtable is present, we treat TCP as an unreachable protocol.
 		 */
 		if(! nif->sockets ) goto NO_PROTO;
 		flow = netsock_lookup_flow(nif->sockets, protocol, src_addr, dst_addr);
-		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, dst_addr);
+		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, src_addr, dst_addr);
 		
 		/*
 		 * When eighter a listening socket or a connected socket has
@@ -103,7 +116,7 @@ void netprot_input(netif_t *nif, netpkt_t *pkt, uint8_t protocol, net_sockaddr_t
 		if(! nif->sockets ) goto NO_PROTO;
 		
 		flow = netsock_lookup_flow(nif->sockets, protocol, src_addr, dst_addr);
-		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, dst_addr);
+		if(! flow ) flow = netsock_lookup_flow_port(nif->sockets, protocol, src_addr, dst_addr);
 		if(! flow ) goto NO_PROTO;
 		
 		netgre_input(nif, pkt, flow, src_addr, dst_addr);
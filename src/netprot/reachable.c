@@ -0,0 +1,59 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+
+#include <netprot/reachable.h>
+#include <netnd6/table.h>
+#include <netarp/table.h>
+#include <netipv4/fib.h>
+#include <netipv6/fib.h>
+
+void netprot_confirm_reachable(netif_t *nif, const netsock_flow_t *flow){
+	netif_t       *rnif;
+	ipv4_addr_t   next_hop;
+	ipv6_addr_t   next_hop6;
+	
+	/*
+	 * The next hop is resolved the same way, as the output path does, so that
+	 * the entry, that is actually used, is confirmed.
+	 */
+	rnif = nif;
+	switch(flow->remote_a.type){
+	case NET_SKA_IN:
+		if(! nif->arp ) return;
+		if( netipv4_route(&rnif,flow->remote_a.ip.v4,&next_hop,0) ) return;
+		netarp_confirm_reachable(nif,next_hop);
+		break;
+	case NET_SKA_IN6:
+		if(! nif->nd6 ) return;
+		switch( netipv6_route(&rnif,&(flow->remote_a.ip.v6),&next_hop6) ){
+		case 1:
+			/* The next hop from the FIB. */
+			netnd6_confirm_reachable(nif,&next_hop6);
+			break;
+		case 0:
+			/*
+			 * A destination, that is not in the Neighbor Cache, is off-link, and is
+			 * sent to the default router.
+			 */
+			if(! netnd6_confirm_reachable(nif,&next_hop6) )
+				netnd6_confirm_router(nif);
+			break;
+		}
+		break;
+	}
+}
+
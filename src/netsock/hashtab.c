@@ -14,56 +14,30 @@
  *   limitations under the License.
  */
 #include <netsock/hashtab.h>
-
-typedef const uint8_t* byteptr;
-
-/*
- * FNV1a Hash function 32 bit - Constants
- */
-
-static const uint32_t FNV_prime = 16777619U;
-static const uint32_t FNV_basis = 2166136261U;
-
-/*
- * FNV1a Hash function 32 bit - code
- */
-static inline uint32_t fnv1a(uint32_t hash,const uint8_t* data,unsigned len){
-	for(;len;len--,data++){
-		hash ^= *data;
-		hash *= FNV_prime;
-	}
-	return hash;
-}
-static inline uint32_t fnv1a_short(uint32_t hash,uint16_t data){
-	hash ^= (data&0xff);
-	hash *= FNV_prime;
-	hash ^= (data >> 8);
-	hash *= FNV_prime;
-	return hash;
-}
+#include <netstd/hash.h>
 
 /*
  * Perform a hash on an address tuple.
  */
 static uint32_t netsock_hash_tuple(uint8_t protocol, const net_sockaddr_t *remote_a, const net_sockaddr_t *local_a){
-	uint32_t hash = FNV_basis;
+	uint32_t hash = NET_FNV_BASIS;
 	
 	/* Hash the protocol byte. */
 	hash ^= protocol;
-	hash *= FNV_prime;
+	hash *= NET_FNV_PRIME;
 	
 	switch(remote_a->type){
 	case NET_SKA_IN:
-		hash = fnv1a(hash,(byteptr)&(remote_a->ip.v4),sizeof(ipv4_addr_t));
-		hash = fnv1a(hash,(byteptr)&(local_a->ip.v4),sizeof(ipv4_addr_t));
+		hash = net_fnv1a(hash,&(remote_a->ip.v4),sizeof(ipv4_addr_t));
+		hash = net_fnv1a(hash,&(local_a->ip.v4),sizeof(ipv4_addr_t));
 		break;
 	case NET_SKA_IN6:
-		hash = fnv1a(hash,(byteptr)&(remote_a->ip.v6),sizeof(ipv6_addr_t));
-		hash = fnv1a(hash,(byteptr)&(local_a->ip.v6),sizeof(ipv6_addr_t));
+		hash = net_fnv1a(hash,&(remote_a->ip.v6),sizeof(ipv6_addr_t));
+		hash = net_fnv1a(hash,&(local_a->ip.v6),sizeof(ipv6_addr_t));
 		break;
 	}
-	hash = fnv1a_short(hash,remote_a->port);
-	hash = fnv1a_short(hash,local_a->port);
+	hash = net_fnv1a_u16(hash,remote_a->port);
+	hash = net_fnv1a_u16(hash,local_a->port);
 	return hash;
 }
 
@@ -140,8 +114,20 @@ netsock_flow_t* netsock_lookup_flow(netsock_ht_t* table, uint8_t protocol, const
 	net_mutex_unlock(table->bucket_locks[hash%NETSOCK_HT_PORTS]);
 	return 0;
 }
-netsock_flow_t* netsock_lookup_flow_port(netsock_ht_t* table, uint8_t protocol, const net_sockaddr_t *local_a){
+/*
+ * Tests, whether 'other' is in the same listener group as 'flow'.
+ */
+static int netsock_same_group(const netsock_flow_t* flow, const netsock_flow_t* other){
+	if(other->hash_a != flow->hash_a) return 0;
+	if(other->protocol != flow->protocol) return 0;
+	if(!(other->flags & NETSOCK_FLOW_REUSEPORT)) return 0;
+	return netsock_eq(&(other->local_a),&(flow->local_a));
+}
+
+netsock_flow_t* netsock_lookup_flow_port(netsock_ht_t* table, uint8_t protocol, const net_sockaddr_t *remote_a, const net_sockaddr_t *local_a){
 	const uint16_t idx = local_a->port;
+	netsock_flow_t* first;
+	uint32_t n,i;
 	
 	net_mutex_lock(table->bucket_locks[idx]);
 	netsock_flow_t* cur = table->ht_ports[idx];
@@ -149,6 +135,19 @@ netsock_flow_t* netsock_lookup_flow_port(netsock_ht_t* table, uint8_t protocol,
 		if(cur->hash_a != idx) continue;
 		if(cur->protocol != protocol) continue;
 		if(cur->local_a.type && !netsock_eq(&(cur->local_a),local_a)) continue;
+		
+		/*
+		 * A listener group: Count the members, and select one by the
+		 * hash of the address tuple.
+		 */
+		if(cur->flags & NETSOCK_FLOW_REUSEPORT){
+			first = cur;
+			for(n = 0;cur;cur = cur->tail)
+				if(netsock_same_group(first,cur)) n++;
+			i = netsock_hash_tuple(protocol,remote_a,local_a) % n;
+			for(cur = first;;cur = cur->tail)
+				if(netsock_same_group(first,cur) && !(i--)) break;
+		}
 		cur->refc++;
 		
 		net_mutex_unlock(table->bucket_locks[idx]);
@@ -185,6 +184,15 @@ void netsock_remove_flow(netsock_ht_t* table, netsock_flow_t* flow){
 	if(flow->refc==0) flow->freeflow(flow);
 }
 
+/*
+ * Increments the reference count of a Flow, that is already referenced.
+ */
+void netsock_incr_flow(netsock_ht_t* table, netsock_flow_t* flow){
+	net_mutex_lock(table->bucket_locks[flow->hash_a%NETSOCK_HT_PORTS]);
+	flow->refc++;
+	net_mutex_unlock(table->bucket_locks[flow->hash_a%NETSOCK_HT_PORTS]);
+}
+
 /*
  * Decrements the reference count of a Flow.
  */
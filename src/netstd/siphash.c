@@ -0,0 +1,72 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <netstd/siphash.h>
+
+#define ROTL64(x,b) (uint64_t)( ((x) << (b)) | ((x) >> (64 - (b))) )
+
+#define SIPROUND do{                                                        \
+	v0 += v1; v1 = ROTL64(v1,13); v1 ^= v0; v0 = ROTL64(v0,32);         \
+	v2 += v3; v3 = ROTL64(v3,16); v3 ^= v2;                             \
+	v0 += v3; v3 = ROTL64(v3,21); v3 ^= v0;                             \
+	v2 += v1; v1 = ROTL64(v1,17); v1 ^= v2; v2 = ROTL64(v2,32);         \
+}while(0)
+
+/* Reads 'len' (up to 8) bytes as a little-endian word. */
+static inline uint64_t siphash_le64(const uint8_t *p, size_t len){
+	uint64_t w = 0;
+	while(len--) w = (w << 8) | p[len];
+	return w;
+}
+
+uint64_t net_siphash(const uint32_t key[4], const void *data, size_t len){
+	const uint8_t *p = data;
+	uint64_t k0, k1, m;
+	uint64_t v0, v1, v2, v3;
+	size_t   left;
+	
+	k0 = ((uint64_t)key[1] << 32) | key[0];
+	k1 = ((uint64_t)key[3] << 32) | key[2];
+	
+	v0 = k0 ^ 0x736f6d6570736575ull;
+	v1 = k1 ^ 0x646f72616e646f6dull;
+	v2 = k0 ^ 0x6c7967656e657261ull;
+	v3 = k1 ^ 0x7465646279746573ull;
+	
+	/* Compression: 2 rounds per 8-byte word. */
+	for(left = len ; left >= 8 ; left -= 8, p += 8){
+		m = siphash_le64(p,8);
+		v3 ^= m;
+		SIPROUND;
+		SIPROUND;
+		v0 ^= m;
+	}
+	
+	/* The last word holds the remaining bytes and the length (mod 256). */
+	m = siphash_le64(p,left) | ((uint64_t)len << 56);
+	v3 ^= m;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= m;
+	
+	/* Finalization: 4 rounds. */
+	v2 ^= 0xff;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+	
+	return v0 ^ v1 ^ v2 ^ v3;
+}
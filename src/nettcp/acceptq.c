@@ -0,0 +1,96 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/acceptq.h>
+#include <netstd/atomic.h>
+
+#define RING_MASK (NETTCP_ACCEPTQ_SIZE-1)
+
+void nettcp_acceptq_init(nettcp_acceptq_t *q){
+	uint32_t i;
+	
+	q->head = 0;
+	q->tail = 0;
+	for(i = 0 ; i < NETTCP_ACCEPTQ_SIZE ; ++i){
+		q->slots[i].seq = i;
+		q->slots[i].tcb = 0;
+	}
+}
+
+int nettcp_acceptq_enqueue(nettcp_acceptq_t *q, struct nettcp_tcb *tcb){
+	nettcp_acceptq_slot_t *slot;
+	uint32_t pos,seq;
+	int32_t dif;
+	
+	pos = q->head;
+	for(;;){
+		slot = &q->slots[pos & RING_MASK];
+		seq = slot->seq;
+		net_memory_barrier();
+		dif = (int32_t)(seq - pos);
+		
+		/* The slot is free; try to claim it. */
+		if( dif == 0 ){
+			if( net_atomic_cas(&q->head,pos,pos+1) ) break;
+		}
+		
+		/* The slot still holds the connection from the previous round: full. */
+		else if( dif < 0 ) return -1;
+		
+		pos = q->head;
+	}
+	
+	slot->tcb = tcb;
+	
+	/* Publish the slot to the consumers. */
+	net_memory_barrier();
+	slot->seq = pos+1;
+	return 0;
+}
+
+struct nettcp_tcb* nettcp_acceptq_dequeue(nettcp_acceptq_t *q){
+	nettcp_acceptq_slot_t *slot;
+	struct nettcp_tcb *tcb;
+	uint32_t pos,seq;
+	int32_t dif;
+	
+	pos = q->tail;
+	for(;;){
+		slot = &q->slots[pos & RING_MASK];
+		seq = slot->seq;
+		net_memory_barrier();
+		dif = (int32_t)(seq - (pos+1));
+		
+		/* The slot has been published; try to claim it. */
+		if( dif == 0 ){
+			if( net_atomic_cas(&q->tail,pos,pos+1) ) break;
+		}
+		
+		/* Not yet published: empty. */
+		else if( dif < 0 ) return 0;
+		
+		pos = q->tail;
+	}
+	
+	tcb = slot->tcb;
+	slot->tcb = 0;
+	
+	/* Hand the slot back to the producers, for the next round. */
+	net_memory_barrier();
+	slot->seq = pos+NETTCP_ACCEPTQ_SIZE;
+	return tcb;
+}
+
@@ -0,0 +1,44 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/cc.h>
+#include <nettcp/tcb.h>
+#include <netstd/mem.h>
+
+static const nettcp_cc_ops_t* const nettcp_cc_modules[] = {
+	&nettcp_cc_newreno,
+	&nettcp_cc_cubic,
+	&nettcp_cc_bbr,
+};
+
+const nettcp_cc_ops_t* nettcp_cc_find(const char *name){
+	unsigned i;
+	
+	for( i = 0 ; i < (sizeof(nettcp_cc_modules)/sizeof(nettcp_cc_modules[0])) ; ++i )
+		if(! strcmp(nettcp_cc_modules[i]->name,name) ) return nettcp_cc_modules[i];
+	return 0;
+}
+
+void nettcp_set_cc(nettcp_tcb_t *tcb, const nettcp_cc_ops_t *cc){
+	net_mutex_lock(tcb->lock);
+	tcb->cc = cc;
+	net_bzero(tcb->cc_priv,sizeof(tcb->cc_priv));
+	
+	/* Otherwise, init() is called, when the connection is synchronized. */
+	if( NETTCP_HAVE_RCVD_SYN(tcb->state) && cc->init ) cc->init(tcb);
+	net_mutex_unlock(tcb->lock);
+}
+
@@ -0,0 +1,247 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/cc.h>
+#include <nettcp/tcb.h>
+#include <netstd/time.h>
+
+/*
+ * BBR (Cardwell et al., "BBR: Congestion-Based Congestion Control", 2016):
+ * Models the path by its bottleneck bandwidth (a windowed maximum of the
+ * delivery rate) and its round-trip propagation time (a windowed minimum of
+ * the RTT), and paces at the bandwidth, with a window of twice the
+ * bandwidth-delay product. Losses do not reduce the model, so it keeps the
+ * throughput on lossy long-fat paths.
+ *
+ * Without per-segment delivery tracking, the delivery rate is sampled once per
+ * round trip: the bytes acknowledged in the round, divided by its duration.
+ */
+
+#define BBR_STARTUP    0
+#define BBR_DRAIN      1
+#define BBR_PROBE_BW   2
+#define BBR_PROBE_RTT  3
+
+#define BBR_UNIT             256u     /* Gains are scaled by 256. */
+#define BBR_HIGH_GAIN        739u     /* 2/ln(2) */
+#define BBR_DRAIN_GAIN       88u      /* 1/BBR_HIGH_GAIN */
+#define BBR_CWND_GAIN        512u
+#define BBR_BW_ROUNDS        10       /* Length of the bandwidth filter, in rounds. */
+#define BBR_MIN_RTT_WIN_MS   10000u   /* Length of the min-RTT filter. */
+#define BBR_PROBE_RTT_MS     200u
+#define BBR_FULL_BW_ROUNDS   3        /* Rounds without 25% growth, until the pipe is full. */
+
+static const uint16_t bbr_cycle_gain[8] = { 320, 192, 256, 256, 256, 256, 256, 256 };
+
+typedef struct bbr{
+	uint32_t    bw[BBR_BW_ROUNDS];  /* Delivery rate of the last rounds, in bytes per second. */
+	uint32_t    round_count;
+	uint32_t    round_end;          /* The round ends, when this sequence number is acknowledged. */
+	uint32_t    round_delivered;
+	uint32_t    min_rtt;            /* 0 = no sample yet. */
+	uint32_t    full_bw;
+	uint32_t    prior_cwnd;
+	net_time_t  round_start;
+	net_time_t  min_rtt_stamp;
+	net_time_t  probe_rtt_done;
+	uint8_t     mode;
+	uint8_t     cycle_idx;
+	uint8_t     full_bw_cnt;
+	uint8_t     filled_pipe;
+} bbr_t;
+
+typedef char bbr_size_check[(sizeof(bbr_t) <= (NETTCP_CC_PRIV_WORDS*8)) ? 1 : -1];
+
+#define BBR(tcb) ((bbr_t*)((tcb)->cc_priv))
+
+static uint32_t bbr_max_bw(bbr_t *b){
+	uint32_t bw = 0;
+	int i;
+	
+	for( i = 0 ; i < BBR_BW_ROUNDS ; ++i )
+		if( b->bw[i] > bw ) bw = b->bw[i];
+	return bw;
+}
+
+/*
+ * The bandwidth-delay product, multiplied by 'gain'; 0, if the model has no
+ * samples yet.
+ */
+static uint32_t bbr_bdp(bbr_t *b, uint32_t gain){
+	uint64_t bdp;
+	
+	bdp = ((uint64_t)bbr_max_bw(b) * b->min_rtt) / 1000u;
+	bdp = (bdp * gain) / BBR_UNIT;
+	return bdp > 0xffffffffu ? 0xffffffffu : (uint32_t)bdp;
+}
+
+static void bbr_init(nettcp_tcb_t *tcb){
+	bbr_t *b = BBR(tcb);
+	net_time_t now = net_timer_ms();
+	
+	b->mode          = BBR_STARTUP;
+	b->round_end     = tcb->snd_max;
+	b->round_start   = now;
+	b->min_rtt       = tcb->srtt >> 3;
+	b->min_rtt_stamp = now;
+	tcb->ssthresh    = 0xffffffffu;
+}
+
+/*
+ * A round trip has completed: Takes a bandwidth sample, and advances the
+ * state machine.
+ */
+static void bbr_round(nettcp_tcb_t *tcb, bbr_t *b, net_time_t now){
+	uint32_t bw;
+	
+	if( now > b->round_start ){
+		b->bw[b->round_count % BBR_BW_ROUNDS] = (uint32_t)(((uint64_t)b->round_delivered * 1000u) / (now - b->round_start));
+		b->round_count++;
+	}
+	b->round_end       = tcb->snd_max;
+	b->round_start     = now;
+	b->round_delivered = 0;
+	
+	bw = bbr_max_bw(b);
+	switch(b->mode){
+	case BBR_STARTUP:
+		/* The pipe is full, when the bandwidth stops growing by 25%. */
+		if( (uint64_t)bw >= ((uint64_t)b->full_bw * 5) / 4 ){
+			b->full_bw     = bw;
+			b->full_bw_cnt = 0;
+		}else if( ++(b->full_bw_cnt) >= BBR_FULL_BW_ROUNDS ){
+			b->filled_pipe = 1;
+			b->mode        = BBR_DRAIN;
+		}
+		break;
+	case BBR_PROBE_BW:
+		b->cycle_idx = (b->cycle_idx + 1) & 7;
+		break;
+	case BBR_PROBE_RTT:
+		if( now >= b->probe_rtt_done ){
+			b->min_rtt_stamp = now;
+			b->mode = b->filled_pipe ? BBR_PROBE_BW : BBR_STARTUP;
+			if( tcb->cwnd < b->prior_cwnd ) tcb->cwnd = b->prior_cwnd;
+		}
+		break;
+	}
+}
+
+/*
+ * Updates the min-RTT filter with a sample (if 'sample' is non-0), and checks
+ * its expiry. An expired filter takes any sample. If the minimum RTT has not
+ * been seen for a while, the pipe is drained, to measure it (PROBE_RTT).
+ */
+static void bbr_update_min_rtt(nettcp_tcb_t *tcb, bbr_t *b, int sample, uint32_t rtt, net_time_t now){
+	int expired;
+	
+	expired = b->min_rtt && ((now - b->min_rtt_stamp) > BBR_MIN_RTT_WIN_MS);
+	
+	if( sample && ((! b->min_rtt) || (rtt < b->min_rtt) || expired) ){
+		b->min_rtt       = rtt ? rtt : 1;
+		b->min_rtt_stamp = now;
+	}
+	
+	if( expired && (b->mode != BBR_PROBE_RTT) ){
+		b->prior_cwnd     = tcb->cwnd;
+		b->mode           = BBR_PROBE_RTT;
+		b->probe_rtt_done = now + BBR_PROBE_RTT_MS;
+	}
+}
+
+static void bbr_ack(nettcp_tcb_t *tcb, uint32_t acked){
+	bbr_t *b = BBR(tcb);
+	net_time_t now = net_timer_ms();
+	uint32_t target, mss = tcb->snd_mss;
+	
+	b->round_delivered += acked;
+	if( NETTCP_SEQ_GEQ(tcb->snd_una,b->round_end) ) bbr_round(tcb,b,now);
+	
+	/* Drain the queue, that the startup has built. */
+	if( (b->mode == BBR_DRAIN) && ((tcb->snd_max - tcb->snd_una) <= bbr_bdp(b,BBR_UNIT)) ){
+		b->mode      = BBR_PROBE_BW;
+		b->cycle_idx = (uint8_t)(b->round_count % 8);
+		if( b->cycle_idx == 1 ) b->cycle_idx = 2;
+	}
+	
+	/* The filter may expire without new samples. */
+	bbr_update_min_rtt(tcb,b,0,0,now);
+	
+	if( b->mode == BBR_PROBE_RTT ){
+		tcb->cwnd = 4u*mss;
+		return;
+	}
+	
+	/* cwnd = cwnd_gain * BDP, plus some segments for delayed and stretched ACKs. */
+	target = bbr_bdp(b,b->mode == BBR_STARTUP ? BBR_HIGH_GAIN : BBR_CWND_GAIN);
+	if( target ) target += 3u*mss;
+	
+	if( b->filled_pipe && target ){
+		tcb->cwnd = (tcb->cwnd + acked) < target ? (tcb->cwnd + acked) : target;
+	}else if( (! target) || (tcb->cwnd < target) ){
+		tcb->cwnd += acked;
+	}
+	if( tcb->cwnd < 4u*mss ) tcb->cwnd = 4u*mss;
+}
+
+static void bbr_loss(nettcp_tcb_t *tcb, int event){
+	bbr_t *b = BBR(tcb);
+	uint32_t flight = tcb->snd_max - tcb->snd_una;
+	
+	/*
+	 * The model is kept. The window is restored after the recovery (the
+	 * stack deflates it to 'ssthresh'); meanwhile, packet conservation.
+	 * In PROBE_RTT, the window is the reduced one: Keep the saved window.
+	 */
+	if( b->mode != BBR_PROBE_RTT )
+		b->prior_cwnd = tcb->cwnd;
+	else if( tcb->cwnd > b->prior_cwnd )
+		b->prior_cwnd = tcb->cwnd;
+	tcb->ssthresh = tcb->cwnd;
+	if( event == NETTCP_CC_LOSS_FAST )
+		tcb->cwnd = flight + tcb->snd_mss;
+	else
+		tcb->cwnd = tcb->snd_mss;
+}
+
+static void bbr_rtt_sample(nettcp_tcb_t *tcb, uint32_t rtt){
+	bbr_t *b = BBR(tcb);
+	
+	bbr_update_min_rtt(tcb,b,1,rtt,net_timer_ms());
+}
+
+static uint32_t bbr_pacing_rate(nettcp_tcb_t *tcb){
+	bbr_t *b = BBR(tcb);
+	uint32_t gain;
+	
+	switch(b->mode){
+	case BBR_STARTUP:  gain = BBR_HIGH_GAIN; break;
+	case BBR_DRAIN:    gain = BBR_DRAIN_GAIN; break;
+	case BBR_PROBE_BW: gain = bbr_cycle_gain[b->cycle_idx]; break;
+	default:           gain = BBR_UNIT;
+	}
+	return (uint32_t)(((uint64_t)bbr_max_bw(b) * gain) / BBR_UNIT);
+}
+
+const nettcp_cc_ops_t nettcp_cc_bbr = {
+	.name        = "bbr",
+	.init        = bbr_init,
+	.ack         = bbr_ack,
+	.loss        = bbr_loss,
+	.rtt_sample  = bbr_rtt_sample,
+	.pacing_rate = bbr_pacing_rate,
+};
+
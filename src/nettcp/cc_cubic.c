@@ -0,0 +1,160 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/cc.h>
+#include <nettcp/tcb.h>
+#include <netstd/time.h>
+
+/*
+ * CUBIC (RFC 8312): After a loss, the window grows along a cubic function of
+ * the time since the loss, with its plateau at the window before the loss
+ * (W_max). It is independent of the RTT, which suits long-fat paths.
+ *
+ * The constants are C = 0.4 and beta = 0.7; all arithmetic is integer, the
+ * windows are in bytes and the times in milliseconds.
+ */
+
+typedef struct cubic{
+	uint32_t    w_max;       /* Window before the last reduction. */
+	uint32_t    w_last_max;  /* W_max before that (fast convergence). */
+	uint32_t    k;           /* Time to reach W_max, from the epoch. */
+	uint32_t    origin;      /* Plateau of the cubic function. */
+	uint32_t    w_est;       /* Window of the TCP-friendly region (RFC 8312 4.2). */
+	uint32_t    min_rtt;
+	net_time_t  epoch;       /* Start of the current congestion avoidance period. */
+	uint8_t     epoch_valid;
+} cubic_t;
+
+typedef char cubic_size_check[(sizeof(cubic_t) <= (NETTCP_CC_PRIV_WORDS*8)) ? 1 : -1];
+
+#define CUBIC(tcb) ((cubic_t*)((tcb)->cc_priv))
+
+/* Limit for |t-K|, to keep (t-K)^3 * MSS in 64 bits. */
+#define CUBIC_DT_MAX 100000
+
+static uint32_t cubic_cbrt(uint64_t a){
+	uint64_t x = 0, b;
+	int s;
+	
+	/* Bitwise integer cube root. */
+	for( s = 63 ; s >= 0 ; s -= 3 ){
+		x <<= 1;
+		b = 3*x*(x+1) + 1;
+		if( (a >> s) >= b ){
+			a -= b << s;
+			x++;
+		}
+	}
+	return (uint32_t)x;
+}
+
+static void cubic_init(nettcp_tcb_t *tcb){
+	cubic_t *c = CUBIC(tcb);
+	
+	c->epoch_valid = 0;
+	c->w_max       = 0;
+	c->w_last_max  = 0;
+	c->min_rtt     = 0;
+}
+
+static void cubic_ack(nettcp_tcb_t *tcb, uint32_t acked){
+	cubic_t  *c = CUBIC(tcb);
+	net_time_t now;
+	int64_t  dt, delta;
+	uint64_t target, incr;
+	uint32_t mss = tcb->snd_mss;
+	
+	/* Slow start, as in RFC 5681. */
+	if( tcb->cwnd < tcb->ssthresh ){
+		tcb->cwnd += acked < mss ? acked : mss;
+		return;
+	}
+	
+	now = net_timer_ms();
+	if(! c->epoch_valid ){
+		c->epoch       = now;
+		c->epoch_valid = 1;
+		if( tcb->cwnd < c->w_max ){
+			/* RFC 8312 4.1: K = cubic_root(W_max*(1-beta)/C), from the reduced window. */
+			c->k      = cubic_cbrt( ((uint64_t)(c->w_max - tcb->cwnd)*1000u/mss) * 2500000u );
+			c->origin = c->w_max;
+		}else{
+			c->k      = 0;
+			c->origin = tcb->cwnd;
+		}
+		c->w_est = tcb->cwnd;
+	}
+	
+	/* RFC 8312 4.1: W_cubic(t+RTT) = C*(t+RTT-K)^3 + W_max. */
+	dt = (int64_t)(now - c->epoch) + c->min_rtt - c->k;
+	if( dt >  CUBIC_DT_MAX ) dt =  CUBIC_DT_MAX;
+	if( dt < -CUBIC_DT_MAX ) dt = -CUBIC_DT_MAX;
+	delta  = ((dt*dt*dt) / 1000000) * mss * 4 / 10000;
+	target = (delta < 0 && (uint64_t)(-delta) >= c->origin) ? 0 : (uint64_t)((int64_t)c->origin + delta);
+	
+	/* RFC 8312 4.3, 4.4: Grow towards the target, by at most half the window per RTT. */
+	if( target > (uint64_t)tcb->cwnd*3/2 ) target = (uint64_t)tcb->cwnd*3/2;
+	if( target > tcb->cwnd )
+		incr = (target - tcb->cwnd) * acked / tcb->cwnd;
+	else
+		incr = ((uint64_t)mss * acked) / (100u * (uint64_t)tcb->cwnd);
+	tcb->cwnd += incr ? (uint32_t)incr : 1;
+	
+	/* RFC 8312 4.2: The TCP-friendly region; grows like Reno, with alpha = 3*(1-beta)/(1+beta). */
+	c->w_est += (uint32_t)(((uint64_t)mss * acked * 9) / (17u * (uint64_t)tcb->cwnd));
+	if( c->w_est > tcb->cwnd ) tcb->cwnd = c->w_est;
+}
+
+static void cubic_loss(nettcp_tcb_t *tcb, int event){
+	cubic_t *c = CUBIC(tcb);
+	uint32_t mss = tcb->snd_mss;
+	
+	c->epoch_valid = 0;
+	
+	/* RFC 8312 4.6: Fast convergence. */
+	if( tcb->cwnd < c->w_last_max ){
+		c->w_last_max = tcb->cwnd;
+		c->w_max      = (uint32_t)(((uint64_t)tcb->cwnd * 17) / 20);
+	}else{
+		c->w_last_max = tcb->cwnd;
+		c->w_max      = tcb->cwnd;
+	}
+	
+	/* RFC 8312 4.5: ssthresh = cwnd*beta. */
+	tcb->ssthresh = (uint32_t)(((uint64_t)tcb->cwnd * 7) / 10);
+	if( tcb->ssthresh < 2u*mss ) tcb->ssthresh = 2u*mss;
+	
+	if( event == NETTCP_CC_LOSS_FAST )
+		tcb->cwnd = tcb->ssthresh + 3u*mss;
+	else
+		tcb->cwnd = mss;
+}
+
+static void cubic_rtt_sample(nettcp_tcb_t *tcb, uint32_t rtt){
+	cubic_t *c = CUBIC(tcb);
+	
+	if( (! c->min_rtt) || (rtt < c->min_rtt) ) c->min_rtt = rtt;
+}
+
+const nettcp_cc_ops_t nettcp_cc_cubic = {
+	.name        = "cubic",
+	.init        = cubic_init,
+	.ack         = cubic_ack,
+	.loss        = cubic_loss,
+	.rtt_sample  = cubic_rtt_sample,
+	.pacing_rate = 0,
+};
+
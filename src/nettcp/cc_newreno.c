@@ -0,0 +1,60 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/cc.h>
+#include <nettcp/tcb.h>
+
+/*
+ * NewReno (RFC 5681, RFC 6582): Slow start, congestion avoidance, and a
+ * multiplicative decrease by half of the data in flight.
+ */
+
+static void newreno_ack(nettcp_tcb_t *tcb, uint32_t acked){
+	uint32_t incr;
+	
+	if( tcb->cwnd < tcb->ssthresh ){
+		/* RFC 5681 3.1: Slow start. */
+		tcb->cwnd += acked < tcb->snd_mss ? acked : tcb->snd_mss;
+	}else{
+		/* RFC 5681 3.1: Congestion avoidance. */
+		incr = ((uint32_t)tcb->snd_mss * tcb->snd_mss) / tcb->cwnd;
+		tcb->cwnd += incr ? incr : 1;
+	}
+}
+
+static void newreno_loss(nettcp_tcb_t *tcb, int event){
+	uint32_t flight;
+	
+	/* RFC 5681 3.1 (4): ssthresh = max(FlightSize/2, 2*SMSS). */
+	flight = tcb->snd_max - tcb->snd_una;
+	tcb->ssthresh = (flight/2) > (2u*tcb->snd_mss) ? (flight/2) : (2u*tcb->snd_mss);
+	
+	/* RFC 6582 3.2 step 2: cwnd = ssthresh + 3*SMSS; RFC 5681 3.1: after a timeout, 1 SMSS. */
+	if( event == NETTCP_CC_LOSS_FAST )
+		tcb->cwnd = tcb->ssthresh + 3u*tcb->snd_mss;
+	else
+		tcb->cwnd = tcb->snd_mss;
+}
+
+const nettcp_cc_ops_t nettcp_cc_newreno = {
+	.name        = "newreno",
+	.init        = 0,
+	.ack         = newreno_ack,
+	.loss        = newreno_loss,
+	.rtt_sample  = 0,
+	.pacing_rate = 0,
+};
+
@@ -14,11 +14,784 @@
  *   limitations under the License.
  */
 #include <nettcp/input.h>
+#include <nettcp/tcb.h>
+#include <nettcp/if.h>
+#include <nettcp/tcp_header.h>
+#include <nettcp/output.h>
+#include <nettcp/response.h>
+#include <nettcp/syncookie.h>
 #include <netsock/hashtab.h>
+#include <netprot/reachable.h>
+#include <netstd/endianness.h>
+#include <netstd/atomic.h>
+#include <netstd/mem.h>
+
+/*
+ * The fields of an incoming segment, in host byte order.
+ */
+typedef struct nettcp_seg{
+	uint32_t  seq;
+	uint32_t  ack;
+	uint32_t  wnd;     /* Window field (not scaled). */
+	uint32_t  len;     /* Length of the data. */
+	uint16_t  mss;     /* MSS option; 0 = absent. */
+	uint8_t   flags;
+	uint8_t   wscale;  /* Window Scale option; 0xff = absent. */
+} nettcp_seg_t;
+
+static void nettcp_parse_options(nettcp_seg_t *seg, const uint8_t *opt, uint32_t len){
+	while(len){
+		if( opt[0] == FNET_TCP_OPT_EOL ) return;
+		if( opt[0] == FNET_TCP_OPT_NOP ){
+			opt++;
+			len--;
+			continue;
+		}
+		if( (len < 2) || (opt[1] < 2) || (opt[1] > len) ) return;
+		switch(opt[0]){
+		case FNET_TCP_OPT_MSS:
+			if( opt[1] == FNET_TCP_OPT_MSS_LEN ) seg->mss = ((uint16_t)opt[2] << 8) | opt[3];
+			break;
+		case FNET_TCP_OPT_WS:
+			/* RFC 7323 2.3: A shift count above 14 is treated as 14. */
+			if( opt[1] == FNET_TCP_OPT_WS_LEN ) seg->wscale = (opt[2] > FNET_TCP_WS_MAX) ? FNET_TCP_WS_MAX : opt[2];
+			break;
+		}
+		len -= opt[1];
+		opt += opt[1];
+	}
+}
+
+/*
+ * Applies the options of a received SYN and initializes the congestion window.
+ */
+static void nettcp_syn_options(nettcp_tcb_t *tcb, nettcp_seg_t *seg){
+	uint16_t mss;
+	
+	mss = nettcp_mss(tcb->nif,tcb->flow.local_a.type);
+	
+	/*
+	 * RFC 1122 4.2.2.6: Without an MSS option, 536 is assumed; RFC 8200 8.3:
+	 * for IPv6, the minimum MTU of 1280 minus the headers.
+	 */
+	if(! seg->mss ) seg->mss = (tcb->flow.local_a.type == NET_SKA_IN6) ? 1220 : FNET_TCP_DEFAULT_MSS;
+	if( seg->mss < mss ) mss = seg->mss;
+	tcb->snd_mss = mss;
+	
+	/* RFC 7323 1.3: Window scaling is only used, if both sides sent the option. */
+	if( seg->wscale != 0xff ){
+		tcb->flags    |= NETTCP_TF_WSCALE;
+		tcb->snd_scale = seg->wscale;
+	}else{
+		tcb->flags    &= ~NETTCP_TF_WSCALE;
+		tcb->snd_scale = 0;
+		tcb->rcv_scale = 0;
+	}
+	
+	/* RFC 5681 3.1: IW = min(4*SMSS, max(2*SMSS, 4380)); ssthresh arbitrarily high. */
+	tcb->cwnd = 2u*mss > 4380u ? 2u*mss : 4380u;
+	if( tcb->cwnd > 4u*mss ) tcb->cwnd = 4u*mss;
+	tcb->ssthresh = 0xffffffffu;
+	
+	net_bzero(tcb->cc_priv,sizeof(tcb->cc_priv));
+	if( tcb->cc->init ) tcb->cc->init(tcb);
+}
+
+/*
+ * RFC 6298 2: Updates SRTT, RTTVAR and RTO with a new measurement.
+ */
+static void nettcp_rtt_update(nettcp_tcb_t *tcb, uint32_t rtt){
+	int32_t delta;
+	
+	if(! tcb->srtt ){
+		tcb->srtt   = rtt << 3;
+		tcb->rttvar = rtt << 1;
+	}else{
+		delta = (int32_t)rtt - (int32_t)(tcb->srtt >> 3);
+		tcb->srtt += delta;
+		if( delta < 0 ) delta = -delta;
+		tcb->rttvar += delta - (tcb->rttvar >> 2);
+	}
+	
+	/* RTO = SRTT + max(G, K*RTTVAR); the clock granularity is 1 ms. */
+	tcb->rto = (tcb->srtt >> 3) + (tcb->rttvar ? tcb->rttvar : 1);
+	if( tcb->rto < NETTCP_RTO_MIN ) tcb->rto = NETTCP_RTO_MIN;
+	if( tcb->rto > NETTCP_RTO_MAX ) tcb->rto = NETTCP_RTO_MAX;
+	
+	if( tcb->cc->rtt_sample ) tcb->cc->rtt_sample(tcb,rtt);
+}
+
+static void nettcp_rcvbuf_append(nettcp_tcb_t *tcb, netpkt_t *pkt){
+	pkt->next_chain = 0;
+	if( tcb->rcv_tail )
+		tcb->rcv_tail->next_chain = pkt;
+	else
+		tcb->rcv_head = pkt;
+	tcb->rcv_tail = pkt;
+	tcb->rcv_len += NETPKT_LENGTH(pkt);
+}
+
+/*
+ * Removes 'len' acknowledged bytes from the head of the send buffer.
+ */
+static void nettcp_sndbuf_drop(nettcp_tcb_t *tcb, uint32_t len){
+	netpkt_t *pkt;
+	uint32_t plen;
+	
+	while( len && (pkt = tcb->snd_head) ){
+		plen = NETPKT_LENGTH(pkt);
+		if( plen <= len ){
+			tcb->snd_head = pkt->next_chain;
+			tcb->snd_len -= plen;
+			len -= plen;
+			netpkt_free(pkt);
+		}else{
+			netpkt_pullfront(pkt,len);
+			tcb->snd_len -= len;
+			len = 0;
+		}
+	}
+	if(! tcb->snd_head ) tcb->snd_tail = 0;
+}
+
+/*
+ * RFC 5681 3.2 and RFC 6582 3.2: A duplicate ACK. The third one triggers the
+ * fast retransmit and the fast recovery.
+ */
+static void nettcp_cc_dupack(nettcp_tcb_t *tcb){
+	tcb->dupacks++;
+	if( tcb->dupacks == 3 ){
+		/* RFC 6582 3.2 step 2: Not again for losses of the same window. */
+		if( NETTCP_SEQ_LT(tcb->snd_una,tcb->recover) ){
+			tcb->dupacks = 0;
+			return;
+		}
+		tcb->cc->loss(tcb,NETTCP_CC_LOSS_FAST);
+		tcb->recover = tcb->snd_max;
+		nettcp_retransmit(tcb);
+	}else if( tcb->dupacks > 3 ){
+		tcb->cwnd += tcb->snd_mss;
+		nettcp_output(tcb);
+	}
+}
+
+/*
+ * RFC 6582 3.2: An ACK of 'acked' new bytes. Outside of a fast recovery, the
+ * congestion control module grows the window.
+ */
+static void nettcp_cc_newack(nettcp_tcb_t *tcb, uint32_t acked){
+	uint32_t incr;
+	
+	if( tcb->dupacks >= 3 ){
+		if( NETTCP_SEQ_GEQ(tcb->snd_una,tcb->recover) ){
+			/* Full acknowledgment: Deflate the window. */
+			incr = tcb->snd_max - tcb->snd_una + tcb->snd_mss;
+			tcb->cwnd = tcb->ssthresh < incr ? tcb->ssthresh : incr;
+			tcb->dupacks = 0;
+		}else{
+			/* Partial acknowledgment: Retransmit the next segment. */
+			nettcp_retransmit(tcb);
+			tcb->cwnd = (tcb->cwnd > acked) ? (tcb->cwnd - acked) : 0;
+			tcb->cwnd += tcb->snd_mss;
+		}
+		return;
+	}
+	tcb->dupacks = 0;
+	tcb->cc->ack(tcb,acked);
+}
+
+/*
+ * Processes the acknowledgment of new data: snd_una < ack <= snd_max.
+ */
+static void nettcp_ack_advance(nettcp_tcb_t *tcb, uint32_t ack){
+	uint32_t acked, data;
+	net_time_t now;
+	
+	now   = net_timer_ms();
+	acked = ack - tcb->snd_una;
+	data  = acked;
+	
+	/* Our FIN occupies one sequence number, but no byte in the send buffer. */
+	if( (tcb->flags & NETTCP_TF_SENTFIN) && NETTCP_SEQ_GT(ack,tcb->snd_fin) ) data--;
+	if( data > tcb->snd_len ) data = tcb->snd_len;
+	nettcp_sndbuf_drop(tcb,data);
+	
+	/* RFC 6298 3: Karn's algorithm; only the timed segment is measured. */
+	if( tcb->rtt_active && NETTCP_SEQ_GT(ack,tcb->rtt_seq) ){
+		nettcp_rtt_update(tcb,(uint32_t)(now - tcb->rtt_time));
+		tcb->rtt_active = 0;
+	}
+	tcb->rexmt_shift = 0;
+	
+	tcb->snd_una = ack;
+	if( NETTCP_SEQ_LT(tcb->snd_nxt,tcb->snd_una) ) tcb->snd_nxt = tcb->snd_una;
+	
+	nettcp_cc_newack(tcb,acked);
+	
+	/* RFC 6298 5.2, 5.3: Stop the timer, or restart it. */
+	tcb->rexmt_time = (tcb->snd_una == tcb->snd_max) ? 0 : now + tcb->rto;
+	
+	netprot_confirm_reachable(tcb->nif,&(tcb->flow));
+}
+
+/*
+ * RFC 1122 4.2.3.2 and RFC 5681 4.2: An ACK is delayed, but at least every
+ * second full-sized segment is acknowledged.
+ */
+static void nettcp_delack(nettcp_tcb_t *tcb){
+	if( tcb->flags & NETTCP_TF_DELACK ){
+		tcb->flags |= NETTCP_TF_ACKNOW;
+	}else{
+		tcb->flags |= NETTCP_TF_DELACK;
+		tcb->delack_time = net_timer_ms() + NETTCP_DELACK_MS;
+	}
+}
+
+/*
+ * Inserts a segment, that is beyond rcv_nxt, into the reassembly queue.
+ */
+static void nettcp_ooo_insert(nettcp_tcb_t *tcb, netpkt_t *pkt, uint32_t seq){
+	netpkt_t **pos;
+	
+	for( pos = &(tcb->ooo_head) ; *pos && NETTCP_SEQ_LT((*pos)->tcp.seq,seq) ; pos = &((*pos)->next_chain) );
+	
+	/* Duplicate. */
+	if( *pos && ((*pos)->tcp.seq == seq) && (NETPKT_LENGTH(*pos) >= NETPKT_LENGTH(pkt)) ){
+		netpkt_free(pkt);
+		return;
+	}
+	pkt->tcp.seq    = seq;
+	pkt->next_chain = *pos;
+	*pos = pkt;
+	tcb->ooo_len += NETPKT_LENGTH(pkt);
+}
+
+/*
+ * Moves the segments from the reassembly queue, that have become in-order, to
+ * the receive buffer. Overlaps are trimmed.
+ */
+static void nettcp_ooo_drain(nettcp_tcb_t *tcb){
+	netpkt_t *pkt;
+	uint32_t plen, end;
+	
+	while( (pkt = tcb->ooo_head) && NETTCP_SEQ_LEQ(pkt->tcp.seq,tcb->rcv_nxt) ){
+		tcb->ooo_head = pkt->next_chain;
+		plen = NETPKT_LENGTH(pkt);
+		tcb->ooo_len -= plen;
+		end = pkt->tcp.seq + plen;
+		if( NETTCP_SEQ_GT(end,tcb->rcv_nxt) ){
+			netpkt_pullfront(pkt,tcb->rcv_nxt - pkt->tcp.seq);
+			nettcp_rcvbuf_append(tcb,pkt);
+			tcb->rcv_nxt = end;
+		}else
+			netpkt_free(pkt);
+	}
+}
+
+/*
+ * A SYN on a listening port: Creates the connection in the SYN-RECEIVED state
+ * and sends the SYN-ACK.
+ */
+static void nettcp_listen_input(nettcp_tcb_t *lis, nettcp_seg_t *seg, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	nettcp_tcb_t *tcb;
+	
+	if(! (tcb = nettcp_tcb_new(lis->nif)) ) return;
+	
+	tcb->opts        = lis->opts;
+	tcb->cc          = lis->cc;
+	tcb->flags       = lis->flags & NETTCP_TF_NODELAY;
+	tcb->snd_max_len = lis->snd_max_len;
+	tcb->rcv_max_len = lis->rcv_max_len;
+	tcb->flow.local_a  = *dst_addr;
+	tcb->flow.remote_a = *src_addr;
+	
+	/* The connection references its listener, and counts in its SYN backlog. */
+	tcb->parent = lis;
+	netsock_incr_flow(lis->nif->sockets,&(lis->flow));
+	tcb->flags |= NETTCP_TF_SYNQ;
+	net_atomic_fetch_add(&(lis->syn_count),1);
+	
+	tcb->state     = NETTCP_SYN_RCVD;
+	tcb->irs       = seg->seq;
+	tcb->rcv_nxt   = seg->seq+1;
+	tcb->rcv_adv   = tcb->rcv_nxt;
+	tcb->rcv_scale = nettcp_rcv_wscale(tcb->rcv_max_len);
+	nettcp_syn_options(tcb,seg);
+	
+	tcb->iss     = nettcp_iss(lis->nif,dst_addr,src_addr);
+	tcb->snd_una = tcb->iss;
+	tcb->snd_nxt = tcb->iss;
+	tcb->snd_max = tcb->iss;
+	tcb->recover = tcb->iss;
+	tcb->snd_wnd = seg->wnd;
+	tcb->snd_wl1 = seg->seq;
+	tcb->snd_wl2 = tcb->iss;
+	
+	net_atomic_fetch_add(&(lis->nif->tcp->passive_opens),1);
+	
+	net_mutex_lock(tcb->lock);
+	nettcp_tcb_attach(tcb,0);
+	nettcp_output(tcb);
+	net_mutex_unlock(tcb->lock);
+}
+
+/*
+ * The third segment of a handshake, whose SYN-ACK has carried a SYN cookie:
+ * Creates the connection directly in the ESTABLISHED state. The MSS is taken
+ * from the cookie; window scaling is not used.
+ * Returns the connection (with a reference for the caller), or NULL, if the
+ * cookie is invalid.
+ */
+static nettcp_tcb_t* nettcp_cookie_input(nettcp_tcb_t *lis, nettcp_seg_t *seg, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	nettcp_tcb_t *tcb;
+	nettcp_seg_t syn;
+	
+	syn.wscale = 0xff;
+	if( nettcp_syncookie_check(lis->nif,dst_addr,src_addr,seg->seq-1,seg->ack-1,&(syn.mss)) ) return 0;
+	
+	if(! (tcb = nettcp_tcb_new(lis->nif)) ) return 0;
+	
+	tcb->opts        = lis->opts;
+	tcb->cc          = lis->cc;
+	tcb->flags       = lis->flags & NETTCP_TF_NODELAY;
+	tcb->snd_max_len = lis->snd_max_len;
+	tcb->rcv_max_len = lis->rcv_max_len;
+	tcb->flow.local_a  = *dst_addr;
+	tcb->flow.remote_a = *src_addr;
+	
+	tcb->parent = lis;
+	netsock_incr_flow(lis->nif->sockets,&(lis->flow));
+	
+	tcb->state   = NETTCP_ESTABLISHED;
+	tcb->irs     = seg->seq-1;
+	tcb->rcv_nxt = seg->seq;
+	tcb->rcv_adv = tcb->rcv_nxt;
+	nettcp_syn_options(tcb,&syn);
+	
+	tcb->iss     = seg->ack-1;
+	tcb->snd_una = seg->ack;
+	tcb->snd_nxt = seg->ack;
+	tcb->snd_max = seg->ack;
+	tcb->recover = tcb->iss;
+	tcb->snd_wnd = seg->wnd;
+	tcb->snd_wl1 = seg->seq;
+	tcb->snd_wl2 = seg->ack;
+	
+	net_atomic_fetch_add(&(lis->nif->tcp->passive_opens),1);
+	
+	/* One reference for the hashtable, one for the caller. */
+	nettcp_tcb_attach(tcb,0);
+	netsock_incr_flow(lis->nif->sockets,&(tcb->flow));
+	return tcb;
+}
+
+/*
+ * Queues an established connection at its listener, for nettcp_accept().
+ * Lock-free; must be called without holding a lock.
+ */
+static void nettcp_accept_enqueue(nettcp_tcb_t *lis, nettcp_tcb_t *tcb){
+	/* The queue holds a reference. */
+	netsock_incr_flow(tcb->nif->sockets,&(tcb->flow));
+	
+	if( nettcp_acceptq_enqueue(lis->acceptq,tcb) ){
+		/* The queue is full. */
+		net_mutex_lock(tcb->lock);
+		nettcp_output_rst(tcb);
+		nettcp_tcb_close(tcb,NETTCP_ERR_ABORTED);
+		net_mutex_unlock(tcb->lock);
+		nettcp_tcb_release(tcb);
+		return;
+	}
+	
+	/*
+	 * If the listener has been closed in the meantime, its drain might have
+	 * missed this connection (see nettcp_tcb_close()).
+	 */
+	net_memory_barrier();
+	if( lis->state != NETTCP_LISTEN ) nettcp_listen_drain(lis);
+}
 
 void nettcp_input(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	fnet_tcp_header_t  *hdr;
+	nettcp_tcb_t       *tcb, *child;
+	nettcp_seg_t       seg;
+	uint32_t           hlen, win, todrop, seglen, fin_seq, cookie;
+	uint16_t           window;
+	int                acceptable, finacked, established = 0, had_ooo;
+	
+	tcb = flow->instance;
+	if( (! tcb) || (! nif->tcp) ) goto DROP;
+	
+	/* The header must reside in contiguous area of memory. */
+	if( netpkt_pullup(pkt,sizeof(fnet_tcp_header_t)) ) goto DROP;
+	
+	hdr  = netpkt_data(pkt);
+	hlen = FNET_TCP_HDR_LENGTH(hdr);
+	if( (hlen < sizeof(fnet_tcp_header_t)) || (hlen > NETPKT_LENGTH(pkt)) ) goto DROP;
+	
+	/*
+	 * Skip the checksum, if the interface has already verified it. Once
+	 * verified, it is not verified again, if the segment is answered with
+	 * a RST.
+	 */
+	if(! (pkt->flags & NETPKT_FLAG_L4_CSUM_OK) ){
+		if( nettcp_checksum(pkt,NETPKT_LENGTH(pkt),src_addr,dst_addr) ) goto DROP;
+		pkt->flags |= NETPKT_FLAG_L4_CSUM_OK;
+	}
+	
+	if( netpkt_pullup(pkt,hlen) ) goto DROP;
+	hdr = netpkt_data(pkt);
+	
+	seg.seq    = ntoh32(hdr->sequence);
+	seg.ack    = ntoh32(hdr->ack_number);
+	seg.wnd    = ntoh16(hdr->window);
+	seg.flags  = hdr->flags;
+	seg.len    = NETPKT_LENGTH(pkt) - hlen;
+	seg.mss    = 0;
+	seg.wscale = 0xff;
+	if( (seg.flags & FNET_TCP_SGT_SYN) && (hlen > sizeof(fnet_tcp_header_t)) )
+		nettcp_parse_options(&seg,(const uint8_t*)(hdr+1),hlen - sizeof(fnet_tcp_header_t));
+	
+	/*
+	 * Remember the offset of the header (for a RST, that reuses the packet),
+	 * and strip it.
+	 */
+	if( netpkt_levelup(pkt) ) goto DROP;
+	
+	if( netpkt_pullfront(pkt,hlen) ) goto DROP;
+	
+	net_mutex_lock(tcb->lock);
+	
+	/*
+	 * Header prediction (Van Jacobson): An in-sequence segment on an
+	 * established connection, that is either a pure ACK for new data, or
+	 * pure in-order data, that acknowledges nothing new. Nothing else changes;
+	 * no retransmission or fast recovery is in progress.
+	 */
+	if( (tcb->state == NETTCP_ESTABLISHED)
+		&& ((seg.flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_FIN|FNET_TCP_SGT_RST|FNET_TCP_SGT_URG|FNET_TCP_SGT_ACK)) == FNET_TCP_SGT_ACK)
+		&& (seg.seq == tcb->rcv_nxt)
+		&& ((seg.wnd << tcb->snd_scale) == tcb->snd_wnd)
+		&& (tcb->snd_nxt == tcb->snd_max)
+		&& (tcb->dupacks < 3) )
+	{
+		if( seg.len == 0 ){
+			if( NETTCP_SEQ_GT(seg.ack,tcb->snd_una) && NETTCP_SEQ_LEQ(seg.ack,tcb->snd_max) ){
+				net_atomic_fetch_add(&(nif->tcp->fastpath),1);
+				tcb->snd_wl2 = seg.ack;
+				nettcp_ack_advance(tcb,seg.ack);
+				if( tcb->snd_len ) nettcp_output(tcb);
+				goto UNLOCK;
+			}
+		}else if( (seg.ack == tcb->snd_una) && (! tcb->ooo_head) && (seg.len <= NETTCP_RCV_SPACE(tcb)) ){
+			net_atomic_fetch_add(&(nif->tcp->fastpath),1);
+			nettcp_rcvbuf_append(tcb,pkt);
+			pkt = 0;
+			tcb->rcv_nxt += seg.len;
+			nettcp_delack(tcb);
+			if( tcb->flags & NETTCP_TF_ACKNOW ) nettcp_output(tcb);
+			goto UNLOCK;
+		}
+	}
+	
+	switch(tcb->state){
+	case NETTCP_CLOSED:
+		goto UNLOCK_RST;
+	case NETTCP_LISTEN:
+		if( seg.flags & FNET_TCP_SGT_RST ) goto UNLOCK;
+		if( seg.flags & FNET_TCP_SGT_ACK ){
+			/* Maybe the completion of a handshake, that was answered with a SYN cookie. */
+			if( (seg.flags & FNET_TCP_SGT_SYN) || !(tcb->flags & NETTCP_TF_COOKIES) ) goto UNLOCK_RST;
+			if( (net_timer_ms() - tcb->cookie_time) >= 2u*NETTCP_COOKIE_PERIOD_MS ){
+				tcb->flags &= ~NETTCP_TF_COOKIES;
+				goto UNLOCK_RST;
+			}
+			if(! (child = nettcp_cookie_input(tcb,&seg,src_addr,dst_addr)) ) goto UNLOCK_RST;
+			goto UNLOCK_COOKIE;
+		}
+		if(! (seg.flags & FNET_TCP_SGT_SYN) ) goto UNLOCK;
+		
+		/* RFC 4987 3.6: When the SYN backlog is full, no state is kept for new SYNs. */
+		if( tcb->syn_count >= tcb->syn_backlog ){
+			if(! seg.mss ) seg.mss = (dst_addr->type == NET_SKA_IN6) ? 1220 : FNET_TCP_DEFAULT_MSS;
+			cookie = nettcp_syncookie_make(nif,dst_addr,src_addr,seg.seq,&(seg.mss));
+			window = tcb->rcv_max_len > 0xffffu ? 0xffffu : (uint16_t)tcb->rcv_max_len;
+			tcb->flags |= NETTCP_TF_COOKIES;
+			tcb->cookie_time = net_timer_ms();
+			goto UNLOCK_SYNACK;
+		}
+		nettcp_listen_input(tcb,&seg,src_addr,dst_addr);
+		goto UNLOCK;
+	case NETTCP_SYN_SENT:
+		if( (seg.flags & FNET_TCP_SGT_ACK) && ( NETTCP_SEQ_LEQ(seg.ack,tcb->iss) || NETTCP_SEQ_GT(seg.ack,tcb->snd_max) ) ){
+			if( seg.flags & FNET_TCP_SGT_RST ) goto UNLOCK;
+			goto UNLOCK_RST;
+		}
+		if( seg.flags & FNET_TCP_SGT_RST ){
+			if( seg.flags & FNET_TCP_SGT_ACK ){
+				net_atomic_fetch_add(&(nif->tcp->resets),1);
+				nettcp_tcb_close(tcb,NETTCP_ERR_REFUSED);
+			}
+			goto UNLOCK;
+		}
+		if(! (seg.flags & FNET_TCP_SGT_SYN) ) goto UNLOCK;
+		
+		tcb->irs     = seg.seq;
+		tcb->rcv_nxt = seg.seq+1;
+		tcb->rcv_adv = tcb->rcv_nxt;
+		nettcp_syn_options(tcb,&seg);
+		tcb->snd_wnd = seg.wnd; /* RFC 7323 2.2: Not scaled in a SYN. */
+		tcb->snd_wl1 = seg.seq;
+		tcb->snd_wl2 = seg.ack;
+		
+		if( seg.flags & FNET_TCP_SGT_ACK ){
+			if( tcb->rtt_active ){
+				nettcp_rtt_update(tcb,(uint32_t)(net_timer_ms() - tcb->rtt_time));
+				tcb->rtt_active = 0;
+			}
+			tcb->snd_una     = seg.ack;
+			tcb->rexmt_time  = 0;
+			tcb->rexmt_shift = 0;
+			tcb->state       = NETTCP_ESTABLISHED;
+			tcb->flags      |= NETTCP_TF_ACKNOW;
+			
+			/* Data, that came with the SYN, is not accepted; the peer sends it again. */
+		}else{
+			/* Simultaneous open (RFC 793 3.4); the SYN is sent again with an ACK. */
+			tcb->state   = NETTCP_SYN_RCVD;
+			tcb->snd_nxt = tcb->iss;
+		}
+		nettcp_output(tcb);
+		goto UNLOCK;
+	}
+	
+	/*
+	 * RFC 793 3.9: First, check the sequence number. A segment is acceptable,
+	 * if it (or a part of it) is within the receive window.
+	 */
+	win = NETTCP_RCV_SPACE(tcb);
+	if( NETTCP_SEQ_GT(tcb->rcv_adv,tcb->rcv_nxt) && (win < (tcb->rcv_adv - tcb->rcv_nxt)) )
+		win = tcb->rcv_adv - tcb->rcv_nxt;
+	seglen = seg.len + ((seg.flags & FNET_TCP_SGT_SYN) ? 1 : 0) + ((seg.flags & FNET_TCP_SGT_FIN) ? 1 : 0);
+	if( seglen == 0 )
+		acceptable = win ? ( NETTCP_SEQ_GEQ(seg.seq,tcb->rcv_nxt) && NETTCP_SEQ_LT(seg.seq,tcb->rcv_nxt+win) ) : (seg.seq == tcb->rcv_nxt);
+	else
+		acceptable = win && (
+			( NETTCP_SEQ_GEQ(seg.seq,tcb->rcv_nxt) && NETTCP_SEQ_LT(seg.seq,tcb->rcv_nxt+win) ) ||
+			( NETTCP_SEQ_GEQ(seg.seq+seglen-1,tcb->rcv_nxt) && NETTCP_SEQ_LT(seg.seq+seglen-1,tcb->rcv_nxt+win) ) );
+	
+	/* A duplicate, that carries only a FIN, is acknowledged below. */
+	if( (! acceptable) && (tcb->state == NETTCP_TIME_WAIT) && (seg.flags & FNET_TCP_SGT_FIN) )
+		tcb->tw_time = net_timer_ms() + 2u*NETTCP_MSL_MS;
+	
+	if(! acceptable ){
+		if(! (seg.flags & FNET_TCP_SGT_RST) ){
+			tcb->flags |= NETTCP_TF_ACKNOW;
+			nettcp_output(tcb);
+		}
+		goto UNLOCK;
+	}
+	
+	/* Trim the segment to the window: the old part, */
+	if( NETTCP_SEQ_LT(seg.seq,tcb->rcv_nxt) ){
+		todrop = tcb->rcv_nxt - seg.seq;
+		if( seg.flags & FNET_TCP_SGT_SYN ){
+			seg.flags &= ~FNET_TCP_SGT_SYN;
+			seg.seq++;
+			todrop--;
+		}
+		if( todrop > seg.len ){
+			/* The FIN has already been received. */
+			seg.flags &= ~FNET_TCP_SGT_FIN;
+			todrop = seg.len;
+		}
+		netpkt_pullfront(pkt,todrop);
+		seg.seq += todrop;
+		seg.len -= todrop;
+		tcb->flags |= NETTCP_TF_ACKNOW;
+	}
+	
+	/* and the part beyond the window. */
+	if( NETTCP_SEQ_GT(seg.seq+seg.len,tcb->rcv_nxt+win) ){
+		todrop = seg.seq + seg.len - (tcb->rcv_nxt+win);
+		seg.len -= todrop;
+		netpkt_setlength(pkt,seg.len);
+		seg.flags &= ~FNET_TCP_SGT_FIN;
+		tcb->flags |= NETTCP_TF_ACKNOW;
+	}
+	
+	/*
+	 * Second, check the RST bit. RFC 5961 3.2: Only a RST, that exactly
+	 * matches rcv_nxt, resets the connection; otherwise a challenge ACK is
+	 * sent.
+	 */
+	if( seg.flags & FNET_TCP_SGT_RST ){
+		if( seg.seq == tcb->rcv_nxt ){
+			net_atomic_fetch_add(&(nif->tcp->resets),1);
+			nettcp_tcb_close(tcb,NETTCP_ERR_RESET);
+		}else{
+			tcb->flags |= NETTCP_TF_ACKNOW;
+			nettcp_output(tcb);
+		}
+		goto UNLOCK;
+	}
+	
+	/* Fourth, check the SYN bit. RFC 5961 4.2: Send a challenge ACK. */
+	if( seg.flags & FNET_TCP_SGT_SYN ){
+		tcb->flags |= NETTCP_TF_ACKNOW;
+		nettcp_output(tcb);
+		goto UNLOCK;
+	}
+	
+	/* Fifth, check the ACK field. */
+	if(! (seg.flags & FNET_TCP_SGT_ACK) ) goto UNLOCK;
+	
+	if( tcb->state == NETTCP_SYN_RCVD ){
+		if( NETTCP_SEQ_LEQ(seg.ack,tcb->snd_una) || NETTCP_SEQ_GT(seg.ack,tcb->snd_max) ) goto UNLOCK_RST;
+		
+		/* Our SYN has been acknowledged. */
+		if( tcb->rtt_active ){
+			nettcp_rtt_update(tcb,(uint32_t)(net_timer_ms() - tcb->rtt_time));
+			tcb->rtt_active = 0;
+		}
+		tcb->snd_una++;
+		if( tcb->flags & NETTCP_TF_SYNQ ) nettcp_synq_leave(tcb);
+		tcb->rexmt_time  = 0;
+		tcb->rexmt_shift = 0;
+		tcb->state   = NETTCP_ESTABLISHED;
+		tcb->snd_wnd = seg.wnd << tcb->snd_scale;
+		tcb->snd_wl1 = seg.seq;
+		tcb->snd_wl2 = seg.ack;
+		established  = 1;
+	}
+	
+	if( NETTCP_SEQ_GT(seg.ack,tcb->snd_max) ){
+		/* An ACK for something not yet sent. */
+		tcb->flags |= NETTCP_TF_ACKNOW;
+		nettcp_output(tcb);
+		goto UNLOCK;
+	}
+	
+	if( NETTCP_SEQ_GT(seg.ack,tcb->snd_una) )
+		nettcp_ack_advance(tcb,seg.ack);
+	else if( (seg.ack == tcb->snd_una) && (seg.len == 0) && !(seg.flags & FNET_TCP_SGT_FIN)
+		&& (tcb->snd_max != tcb->snd_una) && ((seg.wnd << tcb->snd_scale) == tcb->snd_wnd) )
+		nettcp_cc_dupack(tcb);
+	
+	/* RFC 793 3.9: Update the send window, if the segment is not older. */
+	if( NETTCP_SEQ_LT(tcb->snd_wl1,seg.seq) || ((tcb->snd_wl1 == seg.seq) && NETTCP_SEQ_LEQ(tcb->snd_wl2,seg.ack)) ){
+		tcb->snd_wnd = seg.wnd << tcb->snd_scale;
+		tcb->snd_wl1 = seg.seq;
+		tcb->snd_wl2 = seg.ack;
+	}
+	
+	finacked = (tcb->flags & NETTCP_TF_SENTFIN) && NETTCP_SEQ_GT(tcb->snd_una,tcb->snd_fin);
+	switch(tcb->state){
+	case NETTCP_FIN_WAIT_1:
+		if( finacked ) tcb->state = NETTCP_FIN_WAIT_2;
+		break;
+	case NETTCP_CLOSING:
+		if( finacked ){
+			tcb->state   = NETTCP_TIME_WAIT;
+			tcb->tw_time = net_timer_ms() + 2u*NETTCP_MSL_MS;
+		}
+		break;
+	case NETTCP_LAST_ACK:
+		if( finacked ){
+			nettcp_tcb_close(tcb,NETTCP_ERR_NONE);
+			goto UNLOCK;
+		}
+		break;
+	case NETTCP_TIME_WAIT:
+		tcb->flags  |= NETTCP_TF_ACKNOW;
+		tcb->tw_time = net_timer_ms() + 2u*NETTCP_MSL_MS;
+		break;
+	}
+	
+	/* Seventh, process the segment text. */
+	fin_seq = seg.seq + seg.len;
+	if( seg.len && NETTCP_CAN_RCV_DATA(tcb->state) ){
+		if( seg.seq == tcb->rcv_nxt ){
+			had_ooo = tcb->ooo_head ? 1 : 0;
+			nettcp_rcvbuf_append(tcb,pkt);
+			pkt = 0;
+			tcb->rcv_nxt += seg.len;
+			nettcp_ooo_drain(tcb);
+			
+			/* RFC 5681 4.2: Acknowledge immediately, when a gap is being filled. */
+			if( had_ooo ) tcb->flags |= NETTCP_TF_ACKNOW;
+			else nettcp_delack(tcb);
+		}else{
+			/* RFC 5681 4.2: An out-of-order segment is acknowledged immediately. */
+			if( seg.len <= NETTCP_RCV_SPACE(tcb) ){
+				nettcp_ooo_insert(tcb,pkt,seg.seq);
+				pkt = 0;
+			}
+			tcb->flags |= NETTCP_TF_ACKNOW;
+		}
+	}
+	
+	/* Eighth, check the FIN bit; an out-of-order FIN is sent again by the peer. */
+	if( (seg.flags & FNET_TCP_SGT_FIN) && (fin_seq == tcb->rcv_nxt) && !(tcb->flags & NETTCP_TF_RCVDFIN) ){
+		tcb->rcv_nxt++;
+		tcb->flags |= NETTCP_TF_RCVDFIN|NETTCP_TF_ACKNOW;
+		switch(tcb->state){
+		case NETTCP_ESTABLISHED:
+			tcb->state = NETTCP_CLOSE_WAIT;
+			break;
+		case NETTCP_FIN_WAIT_1:
+			if(! finacked ){
+				tcb->state = NETTCP_CLOSING;
+				break;
+			}
+			/* fall through */
+		case NETTCP_FIN_WAIT_2:
+			tcb->state      = NETTCP_TIME_WAIT;
+			tcb->tw_time    = net_timer_ms() + 2u*NETTCP_MSL_MS;
+			tcb->rexmt_time = 0;
+			break;
+		}
+	}
+	
+	nettcp_output(tcb);
+UNLOCK:
+	net_mutex_unlock(tcb->lock);
+	if( established && tcb->parent ) nettcp_accept_enqueue(tcb->parent,tcb);
+	if( pkt ) netpkt_free(pkt);
+	netsock_decr_flow(nif->sockets,flow);
+	return;
+UNLOCK_RST:
+	net_mutex_unlock(tcb->lock);
+	netsock_decr_flow(nif->sockets,flow);
+	
+	/* Back to the TCP header. */
+	if( netpkt_switchlevel(pkt,-1) ) goto DROP_PKT;
+	nettcp_sendrst(nif,src_addr,dst_addr,pkt);
+	return;
+UNLOCK_SYNACK:
+	net_mutex_unlock(tcb->lock);
+	netsock_decr_flow(nif->sockets,flow);
+	
+	if( netpkt_switchlevel(pkt,-1) ) goto DROP_PKT;
+	nettcp_sendsynack(nif,src_addr,dst_addr,pkt,cookie,window);
+	return;
+UNLOCK_COOKIE:
+	net_mutex_unlock(tcb->lock);
+	nettcp_accept_enqueue(tcb,child);
 	netsock_decr_flow(nif->sockets,flow);
+	
+	/*
+	 * The segment may carry data: It is processed again, on the new
+	 * connection, with the reference from nettcp_cookie_input().
+	 */
+	if( netpkt_switchlevel(pkt,-1) ){
+		nettcp_tcb_release(child);
+		goto DROP_PKT;
+	}
+	nettcp_input(nif,pkt,&(child->flow),src_addr,dst_addr);
+	return;
+DROP:
+	netsock_decr_flow(nif->sockets,flow);
+DROP_PKT:
 	netpkt_free(pkt);
 }
-
-
@@ -0,0 +1,336 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/output.h>
+#include <nettcp/tcp_header.h>
+#include <nettcp/if.h>
+#include <netipv4/ipv4_header.h>
+#include <netipv6/ipv6_header.h>
+#include <netprot/output.h>
+#include <netprot/checksum.h>
+#include <netprot/defaults.h>
+#include <netmem/allocpkt.h>
+#include <netstd/endianness.h>
+
+uint16_t nettcp_mss(netif_t *nif, uint8_t type){
+	uint32_t hlen;
+	
+	hlen = sizeof(fnet_tcp_header_t);
+	hlen += (type == NET_SKA_IN6) ? sizeof(fnet_ip6_header_t) : sizeof(fnet_ip_header_t);
+	
+	if( nif->netif_mtu <= (hlen + FNET_TCP_DEFAULT_MSS) ) return FNET_TCP_DEFAULT_MSS;
+	if( (nif->netif_mtu - hlen) > 0xffffu ) return 0xffffu;
+	return (uint16_t)(nif->netif_mtu - hlen);
+}
+
+uint16_t nettcp_checksum(netpkt_t *pkt, uint32_t length, const net_sockaddr_t *src_addr, const net_sockaddr_t *dst_addr){
+	uint16_t sum;
+	
+	sum = netprot_checksum_pseudo_start(pkt,IP_PROTOCOL_TCP,length);
+	if( src_addr->type == NET_SKA_IN6 )
+		return netprot_checksum_pseudo_end( sum, (const uint8_t*)&(src_addr->ip.v6), (uint8_t*)&(dst_addr->ip.v6), sizeof(ipv6_addr_t));
+	return netprot_checksum_pseudo_end( sum, (const uint8_t*)&(src_addr->ip.v4), (uint8_t*)&(dst_addr->ip.v4), sizeof(ipv4_addr_t));
+}
+
+/*
+ * Copies 'len' bytes, starting 'off' bytes after snd_una, from the send buffer.
+ */
+static int nettcp_sndbuf_copy(nettcp_tcb_t *tcb, uint32_t off, uint8_t *dst, uint32_t len){
+	netpkt_t *pkt;
+	uint32_t plen, n;
+	
+	for(pkt = tcb->snd_head ; pkt && len ; pkt = pkt->next_chain){
+		plen = NETPKT_LENGTH(pkt);
+		if( off >= plen ){
+			off -= plen;
+			continue;
+		}
+		n = plen - off;
+		if( n > len ) n = len;
+		if( netpkt_copyout(pkt,off,dst,n) ) return -1;
+		dst += n;
+		len -= n;
+		off  = 0;
+	}
+	return len ? -1 : 0;
+}
+
+/*
+ * Computes the value of the Window field and advances rcv_adv.
+ */
+static uint16_t nettcp_rcv_window(nettcp_tcb_t *tcb, int syn){
+	uint32_t space, scale, win;
+	
+	space = NETTCP_RCV_SPACE(tcb);
+	
+	/*
+	 * RFC 1122 4.2.3.3: Receiver SWS avoidance; don't advertise small
+	 * windows.
+	 */
+	if( (space < (tcb->rcv_max_len/4)) && (space < tcb->snd_mss) ) space = 0;
+	
+	/* RFC 7323 2.4: The window must not be shrunk. */
+	if( NETTCP_SEQ_GT(tcb->rcv_adv,tcb->rcv_nxt) && (space < (tcb->rcv_adv - tcb->rcv_nxt)) )
+		space = tcb->rcv_adv - tcb->rcv_nxt;
+	
+	/* RFC 7323 2.2: The window field in a SYN segment is never scaled. */
+	scale = syn ? 0 : tcb->rcv_scale;
+	win = space >> scale;
+	if( win > 0xffffu ) win = 0xffffu;
+	
+	if( NETTCP_SEQ_GT(tcb->rcv_nxt + (win << scale),tcb->rcv_adv) )
+		tcb->rcv_adv = tcb->rcv_nxt + (win << scale);
+	return (uint16_t)win;
+}
+
+/*
+ * Builds and sends a segment, with 'len' bytes of data from the send buffer,
+ * starting 'off' bytes after snd_una.
+ */
+static void nettcp_send_segment(nettcp_tcb_t *tcb, uint32_t seq, uint8_t flags, uint32_t off, uint32_t len){
+	fnet_tcp_header_t  *hdr;
+	netpkt_t           *pkt;
+	uint8_t            *opt;
+	net_sockaddr_t     src_addr, dst_addr;
+	uint32_t           hlen;
+	uint16_t           mss;
+	int                wscale;
+	
+	/* RFC 7323 1.3: The Window Scale option is only sent in reply, if received. */
+	wscale = (tcb->state == NETTCP_SYN_SENT) || (tcb->flags & NETTCP_TF_WSCALE);
+	
+	hlen = sizeof(fnet_tcp_header_t);
+	if( flags & FNET_TCP_SGT_SYN ){
+		hlen += FNET_TCP_OPT_MSS_LEN;
+		if( wscale ) hlen += FNET_TCP_OPT_WS_LEN+1;
+	}
+	
+	if(! (pkt = netmem_alloc_pkt(len)) ) return;
+	
+	if( len && nettcp_sndbuf_copy(tcb,off,netpkt_data(pkt),len) ) goto DROP;
+	
+	if( netpkt_leveldown(pkt) ) goto DROP;
+	
+	if( netpkt_pushfront( pkt, hlen ) ) goto DROP;
+	
+	if( netpkt_pullup_lite( pkt, hlen ) ) goto DROP;
+	
+	hdr = netpkt_data(pkt);
+	hdr->source_port      = tcb->flow.local_a.port;
+	hdr->destination_port = tcb->flow.remote_a.port;
+	hdr->sequence         = hton32(seq);
+	hdr->ack_number       = (flags & FNET_TCP_SGT_ACK) ? hton32(tcb->rcv_nxt) : 0;
+	FNET_TCP_SET_HDR_LENGTH(hdr,hlen);
+	hdr->flags            = flags;
+	hdr->window           = hton16(nettcp_rcv_window(tcb,flags & FNET_TCP_SGT_SYN));
+	hdr->checksum         = 0;
+	hdr->urgent_ptr       = 0;
+	
+	if( flags & FNET_TCP_SGT_SYN ){
+		opt = (uint8_t*)(hdr+1);
+		mss = nettcp_mss(tcb->nif,tcb->flow.local_a.type);
+		opt[0] = FNET_TCP_OPT_MSS;
+		opt[1] = FNET_TCP_OPT_MSS_LEN;
+		opt[2] = (uint8_t)(mss >> 8);
+		opt[3] = (uint8_t)mss;
+		if( wscale ){
+			opt[4] = FNET_TCP_OPT_NOP;
+			opt[5] = FNET_TCP_OPT_WS;
+			opt[6] = FNET_TCP_OPT_WS_LEN;
+			opt[7] = tcb->rcv_scale;
+		}
+	}
+	
+	src_addr = tcb->flow.local_a;
+	dst_addr = tcb->flow.remote_a;
+	hdr->checksum = nettcp_checksum(pkt,NETPKT_LENGTH(pkt),&src_addr,&dst_addr);
+	
+	/* The segment carries the ACK, that might have been pending. */
+	if( flags & FNET_TCP_SGT_ACK )
+		tcb->flags &= ~(NETTCP_TF_ACKNOW|NETTCP_TF_DELACK);
+	
+	netprot_ip_output(tcb->nif,pkt,IP_PROTOCOL_TCP,&src_addr,&dst_addr,0,&(tcb->opts));
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
+void nettcp_output(nettcp_tcb_t *tcb){
+	uint32_t   off, win, flight, len, syn, seq, rate;
+	net_time_t now_us;
+	uint8_t    flags;
+	int        send;
+	
+	rate = tcb->cc->pacing_rate ? tcb->cc->pacing_rate(tcb) : 0;
+	tcb->flags &= ~NETTCP_TF_PACED;
+	
+	for(;;){
+		switch(tcb->state){
+		case NETTCP_SYN_SENT:
+			flags = FNET_TCP_SGT_SYN;
+			break;
+		case NETTCP_SYN_RCVD:
+			flags = FNET_TCP_SGT_SYN|FNET_TCP_SGT_ACK;
+			break;
+		case NETTCP_CLOSED:
+		case NETTCP_LISTEN:
+			return;
+		default:
+			flags = FNET_TCP_SGT_ACK;
+		}
+		
+		/*
+		 * The SYN is (re)sent, when snd_nxt is at the ISS. No data is sent
+		 * before the connection is established.
+		 */
+		syn = (tcb->snd_una == tcb->iss) && (flags & FNET_TCP_SGT_SYN);
+		if( (flags & FNET_TCP_SGT_SYN) && (tcb->snd_nxt != tcb->iss) ){
+			flags &= ~FNET_TCP_SGT_SYN;
+			if(! flags ) return;
+		}
+		
+		off    = tcb->snd_nxt - tcb->snd_una - syn;
+		flight = tcb->snd_nxt - tcb->snd_una;
+		win    = tcb->snd_wnd < tcb->cwnd ? tcb->snd_wnd : tcb->cwnd;
+		
+		/* Window probe (RFC 1122 4.2.2.17). */
+		if( (tcb->flags & NETTCP_TF_FORCE) && (win == 0) ) win = 1;
+		
+		len = 0;
+		if( (tcb->state >= NETTCP_ESTABLISHED) && (tcb->snd_len > off) ){
+			len = tcb->snd_len - off;
+			if( win <= flight ) len = 0;
+			else if( len > (win - flight) ) len = win - flight;
+			if( len > tcb->snd_mss ) len = tcb->snd_mss;
+		}
+		
+		/* Pacing: The data waits, until it is due; nettcp_timer() resumes it. */
+		if( len && rate ){
+			now_us = net_timer_ms()*1000u;
+			if( tcb->pace_next > (now_us + NETTCP_PACE_QUANTUM_US) ){
+				tcb->flags |= NETTCP_TF_PACED;
+				len = 0;
+			}
+		}
+		
+		/*
+		 * The FIN follows the last byte of data, once the user has closed the
+		 * connection. It is sent again, when the sequence space is rewound.
+		 */
+		if( (tcb->flags & NETTCP_TF_SNDFIN) && ((off + len) == tcb->snd_len)
+			&& ( (tcb->state == NETTCP_FIN_WAIT_1) || (tcb->state == NETTCP_CLOSING) || (tcb->state == NETTCP_LAST_ACK) ) )
+		{
+			if( (!(tcb->flags & NETTCP_TF_SENTFIN)) || (tcb->snd_nxt + len == tcb->snd_fin) )
+				flags |= FNET_TCP_SGT_FIN;
+		}
+		
+		send = 0;
+		if( flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_FIN) ) send = 1;
+		if( tcb->flags & NETTCP_TF_ACKNOW ) send = 1;
+		if( len ){
+			/*
+			 * RFC 1122 4.2.3.4: The Nagle algorithm; a short segment is only
+			 * sent, if no data is outstanding, or with TCP_NODELAY.
+			 */
+			if( len == tcb->snd_mss ) send = 1;
+			else if( ((off + len) == tcb->snd_len) && ((tcb->flags & NETTCP_TF_NODELAY) || (tcb->snd_una == tcb->snd_max)) ) send = 1;
+			if( tcb->flags & NETTCP_TF_FORCE ) send = 1;
+			if( NETTCP_SEQ_LT(tcb->snd_nxt,tcb->snd_max) ) send = 1; /* Retransmission. */
+		}
+		
+		/*
+		 * RFC 1122 4.2.3.3: Send a window update, when the window has been
+		 * opened by two segments or by half of the buffer.
+		 */
+		if( (tcb->state >= NETTCP_ESTABLISHED) && !(tcb->flags & NETTCP_TF_RCVDFIN) ){
+			win = NETTCP_RCV_SPACE(tcb);
+			win = NETTCP_SEQ_GT(tcb->rcv_nxt + win,tcb->rcv_adv) ? (tcb->rcv_nxt + win - tcb->rcv_adv) : 0;
+			if( (win >= 2u*tcb->snd_mss) || (win >= tcb->rcv_max_len/2) ) send = 1;
+		}
+		
+		if(! send ) break;
+		
+		seq = tcb->snd_nxt;
+		nettcp_send_segment(tcb,seq,flags|((len && ((off+len) == tcb->snd_len)) ? FNET_TCP_SGT_PSH : 0),off,len);
+		
+		if( flags & FNET_TCP_SGT_FIN ){
+			if(! (tcb->flags & NETTCP_TF_SENTFIN) ) tcb->snd_fin = seq + len;
+			tcb->flags |= NETTCP_TF_SENTFIN;
+		}
+		
+		tcb->snd_nxt += len;
+		if( flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_FIN) ) tcb->snd_nxt++;
+		
+		if( len && rate ){
+			if( tcb->pace_next < now_us ) tcb->pace_next = now_us;
+			tcb->pace_next += ((net_time_t)len * 1000000u) / rate;
+		}
+		
+		if( NETTCP_SEQ_GT(tcb->snd_nxt,tcb->snd_max) ){
+			/* RFC 6298 3: Time one segment at a time; never a retransmission (Karn). */
+			if(! tcb->rtt_active ){
+				tcb->rtt_active = 1;
+				tcb->rtt_seq    = seq;
+				tcb->rtt_time   = net_timer_ms();
+			}
+			tcb->snd_max = tcb->snd_nxt;
+		}
+		
+		/* RFC 6298 5.1: Start the timer, if it is not running. */
+		if( (tcb->snd_nxt != tcb->snd_una) && !(tcb->rexmt_time) )
+			tcb->rexmt_time = net_timer_ms() + tcb->rto;
+		
+		tcb->flags &= ~NETTCP_TF_FORCE;
+		
+		if(! (len || (flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_FIN))) ) break;
+		if( flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_FIN) ) break;
+	}
+	
+	/* Persist timer: Data is waiting for a zero window, and nothing is in flight. */
+	if( (tcb->snd_wnd == 0) && (tcb->snd_len > 0) && (tcb->snd_una == tcb->snd_max) && !(tcb->rexmt_time) )
+		tcb->rexmt_time = net_timer_ms() + tcb->rto;
+}
+
+void nettcp_retransmit(nettcp_tcb_t *tcb){
+	uint32_t len;
+	uint8_t  flags;
+	
+	if( tcb->snd_una == tcb->snd_max ) return;
+	
+	flags = FNET_TCP_SGT_ACK;
+	len   = tcb->snd_len < tcb->snd_mss ? tcb->snd_len : tcb->snd_mss;
+	if( (tcb->flags & NETTCP_TF_SENTFIN) && (tcb->snd_una + len == tcb->snd_fin) )
+		flags |= FNET_TCP_SGT_FIN;
+	if( !len && !(flags & FNET_TCP_SGT_FIN) ) return;
+	
+	/* RFC 6298 3: A retransmitted segment must not be timed (Karn). */
+	tcb->rtt_active = 0;
+	
+	nettcp_send_segment(tcb,tcb->snd_una,flags,0,len);
+}
+
+void nettcp_output_rst(nettcp_tcb_t *tcb){
+	switch(tcb->state){
+	case NETTCP_SYN_RCVD:
+	case NETTCP_ESTABLISHED:
+	case NETTCP_FIN_WAIT_1:
+	case NETTCP_FIN_WAIT_2:
+	case NETTCP_CLOSE_WAIT:
+		/* RFC 793 3.9: <SEQ=SND.NXT><CTL=RST> */
+		nettcp_send_segment(tcb,tcb->snd_nxt,FNET_TCP_SGT_RST,0,0);
+		break;
+	}
+}
@@ -0,0 +1,210 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/socket.h>
+#include <nettcp/if.h>
+#include <nettcp/output.h>
+#include <netsock/hashtab.h>
+#include <netipv4/defs.h>
+#include <netipv4/fib.h>
+#include <netipv4/ctrl.h>
+#include <netipv6/defs.h>
+#include <netipv6/srcsel.h>
+#include <netprot/defaults.h>
+#include <netstd/atomic.h>
+#include <netstd/random.h>
+#include <netstd/endianness.h>
+#include <netstd/mem.h>
+
+/* RFC 6335 6: The Dynamic Ports. */
+#define NETTCP_EPHEMERAL_MIN  49152u
+#define NETTCP_EPHEMERAL_MAX  65535u
+#define NETTCP_EPHEMERAL_TRY  64
+
+/*
+ * Selects the local address for a connection to 'remote_a'.
+ * Returns 0 on success, non-0 otherwise.
+ */
+static int nettcp_select_src(netif_t *nif, net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, const netprot_opts_t *opts){
+	ipv4_addr_t nexthop;
+	
+	local_a->type = remote_a->type;
+	switch(remote_a->type){
+	case NET_SKA_IN:
+		if(! IP4_ADDR_IS_UNSPECIFIED(local_a->ip.v4) ) return 0;
+		if( netipv4_route(&nif,remote_a->ip.v4,&nexthop,opts->dont_route) ) return -1;
+		local_a->ip.v4 = netipv4_select_src_addr(nif,remote_a->ip.v4);
+		return IP4_ADDR_IS_UNSPECIFIED(local_a->ip.v4) ? -1 : 0;
+	case NET_SKA_IN6:
+		if(! IP6_ADDR_IS_UNSPECIFIED(local_a->ip.v6) ) return 0;
+		return netipv6_select_src_addr(nif,&(local_a->ip.v6),&(remote_a->ip.v6)) ? 0 : -1;
+	}
+	return -1;
+}
+
+/*
+ * RFC 6056 3.3.1: Chooses a random ephemeral port, that is not in use for
+ * this pair of addresses.
+ * Returns 0 on success, non-0 otherwise.
+ */
+static int nettcp_select_port(netif_t *nif, net_sockaddr_t *local_a, const net_sockaddr_t *remote_a){
+	netsock_flow_t *flow;
+	int i;
+	
+	for( i = 0 ; i < NETTCP_EPHEMERAL_TRY ; ++i ){
+		local_a->port = hton16( (uint16_t)(NETTCP_EPHEMERAL_MIN + (net_random_u32() % (NETTCP_EPHEMERAL_MAX - NETTCP_EPHEMERAL_MIN + 1))) );
+		flow = netsock_lookup_flow(nif->sockets,IP_PROTOCOL_TCP,remote_a,local_a);
+		if(! flow ) return 0;
+		netsock_decr_flow(nif->sockets,flow);
+	}
+	return -1;
+}
+
+nettcp_tcb_t* nettcp_listen(netif_t *nif, const net_sockaddr_t *local_a, uint32_t backlog, int reuseport){
+	nettcp_tcb_t *tcb;
+	
+	if( (! nif->tcp) || (! nif->sockets) ) return 0;
+	if(! (tcb = nettcp_tcb_new(nif)) ) return 0;
+	
+	tcb->acceptq = net_malloc(sizeof(nettcp_acceptq_t));
+	if(! tcb->acceptq ){
+		tcb->flow.freeflow(&(tcb->flow));
+		return 0;
+	}
+	nettcp_acceptq_init(tcb->acceptq);
+	
+	tcb->flow.local_a = *local_a;
+	if( reuseport ) tcb->flow.flags |= NETSOCK_FLOW_REUSEPORT;
+	tcb->syn_backlog  = backlog ? backlog : NETTCP_SYN_BACKLOG;
+	tcb->state = NETTCP_LISTEN;
+	
+	/* One reference for the hashtable, one for the caller. */
+	nettcp_tcb_attach(tcb,1);
+	netsock_incr_flow(nif->sockets,&(tcb->flow));
+	return tcb;
+}
+
+nettcp_tcb_t* nettcp_connect(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, const netprot_opts_t *opts){
+	nettcp_tcb_t *tcb;
+	
+	if( (! nif->tcp) || (! nif->sockets) ) return 0;
+	if(! (tcb = nettcp_tcb_new(nif)) ) return 0;
+	
+	tcb->opts = *opts;
+	tcb->flow.local_a  = *local_a;
+	tcb->flow.remote_a = *remote_a;
+	if( nettcp_select_src(nif,&(tcb->flow.local_a),remote_a,opts) ) goto ERROR;
+	if( (! tcb->flow.local_a.port) && nettcp_select_port(nif,&(tcb->flow.local_a),remote_a) ) goto ERROR;
+	
+	tcb->iss       = nettcp_iss(nif,&(tcb->flow.local_a),remote_a);
+	tcb->snd_una   = tcb->iss;
+	tcb->snd_nxt   = tcb->iss;
+	tcb->snd_max   = tcb->iss;
+	tcb->recover   = tcb->iss;
+	tcb->rcv_scale = nettcp_rcv_wscale(tcb->rcv_max_len);
+	tcb->state     = NETTCP_SYN_SENT;
+	
+	/* One reference for the hashtable, one for the caller. */
+	net_mutex_lock(tcb->lock);
+	nettcp_tcb_attach(tcb,0);
+	netsock_incr_flow(nif->sockets,&(tcb->flow));
+	nettcp_output(tcb);
+	net_mutex_unlock(tcb->lock);
+	
+	net_atomic_fetch_add(&(nif->tcp->active_opens),1);
+	return tcb;
+ERROR:
+	/* Not registered; the reference count is 0. */
+	tcb->flow.freeflow(&(tcb->flow));
+	return 0;
+}
+
+nettcp_tcb_t* nettcp_accept(nettcp_tcb_t *listener){
+	/* The queue's reference is passed to the caller. */
+	return listener->acceptq ? nettcp_acceptq_dequeue(listener->acceptq) : 0;
+}
+
+int nettcp_send(nettcp_tcb_t *tcb, netpkt_t *pkt){
+	uint32_t len = NETPKT_LENGTH(pkt);
+	
+	net_mutex_lock(tcb->lock);
+	if( (! NETTCP_CAN_SND_DATA(tcb->state)) || (tcb->flags & NETTCP_TF_SNDFIN) ) goto ERROR;
+	if( (tcb->snd_len + len) > tcb->snd_max_len ) goto ERROR;
+	
+	pkt->next_chain = 0;
+	if( tcb->snd_tail )
+		tcb->snd_tail->next_chain = pkt;
+	else
+		tcb->snd_head = pkt;
+	tcb->snd_tail = pkt;
+	tcb->snd_len += len;
+	
+	nettcp_output(tcb);
+	net_mutex_unlock(tcb->lock);
+	return 0;
+ERROR:
+	net_mutex_unlock(tcb->lock);
+	return -1;
+}
+
+netpkt_t* nettcp_recv(nettcp_tcb_t *tcb){
+	netpkt_t *pkt;
+	
+	net_mutex_lock(tcb->lock);
+	pkt = tcb->rcv_head;
+	if( pkt ){
+		tcb->rcv_head = pkt->next_chain;
+		if(! tcb->rcv_head ) tcb->rcv_tail = 0;
+		tcb->rcv_len -= NETPKT_LENGTH(pkt);
+		pkt->next_chain = 0;
+		
+		/* Send a window update, if the window has opened enough. */
+		nettcp_output(tcb);
+	}
+	net_mutex_unlock(tcb->lock);
+	return pkt;
+}
+
+void nettcp_close(nettcp_tcb_t *tcb){
+	net_mutex_lock(tcb->lock);
+	switch(tcb->state){
+	case NETTCP_LISTEN:
+	case NETTCP_SYN_SENT:
+		nettcp_tcb_close(tcb,NETTCP_ERR_NONE);
+		break;
+	case NETTCP_SYN_RCVD:
+	case NETTCP_ESTABLISHED:
+		tcb->state  = NETTCP_FIN_WAIT_1;
+		tcb->flags |= NETTCP_TF_SNDFIN;
+		nettcp_output(tcb);
+		break;
+	case NETTCP_CLOSE_WAIT:
+		tcb->state  = NETTCP_LAST_ACK;
+		tcb->flags |= NETTCP_TF_SNDFIN;
+		nettcp_output(tcb);
+		break;
+	}
+	net_mutex_unlock(tcb->lock);
+	nettcp_tcb_release(tcb);
+}
+
+void nettcp_abort(nettcp_tcb_t *tcb){
+	net_mutex_lock(tcb->lock);
+	nettcp_output_rst(tcb);
+	nettcp_tcb_close(tcb,NETTCP_ERR_ABORTED);
+	net_mutex_unlock(tcb->lock);
+	nettcp_tcb_release(tcb);
+}
@@ -0,0 +1,145 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/syncookie.h>
+#include <nettcp/if.h>
+#include <nettcp/tcb.h>
+#include <netstd/time.h>
+#include <netstd/mem.h>
+#include <netstd/siphash.h>
+#include <netstd/seqlock.h>
+#include <netstd/random.h>
+
+/*
+ * The MSS values, a cookie can encode; common values, in ascending order.
+ */
+static const uint16_t nettcp_cookie_mss[8] = { 536, 1024, 1220, 1360, 1400, 1440, 1460, 8960 };
+
+/*
+ * Cookie layout (RFC 4987 3.6):
+ *   bits 31-27: time counter (mod 32)
+ *   bits 26-24: MSS index
+ *   bits 23-0:  hash
+ */
+#define COOKIE_T_SHIFT    27
+#define COOKIE_MSS_SHIFT  24
+#define COOKIE_HASH_MASK  0x00ffffffu
+
+/* The full time counter; the cookie carries it mod 32. */
+static inline uint32_t nettcp_cookie_now(void){
+	return (uint32_t)(net_timer_ms() / NETTCP_COOKIE_PERIOD_MS);
+}
+
+static void nettcp_cookie_newkey(nettcp_if_t *tif, uint32_t t){
+	uint32_t i;
+	for(i = 0 ; i < 4 ; ++i)
+		tif->cookie_key[t&1][i] = net_random_u32();
+}
+
+void nettcp_syncookie_init(nettcp_if_t *tif){
+	tif->cookie_t   = nettcp_cookie_now();
+	tif->cookie_seq = 0;
+	nettcp_cookie_newkey(tif,tif->cookie_t);
+	nettcp_cookie_newkey(tif,tif->cookie_t-1);
+}
+
+/*
+ * Replaces the keys, if a new period has begun. If more than one period has
+ * passed, the previous key is replaced as well, so that it is not accepted
+ * any longer.
+ */
+static void nettcp_cookie_rotate(nettcp_if_t *tif){
+	uint32_t now = nettcp_cookie_now();
+	
+	if( tif->cookie_t == now ) return;
+	
+	net_mutex_lock(tif->lock);
+	if( (int32_t)(now - tif->cookie_t) > 0 ){
+		net_seq_write_begin(&(tif->cookie_seq));
+		if( (now - tif->cookie_t) > 1 ) nettcp_cookie_newkey(tif,now-1);
+		nettcp_cookie_newkey(tif,now);
+		tif->cookie_t = now;
+		net_seq_write_end(&(tif->cookie_seq));
+	}
+	net_mutex_unlock(tif->lock);
+}
+
+/*
+ * Computes the hash of a cookie with the time counter 't' (mod 32). Returns 0
+ * on success, non-0, if 't' belongs neither to the current period nor to the
+ * previous one.
+ */
+static int nettcp_cookie_hash(nettcp_if_t *tif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, uint32_t irs, uint32_t t, uint32_t idx, uint32_t *hash){
+	uint32_t key[4];
+	uint8_t  msg[NETTCP_TUPLE_MAX+8];
+	uint32_t seq, cur, len;
+	
+	do{
+		seq = net_seq_read_begin(&(tif->cookie_seq));
+		cur = tif->cookie_t;
+		if( t == ((cur-1) & 0x1f) ) cur--;
+		else if( t != (cur & 0x1f) ) cur = ~0u;
+		if( cur != ~0u ) memcpy(key,tif->cookie_key[cur&1],sizeof(key));
+	}while( net_seq_read_retry(&(tif->cookie_seq),seq) );
+	
+	if( cur == ~0u ) return -1;
+	
+	len = nettcp_tuple(msg,local_a,remote_a);
+	memcpy(msg+len,&irs,sizeof(irs));
+	memcpy(msg+len+4,&idx,sizeof(idx));
+	
+	*hash = (uint32_t)net_siphash(key,msg,len+8) & COOKIE_HASH_MASK;
+	return 0;
+}
+
+uint32_t nettcp_syncookie_make(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, uint32_t irs, uint16_t *mss){
+	nettcp_if_t *tif = nif->tcp;
+	uint32_t t, idx, hash;
+	
+	for( idx = 7 ; idx && (nettcp_cookie_mss[idx] > *mss) ; idx-- );
+	*mss = nettcp_cookie_mss[idx];
+	
+	nettcp_cookie_rotate(tif);
+	
+	/*
+	 * The key of the current period. If the keys are rotated in the meantime,
+	 * it is the previous period's one, which is still valid. (Only if the
+	 * keys are rotated twice, the hash is left 0; the cookie fails the check.)
+	 */
+	t = tif->cookie_t & 0x1f;
+	if( nettcp_cookie_hash(tif,local_a,remote_a,irs,t,idx,&hash) ) hash = 0;
+	
+	return (t << COOKIE_T_SHIFT) | (idx << COOKIE_MSS_SHIFT) | hash;
+}
+
+int nettcp_syncookie_check(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a, uint32_t irs, uint32_t cookie, uint16_t *mss){
+	nettcp_if_t *tif = nif->tcp;
+	uint32_t t, idx, hash;
+	
+	t   = cookie >> COOKIE_T_SHIFT;
+	idx = (cookie >> COOKIE_MSS_SHIFT) & 7;
+	
+	/* Rotate first, so that the keys of expired periods are not used. */
+	nettcp_cookie_rotate(tif);
+	
+	/* Only cookies from the current and the previous period are accepted. */
+	if( nettcp_cookie_hash(tif,local_a,remote_a,irs,t,idx,&hash) ) return -1;
+	
+	if( (cookie & COOKIE_HASH_MASK) != hash ) return -1;
+	
+	*mss = nettcp_cookie_mss[idx];
+	return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/tcb.h>
+#include <nettcp/if.h>
+#include <nettcp/tcp_header.h>
+#include <nettcp/output.h>
+#include <nettcp/syncookie.h>
+#include <netsock/hashtab.h>
+#include <netprot/defaults.h>
+#include <netstd/mem.h>
+#include <netstd/random.h>
+#include <netstd/atomic.h>
+#include <netstd/siphash.h>
+
+int nettcp_if_init(nettcp_if_t *tif){
+	uint32_t i;
+	
+	tif->tcbs = 0;
+	for(i = 0 ; i < 4 ; ++i)
+		tif->key[i] = net_random_u32();
+	nettcp_syncookie_init(tif);
+	tif->active_opens  = 0;
+	tif->passive_opens = 0;
+	tif->resets        = 0;
+	tif->retransmits   = 0;
+	tif->fastpath      = 0;
+	tif->rst_sent      = 0;
+	tif->rst_limited   = 0;
+	tif->rst_tokens    = NETTCP_RST_BURST;
+	tif->rst_stamp     = net_timer_ms();
+	return 0;
+}
+
+static void nettcp_tcb_freeflow(netsock_flow_t *flow){
+	nettcp_tcb_t *tcb = flow->instance;
+	
+	netpkt_free_all(tcb->snd_head);
+	netpkt_free_all(tcb->rcv_head);
+	netpkt_free_all(tcb->ooo_head);
+	
+	if( tcb->parent ) nettcp_tcb_release(tcb->parent);
+	if( tcb->acceptq ) net_free(tcb->acceptq);
+	
+	net_mutex_free(tcb->lock);
+	net_free(tcb);
+}
+
+nettcp_tcb_t* nettcp_tcb_new(netif_t *nif){
+	nettcp_tcb_t *tcb;
+	
+	tcb = net_malloc(sizeof(nettcp_tcb_t));
+	if(! tcb ) return 0;
+	net_bzero(tcb,sizeof(nettcp_tcb_t));
+	
+	tcb->lock = net_mutex_new();
+	if(! tcb->lock ){
+		net_free(tcb);
+		return 0;
+	}
+	
+	tcb->flow.protocol = IP_PROTOCOL_TCP;
+	tcb->flow.instance = tcb;
+	tcb->flow.freeflow = nettcp_tcb_freeflow;
+	
+	tcb->nif         = nif;
+	tcb->cc          = &nettcp_cc_newreno;
+	tcb->opts.ttl    = IP_TTL_DEFAULT;
+	tcb->state       = NETTCP_CLOSED;
+	tcb->snd_mss     = FNET_TCP_DEFAULT_MSS;
+	tcb->snd_max_len = NETTCP_SNDBUF_DEFAULT;
+	tcb->rcv_max_len = NETTCP_RCVBUF_DEFAULT;
+	tcb->rto         = NETTCP_RTO_INITIAL;
+	return tcb;
+}
+
+void nettcp_tcb_attach(nettcp_tcb_t *tcb, int listen){
+	nettcp_if_t *tif = tcb->nif->tcp;
+	
+	if( listen )
+		netsock_add_flow_port(tcb->nif->sockets,&(tcb->flow));
+	else
+		netsock_add_flow(tcb->nif->sockets,&(tcb->flow));
+	
+	net_mutex_lock(tif->lock);
+	tcb->tnext = tif->tcbs;
+	tcb->tprev = &(tif->tcbs);
+	if( tif->tcbs ) tif->tcbs->tprev = &(tcb->tnext);
+	tif->tcbs = tcb;
+	net_mutex_unlock(tif->lock);
+}
+
+void nettcp_tcb_close(nettcp_tcb_t *tcb, uint8_t error){
+	nettcp_if_t  *tif = tcb->nif->tcp;
+	
+	if( tcb->state == NETTCP_CLOSED ) return;
+	
+	if( tcb->flags & NETTCP_TF_SYNQ ) nettcp_synq_leave(tcb);
+	
+	if( tcb->state == NETTCP_LISTEN ){
+		/*
+		 * A closing listener aborts the connections, that have not been
+		 * accepted yet. A connection, that is enqueued concurrently, is
+		 * aborted by the receive path, once it sees the new state.
+		 */
+		tcb->state = NETTCP_CLOSED;
+		net_memory_barrier();
+		nettcp_listen_drain(tcb);
+	}
+	
+	tcb->state = NETTCP_CLOSED;
+	if(! tcb->error ) tcb->error = error;
+	
+	/*
+	 * RFC 793 3.9: On a reset, all segment queues should be flushed. After an
+	 * orderly close, the data, that has not been read yet, is kept.
+	 */
+	netpkt_free_all(tcb->snd_head);
+	netpkt_free_all(tcb->ooo_head);
+	tcb->snd_head = tcb->snd_tail = 0;
+	tcb->ooo_head = 0;
+	tcb->snd_len  = 0;
+	tcb->ooo_len  = 0;
+	if( error != NETTCP_ERR_NONE ){
+		netpkt_free_all(tcb->rcv_head);
+		tcb->rcv_head = tcb->rcv_tail = 0;
+		tcb->rcv_len  = 0;
+	}
+	
+	tcb->rexmt_time  = 0;
+	tcb->delack_time = 0;
+	tcb->flags &= ~(NETTCP_TF_ACKNOW|NETTCP_TF_DELACK);
+	
+	if(! tcb->tprev ) return;
+	
+	net_mutex_lock(tif->lock);
+	if( tcb->tnext ) tcb->tnext->tprev = tcb->tprev;
+	*(tcb->tprev) = tcb->tnext;
+	net_mutex_unlock(tif->lock);
+	tcb->tprev = 0;
+	tcb->tnext = 0;
+	
+	/* Drops the hashtable's reference; the caller holds another one. */
+	netsock_remove_flow(tcb->nif->sockets,&(tcb->flow));
+}
+
+void nettcp_synq_leave(nettcp_tcb_t *tcb){
+	tcb->flags &= ~NETTCP_TF_SYNQ;
+	net_atomic_fetch_add(&(tcb->parent->syn_count),-1);
+}
+
+void nettcp_listen_drain(nettcp_tcb_t *lis){
+	nettcp_tcb_t *child;
+	
+	if(! lis->acceptq ) return;
+	while( (child = nettcp_acceptq_dequeue(lis->acceptq)) ){
+		net_mutex_lock(child->lock);
+		nettcp_output_rst(child);
+		nettcp_tcb_close(child,NETTCP_ERR_ABORTED);
+		net_mutex_unlock(child->lock);
+		nettcp_tcb_release(child);
+	}
+}
+
+void nettcp_tcb_release(nettcp_tcb_t *tcb){
+	netsock_decr_flow(tcb->nif->sockets,&(tcb->flow));
+}
+
+uint32_t nettcp_tuple(uint8_t *buf, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a){
+	uint32_t len;
+	
+	if( local_a->type == NET_SKA_IN6 ){
+		memcpy(buf,&(local_a->ip.v6),sizeof(ipv6_addr_t));
+		memcpy(buf+sizeof(ipv6_addr_t),&(remote_a->ip.v6),sizeof(ipv6_addr_t));
+		len = 2*sizeof(ipv6_addr_t);
+	}else{
+		memcpy(buf,&(local_a->ip.v4),sizeof(ipv4_addr_t));
+		memcpy(buf+sizeof(ipv4_addr_t),&(remote_a->ip.v4),sizeof(ipv4_addr_t));
+		len = 2*sizeof(ipv4_addr_t);
+	}
+	memcpy(buf+len,&(local_a->port),sizeof(uint16_t));
+	memcpy(buf+len+2,&(remote_a->port),sizeof(uint16_t));
+	return len+4;
+}
+
+/*
+ * RFC 6528 3: ISN = M + F(localip, localport, remoteip, remoteport, secretkey),
+ * where M is a timer, that is incremented every 4 microseconds, and F is a
+ * keyed hash function (SipHash).
+ */
+uint32_t nettcp_iss(netif_t *nif, const net_sockaddr_t *local_a, const net_sockaddr_t *remote_a){
+	nettcp_if_t *tif = nif->tcp;
+	uint8_t      tuple[NETTCP_TUPLE_MAX];
+	uint32_t     len, hash;
+	
+	len = nettcp_tuple(tuple,local_a,remote_a);
+	hash = (uint32_t)net_siphash(tif->key,tuple,len);
+	
+	return hash + (uint32_t)(net_timer_ms()*250);
+}
@@ -14,8 +14,190 @@
  *   limitations under the License.
  */
 #include <nettcp/response.h>
+#include <nettcp/if.h>
+#include <nettcp/tcp_header.h>
+#include <nettcp/output.h>
+#include <netipv4/defs.h>
+#include <netipv4/check.h>
+#include <netipv6/defs.h>
+#include <netprot/output.h>
+#include <netprot/defaults.h>
+#include <netstd/endianness.h>
+#include <netstd/atomic.h>
+
+/*
+ * Takes a token from the rate limiter's bucket, which is refilled with
+ * NETTCP_RST_RATE tokens per second. Lock-free; a lost race merely costs a
+ * token.
+ * Returns 0, if a RST may be sent, non-0 otherwise.
+ */
+static int nettcp_rst_ratelimit(nettcp_if_t *tif){
+	net_time_t now, stamp;
+	uint32_t add, tokens;
+	
+	now   = net_timer_ms();
+	stamp = tif->rst_stamp;
+	if( now > stamp ){
+		add = (now - stamp) >= 1000u ? NETTCP_RST_BURST : (uint32_t)(((now - stamp) * NETTCP_RST_RATE) / 1000u);
+		
+		/* Only the thread, that advances the stamp, refills the bucket. */
+		if( add && net_atomic_cas(&(tif->rst_stamp),stamp,now) ){
+			tokens = tif->rst_tokens;
+			while( tokens < NETTCP_RST_BURST ){
+				if( net_atomic_cas(&(tif->rst_tokens),tokens,(tokens + add) > NETTCP_RST_BURST ? NETTCP_RST_BURST : (tokens + add)) ) break;
+				tokens = tif->rst_tokens;
+			}
+		}
+	}
+	
+	for(;;){
+		tokens = tif->rst_tokens;
+		if(! tokens ) return -1;
+		if( net_atomic_cas(&(tif->rst_tokens),tokens,tokens-1) ) return 0;
+	}
+}
+
+/*
+ * Checks, whether a segment may be answered: RFC 793 3.4, an incoming RST is
+ * never answered; RFC 1122 4.2.3.10, no response to a segment, that was sent
+ * to a broadcast or multicast address, or from an address, that does not
+ * identify a single host; and no response to a corrupted segment.
+ * Returns 0, if it may be answered, non-0 otherwise.
+ */
+static int nettcp_response_check(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *pkt){
+	fnet_tcp_header_t  *hdr;
+	uint32_t           hlen;
+	
+	if( netpkt_pullup(pkt,sizeof(fnet_tcp_header_t)) ) return -1;
+	hdr  = netpkt_data(pkt);
+	hlen = FNET_TCP_HDR_LENGTH(hdr);
+	if( (hlen < sizeof(fnet_tcp_header_t)) || (hlen > NETPKT_LENGTH(pkt)) ) return -1;
+	
+	if( hdr->flags & FNET_TCP_SGT_RST ) return -1;
+	
+	if( pkt->flags & (NETPKT_FLAG_BROAD_L3|NETPKT_FLAG_BROAD_L2) ) return -1;
+	switch(src_addr->type){
+	case NET_SKA_IN:
+		if( IP4_ADDR_IS_MULTICAST(dst_addr->ip.v4) ) return -1;
+		if( IP4_ADDR_IS_UNSPECIFIED(src_addr->ip.v4) || IP4_ADDR_IS_MULTICAST(src_addr->ip.v4) ) return -1;
+		if( netipv4_addr_is_broadcast(nif,src_addr->ip.v4) ) return -1;
+		break;
+	case NET_SKA_IN6:
+		if( IP6_ADDR_IS_MULTICAST(dst_addr->ip.v6) ) return -1;
+		if( IP6_ADDR_IS_UNSPECIFIED(src_addr->ip.v6) || IP6_ADDR_IS_MULTICAST(src_addr->ip.v6) ) return -1;
+		break;
+	default: return -1;
+	}
+	
+	if(! (pkt->flags & NETPKT_FLAG_L4_CSUM_OK) ){
+		if( nettcp_checksum(pkt,NETPKT_LENGTH(pkt),src_addr,dst_addr) ) return -1;
+	}
+	return 0;
+}
+
+/*
+ * Turns the segment into the response: Trims the options and the payload,
+ * reverses the ports, fills in the header (with an MSS option, if 'mss' is
+ * non-0), and sends it back.
+ */
+static void nettcp_response_output(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *pkt, uint32_t seq, uint32_t ack, uint8_t flags, uint16_t window, uint16_t mss){
+	fnet_tcp_header_t  *hdr;
+	net_sockaddr_t     lcl, rmt;
+	uint8_t            *opt;
+	uint32_t           hlen;
+	uint16_t           port;
+	
+	/* The option is only added, if the segment's buffer has room for it. */
+	hlen = sizeof(fnet_tcp_header_t);
+	if( mss && (NETPKT_LENGTH(pkt) >= (hlen + FNET_TCP_OPT_MSS_LEN)) ) hlen += FNET_TCP_OPT_MSS_LEN;
+	
+	netpkt_setlength(pkt,hlen);
+	if( netpkt_pullup(pkt,hlen) ) goto DROP;
+	
+	hdr                   = netpkt_data(pkt);
+	port                  = hdr->source_port;
+	hdr->source_port      = hdr->destination_port;
+	hdr->destination_port = port;
+	hdr->sequence         = hton32(seq);
+	hdr->ack_number       = hton32(ack);
+	FNET_TCP_SET_HDR_LENGTH(hdr,hlen);
+	hdr->flags            = flags;
+	hdr->window           = hton16(window);
+	hdr->checksum         = 0;
+	hdr->urgent_ptr       = 0;
+	
+	if( hlen > sizeof(fnet_tcp_header_t) ){
+		opt = (uint8_t*)(hdr+1);
+		opt[0] = FNET_TCP_OPT_MSS;
+		opt[1] = FNET_TCP_OPT_MSS_LEN;
+		opt[2] = (uint8_t)(mss >> 8);
+		opt[3] = (uint8_t)mss;
+	}
+	
+	lcl = *dst_addr;
+	rmt = *src_addr;
+	hdr->checksum = nettcp_checksum(pkt,hlen,&lcl,&rmt);
+	
+	pkt->flags = 0;
+	netprot_ip_output(nif,pkt,IP_PROTOCOL_TCP,&lcl,&rmt,0,0);
+	return;
+DROP:
+	netpkt_free(pkt);
+}
 
 void nettcp_sendrst(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *reused_pkt){
-	if(reused_pkt) netpkt_free(reused_pkt);
+	fnet_tcp_header_t  *hdr;
+	uint32_t           seq, ack, seglen;
+	uint8_t            flags;
+	
+	if(! reused_pkt ) return;
+	if(! nif->tcp ) goto DROP;
+	
+	if( nettcp_response_check(nif,src_addr,dst_addr,reused_pkt) ) goto DROP;
+	
+	if( nettcp_rst_ratelimit(nif->tcp) ){
+		net_atomic_fetch_add(&(nif->tcp->rst_limited),1);
+		goto DROP;
+	}
+	
+	/*
+	 * RFC 793 3.4: If the incoming segment has an ACK field, the reset takes
+	 * its sequence number from the ACK field of the segment, otherwise the
+	 * reset has sequence number zero and the ACK field is set to the sum of
+	 * the sequence number and segment length of the incoming segment.
+	 */
+	hdr = netpkt_data(reused_pkt);
+	if( hdr->flags & FNET_TCP_SGT_ACK ){
+		seq   = ntoh32(hdr->ack_number);
+		ack   = 0;
+		flags = FNET_TCP_SGT_RST;
+	}else{
+		seglen = NETPKT_LENGTH(reused_pkt) - FNET_TCP_HDR_LENGTH(hdr);
+		if( hdr->flags & FNET_TCP_SGT_SYN ) seglen++;
+		if( hdr->flags & FNET_TCP_SGT_FIN ) seglen++;
+		seq   = 0;
+		ack   = ntoh32(hdr->sequence) + seglen;
+		flags = FNET_TCP_SGT_RST|FNET_TCP_SGT_ACK;
+	}
+	
+	net_atomic_fetch_add(&(nif->tcp->rst_sent),1);
+	nettcp_response_output(nif,src_addr,dst_addr,reused_pkt,seq,ack,flags,0,0);
+	return;
+DROP:
+	netpkt_free(reused_pkt);
+}
+
+void nettcp_sendsynack(netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, netpkt_t *reused_pkt, uint32_t iss, uint16_t window){
+	fnet_tcp_header_t  *hdr;
+	
+	if( nettcp_response_check(nif,src_addr,dst_addr,reused_pkt) ) goto DROP;
+	
+	hdr = netpkt_data(reused_pkt);
+	if( (hdr->flags & (FNET_TCP_SGT_SYN|FNET_TCP_SGT_ACK)) != FNET_TCP_SGT_SYN ) goto DROP;
+	
+	nettcp_response_output(nif,src_addr,dst_addr,reused_pkt,iss,ntoh32(hdr->sequence)+1,FNET_TCP_SGT_SYN|FNET_TCP_SGT_ACK,window,nettcp_mss(nif,dst_addr->type));
+	return;
+DROP:
+	netpkt_free(reused_pkt);
 }
 
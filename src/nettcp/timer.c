@@ -0,0 +1,115 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <nettcp/timer.h>
+#include <nettcp/tcb.h>
+#include <nettcp/if.h>
+#include <nettcp/output.h>
+#include <netsock/hashtab.h>
+#include <netstd/atomic.h>
+
+/*
+ * RFC 6298 5.4 - 5.7 and RFC 5681 3.1: A retransmission timeout.
+ */
+static void nettcp_rexmt_timeout(nettcp_tcb_t *tcb, net_time_t now){
+	/*
+	 * Persist timer: Probe a zero window with one byte. The probes back off,
+	 * but never cause the connection to be dropped.
+	 */
+	if( (tcb->snd_una == tcb->snd_max) && (tcb->snd_wnd == 0) ){
+		tcb->rexmt_time = 0;
+		if(! tcb->snd_len ) return;
+		tcb->flags |= NETTCP_TF_FORCE;
+		nettcp_output(tcb);
+		if( tcb->rexmt_shift < NETTCP_REXMT_MAX ) tcb->rexmt_shift++;
+		tcb->rexmt_time = now + ( (tcb->rto << tcb->rexmt_shift) < NETTCP_RTO_MAX ? (tcb->rto << tcb->rexmt_shift) : NETTCP_RTO_MAX );
+		return;
+	}
+	
+	if( ++(tcb->rexmt_shift) > NETTCP_REXMT_MAX ){
+		nettcp_output_rst(tcb);
+		nettcp_tcb_close(tcb,NETTCP_ERR_TIMEOUT);
+		return;
+	}
+	
+	/* RFC 6298 5.5: Back off the timer. */
+	tcb->rto <<= 1;
+	if( tcb->rto > NETTCP_RTO_MAX ) tcb->rto = NETTCP_RTO_MAX;
+	
+	/* RFC 5681 3.1: The module reduces the window (for NewReno, to 1 SMSS). */
+	tcb->cc->loss(tcb,NETTCP_CC_LOSS_RTO);
+	tcb->recover    = tcb->snd_max;
+	tcb->dupacks    = 0;
+	
+	/* Go back to snd_una; nettcp_output() restarts the timer. */
+	tcb->snd_nxt    = tcb->snd_una;
+	tcb->rtt_active = 0;
+	tcb->rexmt_time = 0;
+	nettcp_output(tcb);
+	
+	net_atomic_fetch_add(&(tcb->nif->tcp->retransmits),1);
+}
+
+void nettcp_timer(netif_t *nif){
+	nettcp_if_t  *tif = nif->tcp;
+	nettcp_tcb_t *tcb, *snap = 0;
+	net_time_t   now;
+	
+	if(! tif ) return;
+	
+	/*
+	 * Take a snapshot of the connections, each with a reference, so they can
+	 * be processed without holding the list lock (Lock order: connection, then
+	 * list).
+	 */
+	net_mutex_lock(tif->lock);
+	for( tcb = tif->tcbs ; tcb ; tcb = tcb->tnext ){
+		netsock_incr_flow(nif->sockets,&(tcb->flow));
+		tcb->tsnap = snap;
+		snap = tcb;
+	}
+	net_mutex_unlock(tif->lock);
+	
+	now = net_timer_ms();
+	
+	while( (tcb = snap) ){
+		snap = tcb->tsnap;
+		
+		net_mutex_lock(tcb->lock);
+		switch(tcb->state){
+		case NETTCP_CLOSED:
+		case NETTCP_LISTEN:
+			break;
+		case NETTCP_TIME_WAIT:
+			if( tcb->tw_time <= now ) nettcp_tcb_close(tcb,NETTCP_ERR_NONE);
+			break;
+		default:
+			if( (tcb->flags & NETTCP_TF_DELACK) && (tcb->delack_time <= now) ){
+				tcb->flags |= NETTCP_TF_ACKNOW;
+				nettcp_output(tcb);
+			}
+			if( tcb->rexmt_time && (tcb->rexmt_time <= now) )
+				nettcp_rexmt_timeout(tcb,now);
+			
+			/* Resume the data, that has been held back by the pacing. */
+			if( tcb->flags & NETTCP_TF_PACED )
+				nettcp_output(tcb);
+		}
+		net_mutex_unlock(tcb->lock);
+		
+		nettcp_tcb_release(tcb);
+	}
+}
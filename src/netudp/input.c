@@ -14,11 +14,145 @@
  *   limitations under the License.
  */
 #include <netudp/input.h>
+#include <netudp/udp_header.h>
+#include <netudp/socket.h>
 #include <netsock/hashtab.h>
+#include <netprot/checksum.h>
+#include <netprot/defaults.h>
+#include <netstd/endianness.h>
+#include <netstd/atomic.h>
+
+/*
+ * Strips the (verified) header and enqueues the datagram into the socket.
+ * Releases the flow.
+ */
+static void netudp_deliver(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, netudp_sock_t *sock, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	/*
+	 * Remember the current offset in the packet.
+	 */
+	if( netpkt_levelup(pkt) ) goto DROP;
+	
+	if( netpkt_pullfront(pkt,sizeof(fnet_udp_header_t)) ) goto DROP;
+	
+	if( netudp_sock_enqueue(sock,pkt,src_addr,dst_addr) ){
+		net_atomic_fetch_add(&sock->rx_drops,1);
+		goto DROP;
+	}
+	
+	netsock_decr_flow(nif->sockets,flow);
+	return;
+DROP:
+	netsock_decr_flow(nif->sockets,flow);
+	netpkt_free(pkt);
+}
 
 void netudp_input(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	fnet_udp_header_t  *hdr;
+	netudp_sock_t      *sock;
+	uint32_t           pkt_length;
+	uint32_t           length;
+	uint16_t           sum;
+	
+	sock = flow->instance;
+	if(! sock ) goto DROP;
+	
+	/* The header must reside in contiguous area of memory. */
+	if( netpkt_pullup(pkt,sizeof(fnet_udp_header_t)) ) goto ERROR;
+	
+	hdr        = netpkt_data(pkt);
+	pkt_length = NETPKT_LENGTH(pkt);
+	length     = ntoh16(hdr->length);
+	
+	/*
+	 * RFC 2675 4: A UDP Length of zero indicates a jumbogram, whose length is
+	 * that of the IPv6 payload.
+	 */
+	if( (length == 0) && (src_addr->type == NET_SKA_IN6) && (pkt_length > 0xffffu) )
+		length = pkt_length;
+	
+	/*
+	 * RFC 768: Length is the length in octets of this user datagram including
+	 * this header and the data.
+	 */
+	if( (length < sizeof(fnet_udp_header_t)) || (length > pkt_length) ) goto ERROR;
+	
+	if( length < pkt_length ) netpkt_setlength(pkt,length);
+	
+	/*
+	 * Skip the checksum, if the interface has already verified it.
+	 *
+	 * RFC 768: An all zero transmitted checksum value means that the
+	 * transmitter generated no checksum. RFC 8200 8.1: Unlike IPv4, the
+	 * default behavior when UDP packets are originated by an IPv6 node is
+	 * that the UDP checksum is not optional.
+	 */
+	if(! (pkt->flags & NETPKT_FLAG_L4_CSUM_OK) ){
+		if( (hdr->checksum != 0) || (src_addr->type == NET_SKA_IN6) ){
+			sum = netprot_checksum_pseudo_start(pkt,IP_PROTOCOL_UDP,length);
+			if( src_addr->type == NET_SKA_IN6 )
+				sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v6), (uint8_t*)&(dst_addr->ip.v6), sizeof(ipv6_addr_t));
+			else
+				sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v4), (uint8_t*)&(dst_addr->ip.v4), sizeof(ipv4_addr_t));
+			if( sum ) goto ERROR;
+		}
+	}
+	
+	netudp_deliver(nif,pkt,flow,sock,src_addr,dst_addr);
+	return;
+ERROR:
+	net_atomic_fetch_add(&sock->rx_errors,1);
+DROP:
 	netsock_decr_flow(nif->sockets,flow);
 	netpkt_free(pkt);
 }
 
+void netudplite_input(netif_t *nif,netpkt_t *pkt, netsock_flow_t *flow, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	fnet_udp_header_t  *hdr;
+	netudp_sock_t      *sock;
+	uint32_t           length;
+	uint32_t           coverage;
+	uint16_t           sum;
+	
+	sock = flow->instance;
+	if(! sock ) goto DROP;
+	
+	/* The header must reside in contiguous area of memory. */
+	if( netpkt_pullup(pkt,sizeof(fnet_udp_header_t)) ) goto ERROR;
+	
+	hdr      = netpkt_data(pkt);
+	
+	/* RFC 3828 3.2: The length of the datagram is taken from the IP layer. */
+	length   = NETPKT_LENGTH(pkt);
+	
+	/*
+	 * RFC 3828 3.1: A Checksum Coverage of zero indicates that the entire
+	 * datagram is covered. Values of 1 to 7 and values greater than the
+	 * datagram length are illegal; such datagrams MUST be discarded.
+	 */
+	coverage = ntoh16(hdr->length);
+	if( coverage == 0 ) coverage = length;
+	if( (coverage < sizeof(fnet_udp_header_t)) || (coverage > length) ) goto ERROR;
+	
+	/*
+	 * RFC 3828 3.1: Unlike UDP, the checksum is not optional: a checksum of
+	 * zero is not special, and the pseudo-header carries the IP payload
+	 * length.
+	 */
+	if(! (pkt->flags & NETPKT_FLAG_L4_CSUM_OK) ){
+		sum = netprot_checksum_pseudo_start_cov(pkt,IP_PROTOCOL_UDPLITE,length,coverage);
+		if( src_addr->type == NET_SKA_IN6 )
+			sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v6), (uint8_t*)&(dst_addr->ip.v6), sizeof(ipv6_addr_t));
+		else
+			sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v4), (uint8_t*)&(dst_addr->ip.v4), sizeof(ipv4_addr_t));
+		if( sum ) goto ERROR;
+	}
+	
+	netudp_deliver(nif,pkt,flow,sock,src_addr,dst_addr);
+	return;
+ERROR:
+	net_atomic_fetch_add(&sock->rx_errors,1);
+DROP:
+	netsock_decr_flow(nif->sockets,flow);
+	netpkt_free(pkt);
+}
 
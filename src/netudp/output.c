@@ -0,0 +1,460 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netudp/output.h>
+#include <netudp/udp_header.h>
+#include <netipv4/defs.h>
+#include <netipv4/ipv4_header.h>
+#include <netipv4/ipv4_idents.h>
+#include <netipv4/ctrl.h>
+#include <netipv4/fib.h>
+#include <netipv6/defs.h>
+#include <netipv6/ipv6_header.h>
+#include <netipv6/if.h>
+#include <netipv6/fib.h>
+#include <netipv6/srcsel.h>
+#include <netif/ifapi.h>
+#include <netprot/output.h>
+#include <netprot/checksum.h>
+#include <netprot/defaults.h>
+#include <netstd/endianness.h>
+#include <netstd/mem.h>
+#include <netmem/allocpkt.h>
+
+static const netprot_opts_t netudp_defaults = {
+	.tos = 0,
+	.ttl = FNET_UDP_TTL,
+	.traf_cls = 0,
+	.hop_limit = 0,
+	.dont_fragment = 0,
+	.dont_route = 0,
+};
+
+/*
+ * Computes the UDP checksum over the packet (at the UDP header, with a zero
+ * checksum field) and the pseudo header. For UDP-Lite, only the first
+ * 'coverage' bytes of the packet are covered.
+ */
+static uint16_t netudp_checksum(netpkt_t *pkt, uint8_t protocol, uint32_t length, uint32_t coverage, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	uint16_t sum;
+	
+	sum = netprot_checksum_pseudo_start_cov(pkt,protocol,length,coverage);
+	if( dst_addr->type == NET_SKA_IN6 )
+		sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v6), (uint8_t*)&(dst_addr->ip.v6), sizeof(ipv6_addr_t));
+	else
+		sum = netprot_checksum_pseudo_end( sum, (uint8_t*)&(src_addr->ip.v4), (uint8_t*)&(dst_addr->ip.v4), sizeof(ipv4_addr_t));
+	
+	/*
+	 * RFC 768: If the computed checksum is zero, it is transmitted as all ones.
+	 * RFC 3828 3.1: The same applies to UDP-Lite.
+	 */
+	return sum ? sum : 0xffffu;
+}
+
+/*
+ * The value of the UDP-Lite Checksum Coverage field for a datagram of
+ * 'length' bytes. RFC 3828 3.1: A coverage, that is not smaller than the
+ * datagram, is sent as zero (entire datagram).
+ */
+static inline uint16_t netudplite_cscov(uint16_t cscov, uint32_t length){
+	return (cscov < length) ? cscov : 0;
+}
+
+/*
+ * The version of the FIB, that routes the address family.
+ */
+static inline uint32_t netudp_fib_seq(uint8_t type){
+	if( type == NET_SKA_IN6 )
+		return netipv6_fib ? netipv6_fib->seq : 0;
+	return netipv4_fib ? netipv4_fib->seq : 0;
+}
+
+/*
+ * (Re)builds the header template from the connect parameters. The template
+ * is only modified on success.
+ * Return 0 on success, non-0 on error.
+ */
+static int netudp_template_build(netudp_tx_template_t *tpl){
+	netudp_tx_template_t t;
+	fnet_ip_header_t     *ip;
+	fnet_ip6_header_t    *ip6;
+	fnet_udp_header_t    *udp;
+	int                  onlink;
+	
+	t = *tpl;
+	t.nif      = t.conn_nif;
+	t.src_addr = t.conn_src;
+	t.src_addr.type = t.dst_addr.type;
+	
+	/* Take the version first, so that a concurrent update causes a rebuild. */
+	t.fib_seq = netudp_fib_seq(t.dst_addr.type);
+	
+	net_bzero(t.hdr,sizeof(t.hdr));
+	
+	if( t.dst_addr.type == NET_SKA_IN ){
+		if( netipv4_route(&t.nif,t.dst_addr.ip.v4,&t.nexthop.v4,t.opts.dont_route) ) return -1;
+		
+		if( IP4_ADDR_IS_UNSPECIFIED(t.src_addr.ip.v4) )
+			t.src_addr.ip.v4 = netipv4_select_src_addr(t.nif,t.dst_addr.ip.v4);
+		
+		ip = (fnet_ip_header_t*)t.hdr;
+		ip->version__header_length = 0x45;
+		ip->tos                    = t.opts.tos;
+		ip->flags_fragment_offset  = hton16(t.opts.dont_fragment ? FNET_IP_DF : 0);
+		ip->ttl                    = t.opts.ttl;
+		ip->protocol               = t.protocol;
+		ip->source_addr            = t.src_addr.ip.v4;
+		ip->desination_addr        = t.dst_addr.ip.v4;
+		
+		/* Total Length and ID are patched in, when sending. */
+		t.ip_sum = netprot_checksum_buf((void*)ip,sizeof(fnet_ip_header_t));
+		t.ip_len = sizeof(fnet_ip_header_t);
+	}else{
+		onlink = netipv6_route(&t.nif,&(t.dst_addr.ip.v6),&t.nexthop.v6);
+		if( onlink < 0 ) return -1;
+		t.nh_onlink = (uint8_t)onlink;
+		
+		if( IP6_ADDR_IS_UNSPECIFIED(t.src_addr.ip.v6) ){
+			if(! netipv6_select_src_addr(t.nif,&(t.src_addr.ip.v6),&(t.dst_addr.ip.v6)) ) return -1;
+		}
+		
+		ip6 = (fnet_ip6_header_t*)t.hdr;
+		ip6->version__tclass  = (6 << 4) | (t.opts.traf_cls>>4);
+		ip6->tclass__flowl    = t.opts.traf_cls << 4;
+		ip6->next_header      = t.protocol;
+		ip6->hop_limit        = t.opts.hop_limit ? t.opts.hop_limit : t.nif->ipv6->hop_limit;
+		ip6->source_addr      = t.src_addr.ip.v6;
+		ip6->destination_addr = t.dst_addr.ip.v6;
+		
+		/* Payload Length is patched in, when sending. */
+		t.ip_len = sizeof(fnet_ip6_header_t);
+	}
+	
+	udp = (fnet_udp_header_t*)(t.hdr+t.ip_len);
+	udp->source_port      = t.src_addr.port;
+	udp->destination_port = t.dst_addr.port;
+	
+	*tpl = t;
+	return 0;
+}
+
+static void netudp_sendto_gen(netif_t *nif, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint8_t protocol, uint16_t cscov, const netprot_opts_t *opts){
+	fnet_udp_header_t  *hdr;
+	ipv4_addr_t        nexthop;
+	ipv6_addr_t        nexthop6;
+	uint32_t           length;
+	
+	if(! opts ) opts = &netudp_defaults;
+	
+	/*
+	 * The source address is part of the checksum, so the interface and the
+	 * source address must be known before the IP layer is reached.
+	 */
+	src_addr->type = dst_addr->type;
+	if( dst_addr->type == NET_SKA_IN ){
+		if( netipv4_route(&nif,dst_addr->ip.v4,&nexthop,opts->dont_route) ) goto DROP;
+		if( IP4_ADDR_IS_UNSPECIFIED(src_addr->ip.v4) )
+			src_addr->ip.v4 = netipv4_select_src_addr(nif,dst_addr->ip.v4);
+	}else{
+		if( (! nif) && ( (! netipv6_fib) || netipv6_fib_lookup(netipv6_fib,&(dst_addr->ip.v6),&nif,&nexthop6) ) ) goto DROP;
+		if( IP6_ADDR_IS_UNSPECIFIED(src_addr->ip.v6) ){
+			if(! netipv6_select_src_addr(nif,&(src_addr->ip.v6),&(dst_addr->ip.v6)) ) goto DROP;
+		}
+	}
+	
+	length = NETPKT_LENGTH(pkt) + sizeof(fnet_udp_header_t);
+	if( length > 0xffffu ) goto DROP;
+	
+	/* Construct UDP header. */
+	if( netpkt_leveldown(pkt) ) goto DROP;
+	
+	if( netpkt_pushfront( pkt, sizeof(fnet_udp_header_t) ) ) goto DROP;
+	
+	if( netpkt_pullup_lite( pkt, sizeof(fnet_udp_header_t) ) ) goto DROP;
+	
+	hdr = netpkt_data(pkt);
+	hdr->source_port      = src_addr->port;
+	hdr->destination_port = dst_addr->port;
+	hdr->checksum         = 0;
+	if( protocol == IP_PROTOCOL_UDPLITE ){
+		cscov = netudplite_cscov(cscov,length);
+		hdr->length   = hton16(cscov);
+		hdr->checksum = netudp_checksum(pkt,protocol,length,cscov ? cscov : length,src_addr,dst_addr);
+	}else{
+		hdr->length   = hton16((uint16_t)length);
+		hdr->checksum = netudp_checksum(pkt,protocol,length,length,src_addr,dst_addr);
+	}
+	
+	netprot_ip_output(nif,pkt,protocol,src_addr,dst_addr,0,opts);
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
+void netudp_sendto(netif_t *nif, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, const netprot_opts_t *opts){
+	netudp_sendto_gen(nif,pkt,src_addr,dst_addr,IP_PROTOCOL_UDP,0,opts);
+}
+
+void netudplite_sendto(netif_t *nif, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint16_t cscov, const netprot_opts_t *opts){
+	/* RFC 3828 3.1: Coverage values of 1 to 7 are illegal. */
+	if( cscov && (cscov < sizeof(fnet_udp_header_t)) ){
+		netpkt_free(pkt);
+		return;
+	}
+	netudp_sendto_gen(nif,pkt,src_addr,dst_addr,IP_PROTOCOL_UDPLITE,cscov,opts);
+}
+
+static int netudp_connect_gen(netudp_sock_t *sock, netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint8_t protocol, uint16_t cscov, const netprot_opts_t *opts){
+	netudp_tx_template_t *tpl = &(sock->tx);
+	
+	tpl->nif      = 0;
+	tpl->conn_nif = nif;
+	tpl->conn_src = *src_addr;
+	tpl->dst_addr = *dst_addr;
+	tpl->opts     = opts ? *opts : netudp_defaults;
+	tpl->protocol = protocol;
+	tpl->cscov    = cscov;
+	
+	return netudp_template_build(tpl);
+}
+
+int netudp_connect(netudp_sock_t *sock, netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, const netprot_opts_t *opts){
+	return netudp_connect_gen(sock,nif,src_addr,dst_addr,IP_PROTOCOL_UDP,0,opts);
+}
+
+int netudplite_connect(netudp_sock_t *sock, netif_t *nif, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr, uint16_t cscov, const netprot_opts_t *opts){
+	/* RFC 3828 3.1: Coverage values of 1 to 7 are illegal. */
+	if( cscov && (cscov < sizeof(fnet_udp_header_t)) ) return -1;
+	
+	return netudp_connect_gen(sock,nif,src_addr,dst_addr,IP_PROTOCOL_UDPLITE,cscov,opts);
+}
+
+void netudp_disconnect(netudp_sock_t *sock){
+	sock->tx.nif = 0;
+}
+
+/*
+ * Prepares the template for sending: Resolves the route again, if the FIB has
+ * changed. If that fails, the old route is kept, and the next send tries again.
+ * Return 0 on success, non-0 if the socket is not connected.
+ */
+static int netudp_tx_prepare(netudp_tx_template_t *tpl){
+	if(! tpl->nif ) return -1;
+	
+	if( tpl->fib_seq != netudp_fib_seq(tpl->dst_addr.type) )
+		netudp_template_build(tpl);
+	return 0;
+}
+
+/*
+ * Adds the UDP and IP headers from the template to a packet.
+ *
+ * If 'gso_size' is non-0, the packet is handed to the interface for
+ * segmentation: The headers describe a segment of 'gso_size' payload bytes,
+ * and the UDP checksum is left zero for the interface to fill in.
+ *
+ * Return 0 on success, non-0 on error. The packet is not freed.
+ */
+static int netudp_encap(netudp_tx_template_t *tpl, netpkt_t *pkt, uint16_t gso_size){
+	fnet_udp_header_t    *udp;
+	fnet_ip_header_t     *ip;
+	fnet_ip6_header_t    *ip6;
+	uint32_t             length;
+	uint32_t             total_length;
+	uint16_t             sum;
+	uint16_t             cscov;
+	
+	length       = (gso_size ? gso_size : NETPKT_LENGTH(pkt)) + sizeof(fnet_udp_header_t);
+	total_length = length + tpl->ip_len;
+	
+	/* The IPv4 Total Length, or the IPv6 Payload Length, must fit. */
+	if( ((tpl->dst_addr.type == NET_SKA_IN) ? total_length : length) > 0xffffu ) return -1;
+	
+	if( total_length > tpl->nif->netif_mtu ) return -1;
+	
+	/* UDP header. */
+	if( netpkt_leveldown(pkt) ) return -1;
+	
+	if( netpkt_pushfront( pkt, sizeof(fnet_udp_header_t) ) ) return -1;
+	
+	if( netpkt_pullup_lite( pkt, sizeof(fnet_udp_header_t) ) ) return -1;
+	
+	udp = netpkt_data(pkt);
+	memcpy(udp,tpl->hdr+tpl->ip_len,sizeof(fnet_udp_header_t));
+	if( tpl->protocol == IP_PROTOCOL_UDPLITE ){
+		cscov = netudplite_cscov(tpl->cscov,length);
+		udp->length   = hton16(cscov);
+		udp->checksum = netudp_checksum(pkt,tpl->protocol,length,cscov ? cscov : length,&(tpl->src_addr),&(tpl->dst_addr));
+	}else{
+		udp->length   = hton16((uint16_t)length);
+		if(! gso_size )
+			udp->checksum = netudp_checksum(pkt,tpl->protocol,length,length,&(tpl->src_addr),&(tpl->dst_addr));
+	}
+	
+	/* IP header. */
+	if( netpkt_leveldown(pkt) ) return -1;
+	
+	if( netpkt_pushfront( pkt, tpl->ip_len ) ) return -1;
+	
+	if( netpkt_pullup_lite( pkt, tpl->ip_len ) ) return -1;
+	
+	memcpy(netpkt_data(pkt),tpl->hdr,tpl->ip_len);
+	
+	if( tpl->dst_addr.type == NET_SKA_IN ){
+		ip = netpkt_data(pkt);
+		ip->total_length = hton16((uint16_t)total_length);
+		sum = netprot_checksum_update16(tpl->ip_sum,0,ip->total_length);
+		
+		/* When the don't fragment flag is being set, the ID stays zero. */
+		if(! (ip->flags_fragment_offset & hton16(FNET_IP_DF)) ){
+			ip->id = hton16(netipv4_next_id(tpl->nif,tpl->src_addr.ip.v4,tpl->dst_addr.ip.v4));
+			sum = netprot_checksum_update16(sum,0,ip->id);
+		}
+		ip->checksum = sum;
+	}else{
+		ip6 = netpkt_data(pkt);
+		ip6->length = hton16((uint16_t)length);
+		if( tpl->nh_onlink )
+			pkt->flags |= NETPKT_FLAG_NH_ONLINK;
+		else
+			pkt->flags &= ~NETPKT_FLAG_NH_ONLINK;
+	}
+	return 0;
+}
+
+void netudp_send(netudp_sock_t *sock, netpkt_t *pkt){
+	netudp_tx_template_t *tpl = &(sock->tx);
+	
+	if( netudp_tx_prepare(tpl) ) goto DROP;
+	
+	if( netudp_encap(tpl,pkt,0) ) goto DROP;
+	
+	if( tpl->dst_addr.type == NET_SKA_IN )
+		tpl->nif->netif_class->ifapi_send_l3_ipv4(tpl->nif,pkt,&(tpl->nexthop.v4));
+	else
+		tpl->nif->netif_class->ifapi_send_l3_ipv6(tpl->nif,pkt,&(tpl->src_addr.ip.v6),&(tpl->nexthop.v6));
+	return;
+DROP:
+	netpkt_free(pkt);
+}
+
+uint32_t netudp_send_batch(netudp_sock_t *sock, netpkt_t **pkts, uint32_t n){
+	netudp_tx_template_t *tpl = &(sock->tx);
+	netpkt_t             *chain, **tail;
+	uint32_t             i, sent;
+	
+	if( netudp_tx_prepare(tpl) ){
+		for(i = 0 ; i < n ; ++i)
+			netpkt_free(pkts[i]);
+		return 0;
+	}
+	
+	/*
+	 * All datagrams share the route and the next hop, so they are linked into
+	 * one chain, that is resolved and sent as a whole.
+	 */
+	chain = 0;
+	tail  = &chain;
+	sent  = 0;
+	for(i = 0 ; i < n ; ++i){
+		if( netudp_encap(tpl,pkts[i],0) ){
+			netpkt_free(pkts[i]);
+			continue;
+		}
+		*tail = pkts[i];
+		tail  = &(pkts[i]->next_chain);
+		sent++;
+	}
+	*tail = 0;
+	
+	if(! chain ) return 0;
+	
+	if( tpl->dst_addr.type == NET_SKA_IN )
+		tpl->nif->netif_class->ifapi_send_l3_ipv4_all(tpl->nif,chain,&(tpl->nexthop.v4));
+	else
+		tpl->nif->netif_class->ifapi_send_l3_ipv6_all(tpl->nif,chain,&(tpl->src_addr.ip.v6),&(tpl->nexthop.v6));
+	return sent;
+}
+
+uint32_t netudp_send_gso(netudp_sock_t *sock, netpkt_t *pkt, uint16_t segsz){
+	netudp_tx_template_t *tpl = &(sock->tx);
+	netpkt_t             *chain, **tail, *seg;
+	uint32_t             length, off, n, sent;
+	
+	if( netudp_tx_prepare(tpl) ) goto DROP;
+	
+	if(! segsz ) goto DROP;
+	
+	length = NETPKT_LENGTH(pkt);
+	
+	/* A single segment is just a datagram. */
+	if( length <= segsz ){
+		netudp_send(sock,pkt);
+		return 1;
+	}
+	
+	if( (tpl->ip_len + sizeof(fnet_udp_header_t) + segsz) > tpl->nif->netif_mtu ) goto DROP;
+	
+	/*
+	 * The interface does the segmentation: The headers are built once, and
+	 * the payload is handed down as is.
+	 */
+	if( (tpl->nif->flags & NETIF_GSO_UDP) && (tpl->protocol == IP_PROTOCOL_UDP) ){
+		if( netudp_encap(tpl,pkt,segsz) ) goto DROP;
+		pkt->gso_size = segsz;
+		if( tpl->dst_addr.type == NET_SKA_IN )
+			tpl->nif->netif_class->ifapi_send_l3_ipv4(tpl->nif,pkt,&(tpl->nexthop.v4));
+		else
+			tpl->nif->netif_class->ifapi_send_l3_ipv6(tpl->nif,pkt,&(tpl->src_addr.ip.v6),&(tpl->nexthop.v6));
+		return (length + segsz - 1) / segsz;
+	}
+	
+	/*
+	 * Software segmentation: Slice the payload into datagrams, put the headers
+	 * from the template in front of each, and send them as one chain.
+	 */
+	chain = 0;
+	tail  = &chain;
+	sent  = 0;
+	for(off = 0 ; off < length ; off += n){
+		n = length - off;
+		if( n > segsz ) n = segsz;
+		
+		if(! (seg = netmem_alloc_pkt(n)) ) break;
+		
+		if( netpkt_copyout(pkt,off,netpkt_data(seg),n) || netudp_encap(tpl,seg,0) ){
+			netpkt_free(seg);
+			break;
+		}
+		*tail = seg;
+		tail  = &(seg->next_chain);
+		sent++;
+	}
+	*tail = 0;
+	
+	netpkt_free(pkt);
+	
+	if(! chain ) return 0;
+	
+	if( tpl->dst_addr.type == NET_SKA_IN )
+		tpl->nif->netif_class->ifapi_send_l3_ipv4_all(tpl->nif,chain,&(tpl->nexthop.v4));
+	else
+		tpl->nif->netif_class->ifapi_send_l3_ipv6_all(tpl->nif,chain,&(tpl->src_addr.ip.v6),&(tpl->nexthop.v6));
+	return sent;
+DROP:
+	netpkt_free(pkt);
+	return 0;
+}
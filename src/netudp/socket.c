@@ -0,0 +1,128 @@
+/*
+ *   Copyright 2016 Simon Schmidt
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <netudp/socket.h>
+#include <netstd/atomic.h>
+
+#define RING_MASK (NETUDP_RX_RING_SIZE-1)
+
+void netudp_sock_init(netudp_sock_t *sock){
+	uint32_t i;
+	
+	sock->rx.head = 0;
+	sock->rx.tail = 0;
+	for(i = 0 ; i < NETUDP_RX_RING_SIZE ; ++i){
+		sock->rx.slots[i].seq = i;
+		sock->rx.slots[i].pkt = 0;
+	}
+	sock->tx.nif    = 0;
+	sock->rx_drops  = 0;
+	sock->rx_errors = 0;
+}
+
+int netudp_sock_enqueue(netudp_sock_t *sock, netpkt_t *pkt, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	netudp_ring_slot_t *slot;
+	uint32_t pos,seq;
+	int32_t dif;
+	
+	pos = sock->rx.head;
+	for(;;){
+		slot = &sock->rx.slots[pos & RING_MASK];
+		seq = slot->seq;
+		net_memory_barrier();
+		dif = (int32_t)(seq - pos);
+		
+		/* The slot is free; try to claim it. */
+		if( dif == 0 ){
+			if( net_atomic_cas(&sock->rx.head,pos,pos+1) ) break;
+		}
+		
+		/* The slot still holds the datagram from the previous round: full. */
+		else if( dif < 0 ) return -1;
+		
+		pos = sock->rx.head;
+	}
+	
+	slot->pkt      = pkt;
+	slot->src_addr = *src_addr;
+	slot->dst_addr = *dst_addr;
+	
+	/* Publish the slot to the consumer. */
+	net_memory_barrier();
+	slot->seq = pos+1;
+	return 0;
+}
+
+netpkt_t* netudp_sock_dequeue(netudp_sock_t *sock, net_sockaddr_t *src_addr, net_sockaddr_t *dst_addr){
+	netudp_ring_slot_t *slot;
+	netpkt_t *pkt;
+	uint32_t pos;
+	
+	pos  = sock->rx.tail;
+	slot = &sock->rx.slots[pos & RING_MASK];
+	
+	/* Not yet published. */
+	if( slot->seq != (pos+1) ) return 0;
+	net_memory_barrier();
+	
+	pkt = slot->pkt;
+	if( src_addr ) *src_addr = slot->src_addr;
+	if( dst_addr ) *dst_addr = slot->dst_addr;
+	slot->pkt = 0;
+	
+	/* Hand the slot back to the producers, for the next round. */
+	net_memory_barrier();
+	slot->seq = pos+NETUDP_RX_RING_SIZE;
+	sock->rx.tail = pos+1;
+	return pkt;
+}
+
+uint32_t netudp_sock_dequeue_batch(netudp_sock_t *sock, netudp_msg_t *msgs, uint32_t max){
+	netudp_ring_slot_t *slot;
+	uint32_t pos,i;
+	
+	pos = sock->rx.tail;
+	
+	/* Count the published slots in a row. */
+	for(i = 0 ; i < max ; ++i){
+		if( sock->rx.slots[(pos+i) & RING_MASK].seq != (pos+i+1) ) break;
+	}
+	if(! i ) return 0;
+	net_memory_barrier();
+	
+	for(max = i, i = 0 ; i < max ; ++i){
+		slot = &sock->rx.slots[(pos+i) & RING_MASK];
+		msgs[i].pkt      = slot->pkt;
+		msgs[i].src_addr = slot->src_addr;
+		msgs[i].dst_addr = slot->dst_addr;
+		slot->pkt = 0;
+	}
+	
+	/* Hand the slots back to the producers, for the next round. */
+	net_memory_barrier();
+	for(i = 0 ; i < max ; ++i)
+		sock->rx.slots[(pos+i) & RING_MASK].seq = pos+i+NETUDP_RX_RING_SIZE;
+	sock->rx.tail = pos+max;
+	return max;
+}
+
+void netudp_sock_flush(netudp_sock_t *sock){
+	netpkt_t *pkt;
+	
+	while( (pkt = netudp_sock_dequeue(sock,0,0)) )
+		netpkt_free(pkt);
+}
+